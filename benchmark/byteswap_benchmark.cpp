@@ -0,0 +1,149 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <numeric>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "message.h"
+#include "util/bit.h"
+
+namespace {
+
+std::vector<int> MakeInts(std::size_t size)
+{
+    std::vector<int> values(size);
+    std::iota(std::begin(values), std::end(values), 0);
+
+    return values;
+}
+
+// Previous path : copy into a stack-backed pmr vector, transform, then copy out
+void BM_HtonTransform(benchmark::State& state)
+{
+    const auto values = MakeInts(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> buffer(std::size(values) * sizeof(int));
+
+    for (auto _ : state) {
+        std::array<std::byte, 1024 * sizeof(int)> stack_buffer;
+        std::pmr::monotonic_buffer_resource mbr { std::data(stack_buffer), std::size(stack_buffer) };
+        std::pmr::vector<int> copy { std::cbegin(values), std::cend(values), &mbr };
+
+        std::transform(std::begin(copy), std::end(copy), std::begin(copy), bit::hton<int>);
+        std::memcpy(std::data(buffer), std::data(copy), std::size(buffer));
+
+        benchmark::DoNotOptimize(std::data(buffer));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+void BM_HtonN(benchmark::State& state)
+{
+    const auto values = MakeInts(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> buffer(std::size(values) * sizeof(int));
+
+    for (auto _ : state) {
+        bit::hton_n(std::data(values), std::size(values), std::data(buffer));
+
+        benchmark::DoNotOptimize(std::data(buffer));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Previous path : assign from the buffer, then transform in place
+void BM_NtohTransform(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint8_t> buffer(size * sizeof(int));
+
+    for (auto _ : state) {
+        std::vector<int> values;
+        const auto* ptr = reinterpret_cast<const int*>(std::data(buffer));
+
+        values.reserve(size);
+        values.assign(ptr, ptr + size);
+        std::transform(std::begin(values), std::end(values), std::begin(values), bit::ntoh<int>);
+
+        benchmark::DoNotOptimize(std::data(values));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+void BM_NtohN(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint8_t> buffer(size * sizeof(int));
+
+    for (auto _ : state) {
+        std::vector<int> values(size);
+        bit::ntoh_n(std::data(buffer), size, std::data(values));
+
+        benchmark::DoNotOptimize(std::data(values));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+template <bit::detail::byteswap_n_t Kernel>
+void BM_Kernel(benchmark::State& state)
+{
+    const auto values = MakeInts(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> buffer(std::size(values) * sizeof(int));
+
+    for (auto _ : state) {
+        Kernel(reinterpret_cast<const std::uint8_t*>(std::data(values)), std::size(values), std::data(buffer));
+
+        benchmark::DoNotOptimize(std::data(buffer));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+void BM_SerializeIntArray(benchmark::State& state)
+{
+    Message msg { 0, MakeInts(static_cast<std::size_t>(state.range(0))) };
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Message::Serialize(msg));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(int)));
+}
+
+void BM_DeserializeIntArray(benchmark::State& state)
+{
+    const auto buffer = Message::Serialize(Message { 0, MakeInts(static_cast<std::size_t>(state.range(0))) });
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Message::Deserialize(buffer));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(int)));
+}
+
+} // namespace
+
+BENCHMARK(BM_HtonTransform)->RangeMultiplier(8)->Range(64, 1 << 16);
+BENCHMARK(BM_HtonN)->RangeMultiplier(8)->Range(64, 1 << 16);
+BENCHMARK(BM_NtohTransform)->RangeMultiplier(8)->Range(64, 1 << 16);
+BENCHMARK(BM_NtohN)->RangeMultiplier(8)->Range(64, 1 << 16);
+
+BENCHMARK_TEMPLATE(BM_Kernel, bit::detail::byteswap_n_scalar<4>)->Range(64, 1 << 16);
+#ifdef BIT_X86
+BENCHMARK_TEMPLATE(BM_Kernel, bit::detail::byteswap_n_ssse3<4>)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(BM_Kernel, bit::detail::byteswap_n_avx2<4>)->Range(64, 1 << 16);
+#endif
+
+BENCHMARK(BM_SerializeIntArray)->RangeMultiplier(8)->Range(64, 1 << 16);
+BENCHMARK(BM_DeserializeIntArray)->RangeMultiplier(8)->Range(64, 1 << 16);
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "util/mailbox.h"
+#include "util/spin.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMessagesPerIteration { 1 << 16 };
+
+struct Node {
+    std::atomic<Node*> next { nullptr };
+    std::uint64_t value { 0 };
+};
+
+// Strand queue before Mailbox, a deque and scheduled flag under one mutex
+class LockedMailbox {
+public:
+    bool Push(Node* node)
+    {
+        std::lock_guard lock { mutex_ };
+
+        nodes_.push_back(node);
+
+        return !std::exchange(scheduled_, true);
+    }
+
+    Node* Pop()
+    {
+        std::lock_guard lock { mutex_ };
+
+        if (nodes_.empty())
+            return nullptr;
+
+        auto* node = nodes_.front();
+        nodes_.pop_front();
+
+        return node;
+    }
+
+private:
+    std::deque<Node*> nodes_;
+    bool scheduled_ { false };
+    std::mutex mutex_;
+};
+
+// Args : producers
+//  - Each iteration pushes kMessagesPerIteration nodes spread over the producers, one consumer pops them all
+//  - The consumer polls instead of parking, so only the queue itself is measured
+template <typename Queue>
+void BM_MailboxThroughput(benchmark::State& state)
+{
+    const auto producer_count = static_cast<std::size_t>(state.range(0));
+
+    std::vector<Node> nodes(kMessagesPerIteration);
+    std::uint64_t expected = 0;
+
+    for (auto _ : state) {
+        Queue queue;
+        std::atomic_bool start { false };
+        std::vector<std::thread> producers;
+
+        for (std::size_t p = 0; p < producer_count; ++p) {
+            producers.emplace_back([&, p] {
+                while (!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for (auto i = p; i < kMessagesPerIteration; i += producer_count) {
+                    nodes[i].value = i;
+                    queue.Push(&nodes[i]);
+                }
+            });
+        }
+
+        std::uint64_t sum = 0;
+        std::size_t popped = 0;
+        std::size_t idle = 0;
+
+        const auto begin = Clock::now();
+        start.store(true, std::memory_order_release);
+
+        while (popped < kMessagesPerIteration) {
+            if (auto* node = queue.Pop()) {
+                sum += node->value;
+                ++popped;
+                idle = 0;
+            } else if (++idle < 64) {
+                SpinPause();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        state.SetIterationTime(std::chrono::duration<double>(Clock::now() - begin).count());
+        benchmark::DoNotOptimize(sum);
+
+        for (auto& producer : producers)
+            producer.join();
+
+        expected += kMessagesPerIteration;
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(expected));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_MailboxThroughput, LockedMailbox)
+    ->ArgName("producers")
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_MailboxThroughput, Mailbox<Node>)
+    ->ArgName("producers")
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
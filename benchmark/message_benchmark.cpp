@@ -0,0 +1,249 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "frame.h"
+#include "message.h"
+#include "message_schema.h"
+#include "message_view.h"
+
+namespace {
+
+enum Mix : std::int64_t {
+    // Eight integers of every width
+    kIntegers,
+    // Integers, a short string and a short int array
+    kMixed,
+    // One int array and one byte array of the given size
+    kArrays,
+};
+
+constexpr auto kV1 = static_cast<std::int64_t>(Message::Encoding::kV1);
+constexpr auto kV2 = static_cast<std::int64_t>(Message::Encoding::kV2);
+
+DEFINE_MESSAGE(MixedSchema, std::uint16_t, std::int32_t, std::uint64_t, std::string, std::vector<int>);
+
+std::vector<int> MakeInts(std::size_t size)
+{
+    std::vector<int> values(size);
+    std::iota(std::begin(values), std::end(values), 0);
+
+    return values;
+}
+
+// Deterministic content, so every run serializes the same bytes
+Message MakeMessage(Mix mix, std::size_t array_size)
+{
+    switch (mix) {
+    case kIntegers:
+        return Message { 1, true, 'c', std::int8_t { -8 }, std::uint8_t { 8 }, std::int16_t { -1600 }, std::uint16_t { 1600 }, std::int32_t { -320000 }, std::uint64_t { 1ULL << 40 } };
+    case kMixed:
+        return Message { 2, std::uint16_t { 7 }, std::int32_t { -42 }, std::uint64_t { 1ULL << 33 }, std::string(32, 'm'), MakeInts(16) };
+    default:
+        return Message { 3, MakeInts(array_size), std::vector<std::uint8_t>(array_size, 0xAB) };
+    }
+}
+
+MixedSchema MakeSchema()
+{
+    return { 7, -42, 1ULL << 33, std::string(32, 'm'), MakeInts(16) };
+}
+
+// Args : mix, encoding, array size
+void BM_Serialize(benchmark::State& state)
+{
+    const auto msg = MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2)));
+    const auto encoding = static_cast<Message::Encoding>(state.range(1));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Message::Serialize(msg, encoding));
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(Message::SerializedSize(msg, encoding)));
+}
+
+// Args : mix, encoding, array size
+//  - No allocation, buffer is reused
+void BM_SerializeTo(benchmark::State& state)
+{
+    const auto msg = MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2)));
+    const auto encoding = static_cast<Message::Encoding>(state.range(1));
+
+    std::vector<std::uint8_t> buffer(Message::SerializedSize(msg, encoding));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Message::SerializeTo(msg, std::data(buffer), std::size(buffer), encoding));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Args : mix, encoding, array size
+void BM_Deserialize(benchmark::State& state)
+{
+    const auto encoding = static_cast<Message::Encoding>(state.range(1));
+    const auto buffer = Message::Serialize(MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2))), encoding);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Message::Deserialize(buffer, encoding));
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Args : mix, encoding, array size
+//  - Arena is released every iteration, as a request-scoped resource would be
+void BM_DeserializeArena(benchmark::State& state)
+{
+    const auto encoding = static_cast<Message::Encoding>(state.range(1));
+    const auto buffer = Message::Serialize(MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2))), encoding);
+
+    std::vector<std::byte> storage(std::size(buffer) * 2 + 4096);
+
+    for (auto _ : state) {
+        std::pmr::monotonic_buffer_resource arena { std::data(storage), std::size(storage) };
+        benchmark::DoNotOptimize(Message::Deserialize(buffer, encoding, &arena));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Args : mix, encoding, array size
+void BM_ViewParse(benchmark::State& state)
+{
+    const auto encoding = static_cast<Message::Encoding>(state.range(1));
+    const auto buffer = Message::Serialize(MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2))), encoding);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MessageView::Parse(buffer, encoding));
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Args : mix, array size
+void BM_FrameRoundTrip(benchmark::State& state)
+{
+    const auto msg = MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    std::vector<std::uint8_t> buffer(Frame::SerializedSize(msg));
+
+    for (auto _ : state) {
+        Frame::SerializeTo(msg, std::data(buffer), std::size(buffer));
+        benchmark::DoNotOptimize(Frame::Deserialize(buffer));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+// Args : mix, shared, array size
+void BM_Copy(benchmark::State& state)
+{
+    auto msg = MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2)));
+
+    if (state.range(1) != 0)
+        msg.body.Share();
+
+    for (auto _ : state) {
+        auto copy = msg;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+// Args : mix, shared, array size
+//  - A shared body is encoded on the first call only
+void BM_SerializeShared(benchmark::State& state)
+{
+    auto msg = MakeMessage(static_cast<Mix>(state.range(0)), static_cast<std::size_t>(state.range(2)));
+
+    if (state.range(1) != 0)
+        msg.body.Share();
+
+    std::vector<std::uint8_t> buffer(Message::SerializedSize(msg));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Message::SerializeTo(msg, std::data(buffer), std::size(buffer)));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::size(buffer)));
+}
+
+void SharedArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "mix", "shared", "size" });
+
+    for (const auto shared : { 0, 1 }) {
+        b->Args({ kMixed, shared, 0 });
+        b->Args({ kArrays, shared, 1 << 16 });
+    }
+}
+
+// kMixed body built from values, as the dynamic counterpart of BM_SchemaSerialize
+void BM_DynamicSerialize(benchmark::State& state)
+{
+    const auto schema = MakeSchema();
+
+    for (auto _ : state) {
+        Message msg { 2, schema.Get<0>(), schema.Get<1>(), schema.Get<2>(), schema.Get<3>(), schema.Get<4>() };
+        benchmark::DoNotOptimize(Message::Serialize(msg));
+    }
+}
+
+void BM_SchemaSerialize(benchmark::State& state)
+{
+    const auto schema = MakeSchema();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(schema.Serialize());
+}
+
+void BM_SchemaDeserialize(benchmark::State& state)
+{
+    const auto buffer = MakeSchema().Serialize();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MixedSchema::Deserialize(buffer));
+}
+
+void ScalarArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "mix", "encoding", "size" });
+
+    for (const auto mix : { kIntegers, kMixed }) {
+        for (const auto encoding : { kV1, kV2 })
+            b->Args({ mix, encoding, 0 });
+    }
+
+    for (const auto encoding : { kV1, kV2 }) {
+        for (std::int64_t size = 16; size <= (1 << 16); size *= 16)
+            b->Args({ kArrays, encoding, size });
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_Serialize)->Apply(ScalarArgs);
+BENCHMARK(BM_SerializeTo)->Apply(ScalarArgs);
+BENCHMARK(BM_Deserialize)->Apply(ScalarArgs);
+BENCHMARK(BM_DeserializeArena)->Apply(ScalarArgs);
+BENCHMARK(BM_ViewParse)->Apply(ScalarArgs);
+
+BENCHMARK(BM_FrameRoundTrip)
+    ->ArgNames({ "mix", "size" })
+    ->Args({ kIntegers, 0 })
+    ->Args({ kMixed, 0 })
+    ->Args({ kArrays, 256 })
+    ->Args({ kArrays, 1 << 16 });
+
+BENCHMARK(BM_Copy)->Apply(SharedArgs);
+BENCHMARK(BM_SerializeShared)->Apply(SharedArgs);
+
+BENCHMARK(BM_DynamicSerialize);
+BENCHMARK(BM_SchemaSerialize);
+BENCHMARK(BM_SchemaDeserialize);
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+#include "util/histogram.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMessagesPerIteration { 1 << 16 };
+
+std::uint64_t Now()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// Post to delivery latency, one histogram per router worker
+class LatencyRecorder {
+public:
+    void Record(std::uint64_t latency)
+    {
+        // Keyed by id_, a later recorder may reuse this address
+        thread_local Histogram* histogram = nullptr;
+        thread_local std::uint64_t owner = 0;
+
+        if (owner != id_) {
+            std::lock_guard lock { mutex_ };
+
+            owner = id_;
+            histogram = histograms_.emplace_back(std::make_unique<Histogram>()).get();
+        }
+
+        histogram->Record(latency);
+    }
+
+    // Only once every recorded message is counted in delivered
+    Histogram Merge() const
+    {
+        std::lock_guard lock { mutex_ };
+
+        Histogram merged;
+
+        for (const auto& histogram : histograms_)
+            merged.Merge(*histogram);
+
+        return merged;
+    }
+
+private:
+    static inline std::atomic<std::uint64_t> next_id_ { 1 };
+
+    const std::uint64_t id_ { next_id_.fetch_add(1, std::memory_order_relaxed) };
+
+    std::vector<std::unique_ptr<Histogram>> histograms_;
+    mutable std::mutex mutex_;
+};
+
+struct Shared {
+    LatencyRecorder latency;
+    std::atomic<std::uint64_t> delivered { 0 };
+};
+
+struct Handler {
+    void Post(Message&& message)
+    {
+        std::uint64_t sent = 0;
+        message >> sent;
+
+        shared->latency.Record(Now() - sent);
+        shared->delivered.fetch_add(1, std::memory_order_release);
+
+        MessagePool::Release(std::move(message));
+    }
+
+    std::shared_ptr<Shared> shared;
+};
+
+// Args : producers, handlers
+//  - Each iteration posts kMessagesPerIteration messages spread over every handler
+//  - Time is measured from releasing the producers until the last delivery
+void BM_RouterThroughput(benchmark::State& state)
+{
+    const auto producer_count = static_cast<std::size_t>(state.range(0));
+    const auto handler_count = static_cast<std::size_t>(state.range(1));
+
+    auto& router = MessageRouter::GetInstance();
+    auto shared = std::make_shared<Shared>();
+
+    std::vector<Endpoint> endpoints;
+    endpoints.reserve(handler_count);
+
+    for (std::size_t i = 0; i < handler_count; ++i) {
+        endpoints.emplace_back("router_benchmark/" + std::to_string(i));
+        router.Register(endpoints.back(), Handler { shared });
+    }
+
+    std::uint64_t expected = 0;
+
+    for (auto _ : state) {
+        std::atomic_bool start { false };
+        std::vector<std::thread> producers;
+
+        for (std::size_t p = 0; p < producer_count; ++p) {
+            producers.emplace_back([&, p] {
+                while (!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for (auto i = p; i < kMessagesPerIteration; i += producer_count) {
+                    auto msg = MessagePool::Acquire();
+                    msg.to = endpoints[i % handler_count];
+                    msg << Now();
+
+                    router.Post(std::move(msg));
+                }
+            });
+        }
+
+        expected += kMessagesPerIteration;
+
+        const auto begin = Clock::now();
+        start.store(true, std::memory_order_release);
+
+        while (shared->delivered.load(std::memory_order_acquire) < expected)
+            std::this_thread::yield();
+
+        state.SetIterationTime(std::chrono::duration<double>(Clock::now() - begin).count());
+
+        for (auto& producer : producers)
+            producer.join();
+    }
+
+    for (const auto& endpoint : endpoints)
+        router.Unregister(endpoint);
+
+    const auto latency = shared->latency.Merge();
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(expected));
+    state.counters["p50_ns"] = static_cast<double>(latency.GetPercentile(50.0));
+    state.counters["p99_ns"] = static_cast<double>(latency.GetPercentile(99.0));
+    state.counters["p999_ns"] = static_cast<double>(latency.GetPercentile(99.9));
+}
+
+} // namespace
+
+BENCHMARK(BM_RouterThroughput)
+    ->ArgNames({ "producers", "handlers" })
+    ->ArgsProduct({ { 1, 8, 64 }, { 1, 100, 10000 } })
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "message.h"
+#include "socket_bridge.h"
+#include "util/histogram.h"
+
+namespace {
+
+enum Transport : std::int64_t {
+    kTcp,
+    kUnix,
+};
+
+// Upper bound of messages in flight for throughput runs, well below SocketSender::kMaxPendingSize
+constexpr std::uint64_t kWindow { 1 << 14 };
+
+struct Counter {
+    void Post(Message&&)
+    {
+        count->fetch_add(1, std::memory_order_release);
+    }
+
+    void PostBatch(Message* first, Message* last)
+    {
+        count->fetch_add(static_cast<std::uint64_t>(last - first), std::memory_order_release);
+    }
+
+    std::shared_ptr<std::atomic<std::uint64_t>> count;
+};
+
+// Sends every message back over the accepted connection
+struct Echo {
+    void Post(Message&& message)
+    {
+        peer->load(std::memory_order_acquire)->Post(std::move(message));
+    }
+
+    void PostBatch(Message* first, Message* last)
+    {
+        peer->load(std::memory_order_acquire)->PostBatch(first, last);
+    }
+
+    std::shared_ptr<std::atomic<SocketSender*>> peer;
+};
+
+// Client bridge connected to a server bridge over loopback
+class Loopback {
+public:
+    Loopback(Transport transport, MessageHandler server_sink, MessageHandler client_sink)
+        : server_ { std::move(server_sink) }
+        , client_ { std::move(client_sink) }
+    {
+        auto on_accept = [this](SocketSender sender) {
+            accepted_.emplace(std::move(sender));
+            peer_->store(&*accepted_, std::memory_order_release);
+        };
+
+        if (transport == kTcp) {
+            if (const auto port = server_.ListenTcp("127.0.0.1", 0, on_accept))
+                sender_ = client_.ConnectTcp("127.0.0.1", *port);
+        } else {
+            path_ = "/tmp/socket_benchmark_" + std::to_string(::getpid());
+            ::unlink(path_.c_str());
+
+            if (server_.ListenUnix(path_, on_accept))
+                sender_ = client_.ConnectUnix(path_);
+        }
+
+        while (sender_ && !peer_->load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    ~Loopback()
+    {
+        if (!path_.empty())
+            ::unlink(path_.c_str());
+    }
+
+    SocketSender* GetSender() { return sender_ ? &*sender_ : nullptr; }
+
+    // Set once the server has accepted, for Echo
+    std::shared_ptr<std::atomic<SocketSender*>> GetPeer() const { return peer_; }
+
+private:
+    std::shared_ptr<std::atomic<SocketSender*>> peer_ { std::make_shared<std::atomic<SocketSender*>>(nullptr) };
+    std::optional<SocketSender> accepted_;
+    std::string path_;
+
+    SocketBridge server_;
+    SocketBridge client_;
+    std::optional<SocketSender> sender_;
+};
+
+Message MakeMessage(std::size_t payload_size)
+{
+    Message msg { 1, std::uint32_t { 42 }, std::string(payload_size, 'x') };
+    msg.from = Endpoint { "client" };
+    msg.to = Endpoint { "server" };
+
+    return msg;
+}
+
+void WaitUntil(const std::atomic<std::uint64_t>& count, std::uint64_t target)
+{
+    while (count.load(std::memory_order_acquire) < target)
+        std::this_thread::yield();
+}
+
+// Args : transport, messages per PostBatch, string item size
+void BM_SocketThroughput(benchmark::State& state)
+{
+    const auto batch_size = static_cast<std::size_t>(state.range(1));
+    const auto payload_size = static_cast<std::size_t>(state.range(2));
+
+    auto received = std::make_shared<std::atomic<std::uint64_t>>(0);
+    Loopback loopback { static_cast<Transport>(state.range(0)), Counter { received }, Counter { std::make_shared<std::atomic<std::uint64_t>>(0) } };
+
+    auto* sender = loopback.GetSender();
+    if (!sender) {
+        state.SkipWithError("failed to connect");
+        return;
+    }
+
+    const auto prototype = MakeMessage(payload_size);
+    std::vector<Message> batch;
+    std::uint64_t sent = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        batch.assign(batch_size, prototype);
+        state.ResumeTiming();
+
+        sender->PostBatch(std::data(batch), std::data(batch) + std::size(batch));
+        sent += batch_size;
+
+        if (sent - received->load(std::memory_order_acquire) > kWindow)
+            WaitUntil(*received, sent - kWindow / 2);
+    }
+
+    WaitUntil(*received, sent);
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(sent));
+    state.SetBytesProcessed(static_cast<std::int64_t>(sent * payload_size));
+    state.counters["dropped"] = static_cast<double>(sender->GetDropCount());
+}
+
+// Args : transport, string item size
+//  - One message in flight, time is measured from Post to the echo arriving back
+void BM_SocketRoundTrip(benchmark::State& state)
+{
+    const auto payload_size = static_cast<std::size_t>(state.range(1));
+
+    auto peer = std::make_shared<std::atomic<SocketSender*>>(nullptr);
+    auto received = std::make_shared<std::atomic<std::uint64_t>>(0);
+    Loopback loopback { static_cast<Transport>(state.range(0)), Echo { peer }, Counter { received } };
+
+    peer->store(loopback.GetPeer()->load(std::memory_order_acquire), std::memory_order_release);
+
+    auto* sender = loopback.GetSender();
+    if (!sender) {
+        state.SkipWithError("failed to connect");
+        return;
+    }
+
+    const auto prototype = MakeMessage(payload_size);
+    Histogram latency;
+    std::uint64_t sent = 0;
+
+    for (auto _ : state) {
+        auto msg = prototype;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        sender->Post(std::move(msg));
+        WaitUntil(*received, ++sent);
+
+        latency.Record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+
+    state.counters["p50_ns"] = static_cast<double>(latency.GetPercentile(50.0));
+    state.counters["p99_ns"] = static_cast<double>(latency.GetPercentile(99.0));
+    state.counters["p999_ns"] = static_cast<double>(latency.GetPercentile(99.9));
+}
+
+} // namespace
+
+BENCHMARK(BM_SocketThroughput)
+    ->ArgNames({ "unix", "batch", "payload" })
+    ->ArgsProduct({ { kTcp, kUnix }, { 1, 16, 256 }, { 16, 1024 } })
+    ->UseRealTime();
+
+BENCHMARK(BM_SocketRoundTrip)
+    ->ArgNames({ "unix", "payload" })
+    ->ArgsProduct({ { kTcp, kUnix }, { 16, 1024 } })
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
\ No newline at end of file
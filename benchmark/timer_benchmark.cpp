@@ -0,0 +1,84 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "message.h"
+#include "util/timing_wheel.h"
+
+namespace {
+
+// Same shape as Timer::Schedule
+struct Schedule {
+    Endpoint handler_id;
+    std::uint16_t message_id { 0 };
+    std::uint64_t period { 0 };
+};
+
+// Periodic schedules with staggered first expiry, so each tick expires about count / period of them
+TimingWheel<Schedule> MakeWheel(std::size_t count, std::uint64_t period)
+{
+    TimingWheel<Schedule> wheel;
+    const Endpoint handler_id { "timer_benchmark" };
+
+    for (std::size_t i = 0; i < count; ++i)
+        wheel.Schedule({ handler_id, static_cast<std::uint16_t>(i), period }, i % period + 1);
+
+    return wheel;
+}
+
+// Args : schedules, period in ticks
+//  - Each iteration is one tick of Timer::Run without posting, expired schedules become Messages
+//  - Periods above 256 ticks go through cascading between wheel levels
+void BM_TimerTick(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const auto period = static_cast<std::uint64_t>(state.range(1));
+
+    auto wheel = MakeWheel(count, period);
+    std::vector<Message> expired;
+    std::uint64_t expired_count = 0;
+
+    for (auto _ : state) {
+        wheel.Tick([&expired](TimingWheel<Schedule>::Handle, const Schedule& schedule) {
+            auto& msg = expired.emplace_back(schedule.message_id);
+            msg.to = schedule.handler_id;
+
+            return schedule.period;
+        });
+
+        expired_count += std::size(expired);
+        expired.clear();
+    }
+
+    state.counters["expired_per_tick"] = benchmark::Counter(static_cast<double>(expired_count), benchmark::Counter::kAvgIterations);
+}
+
+// Args : schedules already in the wheel
+void BM_TimerScheduleCancel(benchmark::State& state)
+{
+    auto wheel = MakeWheel(static_cast<std::size_t>(state.range(0)), 1000);
+    const Endpoint handler_id { "timer_benchmark" };
+
+    std::uint64_t delay = 0;
+
+    for (auto _ : state) {
+        const auto handle = wheel.Schedule({ handler_id, 0, 0 }, ++delay % 100000 + 1);
+        benchmark::DoNotOptimize(wheel.Cancel(handle));
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_TimerTick)
+    ->ArgNames({ "schedules", "period" })
+    ->ArgsProduct({ { 1, 100, 10000, 1000000 }, { 1, 100, 10000 } });
+
+BENCHMARK(BM_TimerScheduleCancel)
+    ->ArgNames({ "schedules" })
+    ->RangeMultiplier(100)
+    ->Range(1, 1000000);
+
+BENCHMARK_MAIN();
\ No newline at end of file
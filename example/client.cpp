@@ -2,23 +2,24 @@
 
 #include <iostream>
 
+#include "../src/message_pool.h"
 #include "../src/message_router.h"
 
-Client::Client(std::string_view id)
+Client::Client(Endpoint id)
     : id_ { id }
-    , tasker_ { [this](auto message) { OnMessage(std::move(message)); } }
 {
-    MessageRouter::GetInstance().Register(id_, this);
+    MessageRouter::GetInstance().Register(id_, Handler { this });
 }
 
+// Returns once no delivery to this client is in flight
 Client::~Client()
 {
     MessageRouter::GetInstance().Unregister(id_);
 }
 
-void Client::Send(std::string_view dst, std::string_view chat)
+void Client::Send(Endpoint dst, std::string_view chat)
 {
-    Message msg;
+    auto msg = MessagePool::Acquire();
     msg.from = id_;
     msg.to = dst;
     msg << chat;
@@ -26,11 +27,6 @@ void Client::Send(std::string_view dst, std::string_view chat)
     MessageRouter::GetInstance().Post(std::move(msg));
 }
 
-void Client::Post(Message message)
-{
-    tasker_.Post(std::move(message));
-}
-
 void Client::OnMessage(Message message)
 {
     std::string chat;
@@ -38,4 +34,6 @@ void Client::OnMessage(Message message)
     message >> chat;
 
     std::cout << message.from << " -> " << message.to << " : " << chat << '\n';
+
+    MessagePool::Release(std::move(message));
 }
\ No newline at end of file
@@ -1,29 +1,30 @@
 #ifndef CLIENT_H_
 #define CLIENT_H_
 
-#include <string>
 #include <string_view>
+#include <utility>
 
-#include "../src/message_handler.h"
-#include "../src/util/tasker.h"
+#include "../src/endpoint.h"
+#include "../src/message.h"
 
-class Client : public MessageHandler<Client> {
+// Messages are delivered in order and one at a time on the client's strand, no thread is owned
+class Client {
 public:
-    Client(std::string_view id);
+    Client(Endpoint id);
     ~Client();
 
-    void Send(std::string_view dst, std::string_view chat);
+    void Send(Endpoint dst, std::string_view chat);
 
 private:
-    friend MessageHandler;
+    struct Handler {
+        void Post(Message&& message) { client->OnMessage(std::move(message)); }
 
-    void Post(Message message);
-    void OnMessage(Message message);
+        Client* client;
+    };
 
-    std::string id_;
+    void OnMessage(Message message);
 
-    // Need to release before other member variable
-    Tasker<Message> tasker_;
+    Endpoint id_;
 };
 
-#endif // CLIENT_H_
\ No newline at end of file
+#endif // CLIENT_H_
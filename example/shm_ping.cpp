@@ -0,0 +1,156 @@
+// Ping-pong between two processes over a pair of ShmRings
+//  - Rings are created before fork(), so both processes map the same segments
+//  - Each process registers a ShmSender for the other's endpoint and runs a ShmReceiver on its own ring
+
+#include <cstdint>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../src/message_pool.h"
+#include "../src/message_router.h"
+#include "../src/shm_ring.h"
+#include "../src/shm_transport.h"
+
+namespace {
+
+enum MessageId : std::uint16_t {
+    kPing = 1,
+    kPong,
+    kQuit,
+};
+
+constexpr std::size_t kRingCapacity { 1 << 20 };
+constexpr std::uint32_t kCount { 100000 };
+
+struct Ponger {
+    void Post(Message&& message)
+    {
+        if (message.id == kQuit) {
+            quit->set_value();
+        } else {
+            auto reply = MessagePool::Acquire();
+            reply.id = kPong;
+            reply.from = message.to;
+            reply.to = message.from;
+            reply.body = std::move(message.body);
+
+            MessageRouter::GetInstance().Post(std::move(reply));
+        }
+
+        MessagePool::Release(std::move(message));
+    }
+
+    std::shared_ptr<std::promise<void>> quit;
+};
+
+struct Pinger {
+    void Post(Message&& message)
+    {
+        std::uint32_t seq = 0;
+        message >> seq;
+
+        if (seq + 1 == kCount)
+            done->set_value();
+
+        MessagePool::Release(std::move(message));
+    }
+
+    std::shared_ptr<std::promise<void>> done;
+};
+
+int RunPonger(std::shared_ptr<ShmRing> inbox, std::shared_ptr<ShmRing> outbox)
+{
+    auto& router = MessageRouter::GetInstance();
+    auto quit = std::make_shared<std::promise<void>>();
+
+    router.Register(Endpoint { "pong" }, Ponger { quit });
+    router.Register(Endpoint { "ping" }, ShmSender { std::move(outbox) });
+
+    ShmReceiver receiver { std::move(inbox) };
+
+    quit->get_future().wait();
+
+    return 0;
+}
+
+int RunPinger(std::shared_ptr<ShmRing> inbox, std::shared_ptr<ShmRing> outbox)
+{
+    auto& router = MessageRouter::GetInstance();
+    auto done = std::make_shared<std::promise<void>>();
+
+    router.Register(Endpoint { "ping" }, Pinger { done });
+    router.Register(Endpoint { "pong" }, ShmSender { std::move(outbox) });
+
+    ShmReceiver receiver { std::move(inbox) };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq) {
+        auto msg = MessagePool::Acquire();
+        msg.id = kPing;
+        msg.from = Endpoint { "ping" };
+        msg.to = Endpoint { "pong" };
+        msg << seq;
+
+        router.Post(std::move(msg));
+    }
+
+    done->get_future().wait();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << kCount << " round trips in " << elapsed.count() << "us\n";
+
+    auto quit = MessagePool::Acquire();
+    quit.id = kQuit;
+    quit.to = Endpoint { "pong" };
+
+    router.Post(std::move(quit));
+
+    return 0;
+}
+
+} // namespace
+
+int main()
+{
+    const auto prefix = "/shm_ping_" + std::to_string(::getpid());
+
+    auto to_pinger = ShmRing::Create(prefix + "_ping", kRingCapacity);
+    auto to_ponger = ShmRing::Create(prefix + "_pong", kRingCapacity);
+
+    // Both processes keep their mappings, the names are no longer needed
+    ShmRing::Unlink(prefix + "_ping");
+    ShmRing::Unlink(prefix + "_pong");
+
+    if (!to_pinger || !to_ponger) {
+        std::cerr << "failed to create shared memory rings\n";
+        return 1;
+    }
+
+    auto pinger_inbox = std::make_shared<ShmRing>(std::move(*to_pinger));
+    auto ponger_inbox = std::make_shared<ShmRing>(std::move(*to_ponger));
+
+    // MessageRouter starts threads, so it must not be created before fork()
+    const auto pid = ::fork();
+
+    if (pid < 0) {
+        std::cerr << "fork failed\n";
+        return 1;
+    }
+
+    if (pid == 0)
+        return RunPonger(std::move(ponger_inbox), std::move(pinger_inbox));
+
+    const auto result = RunPinger(std::move(pinger_inbox), std::move(ponger_inbox));
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+
+    return result != 0 ? result : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
\ No newline at end of file
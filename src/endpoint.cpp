@@ -0,0 +1,123 @@
+#include "endpoint.h"
+
+#include <cassert>
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+class EndpointRegistry {
+public:
+    static EndpointRegistry& GetInstance()
+    {
+        // Never destroyed, endpoints may be used during static destruction
+        static auto* registry = new EndpointRegistry;
+        return *registry;
+    }
+
+    std::optional<Endpoint::Id> Find(std::string_view name)
+    {
+        std::shared_lock lock { mutex_ };
+
+        if (auto it = ids_.find(name); it != std::cend(ids_))
+            return it->second;
+
+        return std::nullopt;
+    }
+
+    Endpoint::Id Intern(std::string_view name)
+    {
+        if (name.empty())
+            return 0;
+
+        if (auto id = Find(name))
+            return *id;
+
+        std::lock_guard lock { mutex_ };
+
+        const auto id = static_cast<Endpoint::Id>(std::size(names_));
+        const auto [it, inserted] = ids_.try_emplace(names_.emplace_back(name), id);
+
+        // Interned by another thread in the meantime
+        if (!inserted)
+            names_.pop_back();
+
+        return it->second;
+    }
+
+    std::string_view GetName(Endpoint::Id id)
+    {
+        std::shared_lock lock { mutex_ };
+
+        assert(id < std::size(names_));
+
+        return names_[id];
+    }
+
+    std::size_t GetSize()
+    {
+        std::shared_lock lock { mutex_ };
+
+        return std::size(names_);
+    }
+
+private:
+    EndpointRegistry()
+    {
+        names_.emplace_back();
+        ids_.try_emplace(names_.front(), 0);
+    }
+
+    std::shared_mutex mutex_;
+
+    // deque never moves existing elements, so keys can refer to them
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, Endpoint::Id> ids_;
+};
+
+} // namespace
+
+std::optional<Endpoint> Endpoint::Find(std::string_view name)
+{
+    if (auto id = EndpointRegistry::GetInstance().Find(name))
+        return FromId(*id);
+
+    return std::nullopt;
+}
+
+std::optional<Endpoint> Endpoint::Find(Id id)
+{
+    if (id < EndpointRegistry::GetInstance().GetSize())
+        return FromId(id);
+
+    return std::nullopt;
+}
+
+Endpoint Endpoint::FromId(Id id)
+{
+    assert(id < EndpointRegistry::GetInstance().GetSize());
+
+    Endpoint endpoint;
+    endpoint.id_ = id;
+
+    return endpoint;
+}
+
+std::string_view Endpoint::GetName() const
+{
+    return EndpointRegistry::GetInstance().GetName(id_);
+}
+
+Endpoint::Id Endpoint::Intern(std::string_view name)
+{
+    return EndpointRegistry::GetInstance().Intern(name);
+}
+
+std::ostream& operator<<(std::ostream& os, Endpoint endpoint)
+{
+    return os << endpoint.GetName();
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef ENDPOINT_H_
+#define ENDPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Interned endpoint name
+//  - Names are interned once into a process-wide registry and never released
+//  - Ids are dense and start from 1, 0 is the empty name
+class Endpoint {
+public:
+    using Id = std::uint32_t;
+
+    Endpoint() = default;
+
+    // Interns name, explicit so a lookup by name can't intern it unnoticed, see Find
+    explicit Endpoint(std::string_view name)
+        : id_ { Intern(name) }
+    {
+    }
+
+    // Lookup without interning
+    static std::optional<Endpoint> Find(std::string_view name);
+    static std::optional<Endpoint> Find(Id id);
+
+    static Endpoint FromId(Id id);
+
+    Id GetId() const noexcept { return id_; }
+    std::string_view GetName() const;
+    bool IsEmpty() const noexcept { return id_ == 0; }
+
+    friend bool operator==(Endpoint lhs, Endpoint rhs) noexcept { return lhs.id_ == rhs.id_; }
+    friend bool operator!=(Endpoint lhs, Endpoint rhs) noexcept { return lhs.id_ != rhs.id_; }
+
+    friend std::ostream& operator<<(std::ostream& os, Endpoint endpoint);
+
+private:
+    static Id Intern(std::string_view name);
+
+    Id id_ { 0 };
+};
+
+namespace std {
+
+template <>
+struct hash<Endpoint> {
+    std::size_t operator()(Endpoint endpoint) const noexcept
+    {
+        return std::hash<Endpoint::Id> {}(endpoint.GetId());
+    }
+};
+
+} // namespace std
+
+#endif // ENDPOINT_H_
\ No newline at end of file
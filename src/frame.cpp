@@ -0,0 +1,547 @@
+#include "frame.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "util/bit.h"
+#include "util/crc32c.h"
+#include "util/varint.h"
+
+namespace {
+
+std::size_t CalculateEndpointSize(Endpoint endpoint, std::uint8_t flags)
+{
+    if ((flags & Frame::kInternedEndpoints) != 0)
+        return varint::EncodedSize(endpoint.GetId());
+
+    const auto name = endpoint.GetName();
+
+    return varint::EncodedSize(std::size(name)) + std::size(name);
+}
+
+std::uint8_t* SerializeEndpoint(std::uint8_t* first, Endpoint endpoint, std::uint8_t flags)
+{
+    if ((flags & Frame::kInternedEndpoints) != 0)
+        return varint::Encode(endpoint.GetId(), first);
+
+    const auto name = endpoint.GetName();
+
+    first = varint::Encode(std::size(name), first);
+    std::memcpy(first, std::data(name), std::size(name));
+
+    return first + std::size(name);
+}
+
+void SerializeUint32(std::uint8_t* first, std::uint32_t value)
+{
+    value = bit::hton(value);
+    std::memcpy(first, &value, sizeof(value));
+}
+
+} // namespace
+
+std::size_t Frame::SerializedSize(const Message& message, std::uint8_t flags)
+{
+    // kV2 carries every item type but std::monostate
+    for (std::size_t i = 0; i < std::size(message.body); ++i) {
+        if (message.body.GetIndex(i) == 0)
+            return 0;
+    }
+
+    const auto body_size = Message::SerializedSize(message, Message::Encoding::kV2);
+
+    const auto total_size = kLengthSize
+        + 1 /* flags */
+        + varint::EncodedSize(message.id)
+        + CalculateEndpointSize(message.from, flags)
+        + CalculateEndpointSize(message.to, flags)
+        + (body_size != 0 ? body_size : 1 /* item_count */)
+        + ((flags & kChecksum) != 0 ? kChecksumSize : 0);
+
+    return total_size - kLengthSize <= std::numeric_limits<std::uint32_t>::max() ? total_size : 0;
+}
+
+std::vector<std::uint8_t> Frame::Serialize(const Message& message, std::uint8_t flags)
+{
+    std::vector<std::uint8_t> buffer(SerializedSize(message, flags));
+
+    if (!SerializeTo(message, std::data(buffer), std::size(buffer), flags)) {
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+
+    return buffer;
+}
+
+std::optional<std::size_t> Frame::SerializeTo(const Message& message, std::uint8_t* first, std::size_t size, std::uint8_t flags)
+{
+    assert((flags & ~kAllFlags) == 0);
+
+    const auto total_size = SerializedSize(message, flags);
+    if (total_size == 0 || total_size > size)
+        return std::nullopt;
+
+    auto* ptr = first;
+
+    SerializeUint32(ptr, static_cast<std::uint32_t>(total_size - kLengthSize));
+    ptr += kLengthSize;
+
+    *ptr++ = flags;
+    ptr = varint::Encode(message.id, ptr);
+    ptr = SerializeEndpoint(ptr, message.from, flags);
+    ptr = SerializeEndpoint(ptr, message.to, flags);
+
+    if (message.body.empty()) {
+        *ptr++ = 0;
+    } else {
+        const auto body_size = Message::SerializeTo(message, ptr, static_cast<std::size_t>(first + size - ptr), Message::Encoding::kV2);
+        if (!body_size)
+            return std::nullopt;
+
+        ptr += *body_size;
+    }
+
+    if ((flags & kChecksum) != 0) {
+        SerializeUint32(ptr, crc32c::Compute(first + kLengthSize, static_cast<std::size_t>(ptr - first) - kLengthSize));
+        ptr += kChecksumSize;
+    }
+
+    assert(ptr == first + total_size);
+
+    return total_size;
+}
+
+std::optional<Message> Frame::Deserialize(const std::uint8_t* data, std::size_t size, std::pmr::memory_resource* resource, std::uint8_t accepted_flags)
+{
+    std::optional<Message> maybe_message;
+    std::size_t count = 0;
+
+    FrameDecoder decoder { size, resource, accepted_flags };
+
+    const auto decoded = decoder.Feed(data, size, [&maybe_message, &count](Message&& message) {
+        if (count++ == 0)
+            maybe_message = std::move(message);
+    });
+
+    if (!decoded || count != 1 || !decoder.IsIdle())
+        return std::nullopt;
+
+    return maybe_message;
+}
+
+FrameDecoder::FrameDecoder(std::size_t max_size, std::pmr::memory_resource* resource, std::uint8_t accepted_flags)
+    : max_size_ { max_size }
+    , resource_ { resource }
+    , accepted_flags_ { accepted_flags }
+    , message_ { Message::allocator_type { resource } }
+{
+    Restart();
+}
+
+void FrameDecoder::Reset()
+{
+    Restart();
+}
+
+std::size_t FrameDecoder::Consume(const std::uint8_t* data, std::size_t size)
+{
+    auto* first = data;
+    const auto* last = data + size;
+
+    // Bytes from crc_first on are added to crc_ on flush
+    const auto* crc_first = first;
+
+    auto flush_crc = [this, &crc_first](const std::uint8_t* end) {
+        if ((flags_ & Frame::kChecksum) != 0)
+            crc_ = crc32c::Extend(crc_, crc_first, static_cast<std::size_t>(end - crc_first));
+
+        crc_first = end;
+    };
+
+    while (first != last && state_ != State::kDone && state_ != State::kError) {
+        const auto prev_state = state_;
+
+        if (state_ == State::kLength) {
+            if (StepFixed(*first++)) {
+                if (fixed_ == 0 || fixed_ > max_size_) {
+                    Fail();
+                } else {
+                    remain_ = static_cast<std::size_t>(fixed_);
+                    state_ = State::kFlags;
+                }
+            }
+
+            crc_first = first;
+            continue;
+        }
+
+        // Frame is longer than LENGTH says
+        if (remain_ == 0) {
+            Fail();
+            break;
+        }
+
+        if (state_ == State::kName || state_ == State::kArrayData) {
+            auto& pending = state_ == State::kName ? name_remain_ : array_remain_;
+            const auto read = std::min({ static_cast<std::size_t>(last - first), pending, remain_ });
+
+            if (state_ == State::kName) {
+                name_.append(reinterpret_cast<const char*>(first), read);
+            } else {
+                std::memcpy(array_data_, first, read);
+                array_data_ += read;
+            }
+
+            first += read;
+            remain_ -= read;
+            pending -= read;
+
+            if (pending == 0 && state_ == State::kName)
+                OnName();
+            else if (pending == 0)
+                FinishArray();
+        } else {
+            const auto byte = *first++;
+            --remain_;
+
+            switch (state_) {
+            case State::kFlags:
+                if ((byte & ~(Frame::kAllFlags & accepted_flags_)) != 0) {
+                    Fail();
+                } else {
+                    flags_ = byte;
+                    StartVarint(State::kId);
+                }
+                break;
+            case State::kId:
+                if (StepVarint(byte)) {
+                    if (varint_ > std::numeric_limits<std::uint16_t>::max()) {
+                        Fail();
+                    } else {
+                        message_.id = static_cast<std::uint16_t>(varint_);
+                        StartVarint(State::kEndpoint);
+                    }
+                }
+                break;
+            case State::kEndpoint:
+                if (StepVarint(byte))
+                    OnEndpoint(varint_);
+                break;
+            case State::kCount:
+                if (StepVarint(byte)) {
+                    item_count_ = varint_;
+
+                    // Count is untrusted, but every item takes at least 2 bytes
+                    message_.body.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(item_count_, GetBodyRemain() / 2)));
+
+                    if (item_count_ == 0)
+                        FinishBody();
+                    else
+                        state_ = State::kType;
+                }
+                break;
+            case State::kType:
+                if (byte < 0x0F) {
+                    type_ = byte;
+                    StartItem();
+                } else if (byte == 0x0F) {
+                    StartVarint(State::kTypeExtension);
+                } else {
+                    Fail();
+                }
+                break;
+            case State::kTypeExtension:
+                if (StepVarint(byte)) {
+                    if (varint_ >= std::variant_size_v<Message::Item>) {
+                        Fail();
+                    } else {
+                        type_ = 0x0F + static_cast<std::size_t>(varint_);
+                        StartItem();
+                    }
+                }
+                break;
+            case State::kFixed:
+                if (StepFixed(byte))
+                    OnScalar(fixed_);
+                break;
+            case State::kVarint:
+                if (StepVarint(byte))
+                    OnScalar(varint_);
+                break;
+            case State::kArraySize:
+                if (StepVarint(byte))
+                    OnArraySize(varint_);
+                break;
+            case State::kChecksum:
+                crc_first = first;
+
+                if (StepFixed(byte)) {
+                    if (remain_ != 0 || static_cast<std::uint32_t>(fixed_) != crc_)
+                        Fail();
+                    else
+                        state_ = State::kDone;
+                }
+                break;
+            default:
+                Fail();
+                break;
+            }
+        }
+
+        // Body is complete, the checksum itself isn't covered
+        if (state_ == State::kChecksum && prev_state != State::kChecksum)
+            flush_crc(first);
+    }
+
+    if (state_ != State::kLength && state_ != State::kChecksum && state_ != State::kDone && state_ != State::kError)
+        flush_crc(first);
+
+    return static_cast<std::size_t>(first - data);
+}
+
+void FrameDecoder::Restart()
+{
+    message_ = Message { Message::allocator_type { resource_ } };
+
+    remain_ = 0;
+    flags_ = 0;
+    crc_ = 0;
+
+    endpoint_index_ = 0;
+    name_.clear();
+    name_remain_ = 0;
+    unknown_to_ = false;
+
+    item_count_ = 0;
+    item_index_ = 0;
+    type_ = 0;
+
+    array_ = {};
+    array_data_ = nullptr;
+    array_remain_ = 0;
+
+    StartFixed(State::kLength, Frame::kLengthSize);
+}
+
+bool FrameDecoder::StepVarint(std::uint8_t byte)
+{
+    // 10th byte may only carry the highest bit
+    if (varint_shift_ == 63 && byte > 1) {
+        Fail();
+        return false;
+    }
+
+    varint_ |= static_cast<std::uint64_t>(byte & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+
+    return (byte & 0x80) == 0;
+}
+
+bool FrameDecoder::StepFixed(std::uint8_t byte)
+{
+    fixed_ = (fixed_ << 8) | byte;
+
+    return ++fixed_read_ == fixed_size_;
+}
+
+void FrameDecoder::StartVarint(State state)
+{
+    state_ = state;
+    varint_ = 0;
+    varint_shift_ = 0;
+}
+
+void FrameDecoder::StartFixed(State state, std::size_t size)
+{
+    state_ = state;
+    fixed_ = 0;
+    fixed_size_ = size;
+    fixed_read_ = 0;
+}
+
+void FrameDecoder::OnEndpoint(std::uint64_t value)
+{
+    if ((flags_ & Frame::kInternedEndpoints) != 0) {
+        const auto endpoint = value <= std::numeric_limits<Endpoint::Id>::max() ? Endpoint::Find(static_cast<Endpoint::Id>(value)) : std::nullopt;
+
+        if (endpoint)
+            SetEndpoint(*endpoint);
+        else
+            Fail();
+    } else if (value == 0) {
+        SetEndpoint({});
+    } else if (value > GetBodyRemain()) {
+        Fail();
+    } else {
+        name_.clear();
+        name_remain_ = static_cast<std::size_t>(value);
+        state_ = State::kName;
+    }
+}
+
+void FrameDecoder::OnName()
+{
+    const auto endpoint = Endpoint::Find(name_);
+
+    // Parsing goes on, so the stream stays in sync and the frame is dropped once complete
+    if (!endpoint && endpoint_index_ == 1)
+        unknown_to_ = true;
+
+    SetEndpoint(endpoint.value_or(Endpoint {}));
+}
+
+void FrameDecoder::SetEndpoint(Endpoint endpoint)
+{
+    if (endpoint_index_++ == 0) {
+        message_.from = endpoint;
+        StartVarint(State::kEndpoint);
+    } else {
+        message_.to = endpoint;
+        StartVarint(State::kCount);
+    }
+}
+
+void FrameDecoder::StartItem()
+{
+    const auto started = type_traits::visit_alternative<Message::Item, bool>(type_, [this](auto identity) {
+        using T = typename decltype(identity)::type;
+
+        if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+            StartFixed(State::kFixed, 1);
+        } else if constexpr (std::is_integral_v<T>) {
+            StartVarint(State::kVarint);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            StartFixed(State::kFixed, sizeof(T));
+        } else if constexpr (MessageBody::IsArray(type_traits::variant_index_v<T, Message::Item>)) {
+            StartVarint(State::kArraySize);
+        } else {
+            return false;
+        }
+
+        return true;
+    });
+
+    if (!started)
+        Fail();
+}
+
+void FrameDecoder::OnScalar(std::uint64_t raw)
+{
+    const auto decoded = type_traits::visit_alternative<Message::Item, bool>(type_, [this, raw](auto identity) {
+        using T = typename decltype(identity)::type;
+
+        if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+            message_.body.emplace_back(std::in_place_type<T>, static_cast<T>(raw));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            const auto value = varint::ZigZagDecode(raw);
+            if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+                return false;
+
+            message_.body.emplace_back(std::in_place_type<T>, static_cast<T>(value));
+        } else if constexpr (std::is_integral_v<T>) {
+            if (raw > std::numeric_limits<T>::max())
+                return false;
+
+            message_.body.emplace_back(std::in_place_type<T>, static_cast<T>(raw));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            using Bits = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+            const auto bits = static_cast<Bits>(raw);
+
+            T value;
+            std::memcpy(&value, &bits, sizeof(T));
+
+            message_.body.emplace_back(std::in_place_type<T>, value);
+        } else {
+            return false;
+        }
+
+        return true;
+    });
+
+    if (decoded)
+        FinishItem();
+    else
+        Fail();
+}
+
+void FrameDecoder::OnArraySize(std::uint64_t size)
+{
+    const auto started = type_traits::visit_alternative<Message::Item, bool>(type_, [this, size](auto identity) {
+        using T = typename decltype(identity)::type;
+
+        if constexpr (MessageBody::IsArray(type_traits::variant_index_v<T, Message::Item>)) {
+            constexpr auto kValueSize = sizeof(typename T::value_type);
+
+            if (size > GetBodyRemain() / kValueSize)
+                return false;
+
+            auto& array = array_.template emplace<T>(resource_);
+            array.resize(static_cast<std::size_t>(size));
+
+            array_data_ = reinterpret_cast<std::uint8_t*>(std::data(array));
+            array_remain_ = static_cast<std::size_t>(size) * kValueSize;
+
+            return true;
+        } else {
+            return false;
+        }
+    });
+
+    if (!started)
+        Fail();
+    else if (array_remain_ == 0)
+        FinishArray();
+    else
+        state_ = State::kArrayData;
+}
+
+void FrameDecoder::FinishArray()
+{
+    std::visit([](auto& value) {
+        using T = type_traits::remove_cvref_t<decltype(value)>;
+
+        if constexpr (MessageBody::IsArray(type_traits::variant_index_v<T, Message::Item>)) {
+            // Byteswapped in place
+            if (!value.empty())
+                bit::ntoh_n(reinterpret_cast<const std::uint8_t*>(std::data(value)), std::size(value), std::data(value));
+        }
+    },
+        array_);
+
+    message_.body.emplace_back(std::move(array_));
+
+    array_ = {};
+    array_data_ = nullptr;
+
+    FinishItem();
+}
+
+void FrameDecoder::FinishItem()
+{
+    if (++item_index_ == item_count_)
+        FinishBody();
+    else
+        state_ = State::kType;
+}
+
+void FrameDecoder::FinishBody()
+{
+    if ((flags_ & Frame::kChecksum) != 0)
+        StartFixed(State::kChecksum, Frame::kChecksumSize);
+    else if (remain_ != 0)
+        Fail();
+    else
+        state_ = State::kDone;
+}
+
+std::size_t FrameDecoder::GetBodyRemain() const noexcept
+{
+    const auto trailer = (flags_ & Frame::kChecksum) != 0 ? Frame::kChecksumSize : 0;
+
+    return remain_ > trailer ? remain_ - trailer : 0;
+}
\ No newline at end of file
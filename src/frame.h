@@ -0,0 +1,186 @@
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "message.h"
+
+// Self-delimiting envelope carrying a whole Message
+//
+// +--------+--------+~~~~~~~~+~~~~~~~~+~~~~~~~~+~~~~~~~~+========+--------+
+// | LENGTH | FLAGS  |   ID   |  FROM  |   TO   | COUNT  | ITEMS  | (CRC)  |
+// +--------+--------+~~~~~~~~+~~~~~~~~+~~~~~~~~+~~~~~~~~+========+--------+
+//  - LENGTH : 32-bit size of everything after it, in network byte order
+//  - ID     : varint
+//  - FROM/TO: varint Endpoint id with kInternedEndpoints, otherwise varint size followed by the name
+//             Names are looked up, never interned, a frame sent to an endpoint unknown to this process is dropped
+//             An unknown sender decodes as an empty Endpoint
+//  - COUNT, ITEMS : body in Message::Encoding::kV2, COUNT is present even for an empty body
+//  - CRC    : CRC-32C of FLAGS to ITEMS in network byte order, with kChecksum
+class Frame {
+public:
+    enum Flags : std::uint8_t {
+        kChecksum = 1 << 0,
+        // Endpoint ids are only meaningful within one process
+        kInternedEndpoints = 1 << 1,
+    };
+
+    static constexpr std::uint8_t kAllFlags { kChecksum | kInternedEndpoints };
+
+    static constexpr std::size_t kLengthSize { 4 };
+    static constexpr std::size_t kChecksumSize { 4 };
+    static constexpr std::size_t kDefaultMaxSize { 16 << 20 };
+
+    // 0 if the message can't be framed, for a std::monostate item or LENGTH over 32 bits
+    static std::size_t SerializedSize(const Message& message, std::uint8_t flags = 0);
+    static std::vector<std::uint8_t> Serialize(const Message& message, std::uint8_t flags = 0);
+
+    // Write into [first, first + size), return written size or std::nullopt if it doesn't fit
+    static std::optional<std::size_t> SerializeTo(const Message& message, std::uint8_t* first, std::size_t size, std::uint8_t flags = 0);
+
+    // Buffer must hold exactly one frame, std::nullopt if it's sent to an unknown endpoint
+    //  - accepted_flags as in FrameDecoder
+    static std::optional<Message> Deserialize(const std::uint8_t* data, std::size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), std::uint8_t accepted_flags = kChecksum);
+
+    static std::optional<Message> Deserialize(const std::vector<std::uint8_t>& buffer, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), std::uint8_t accepted_flags = kChecksum)
+    {
+        return Deserialize(std::data(buffer), std::size(buffer), resource, accepted_flags);
+    }
+};
+
+// Incremental Frame parser, input may be split at any byte
+//  - Message is built as bytes arrive, only an unfinished varint, scalar or endpoint name is kept between calls
+//  - Array items are allocated at their full size once it's known, bounded by max_size
+//  - Endpoint names are resolved with Endpoint::Find, so peers can't grow the registry
+//    A frame sent to an unknown endpoint is skipped whole and counted, it has no route in this process anyway
+//    An unknown sender only becomes an empty from, the peer's own endpoints are rarely known here
+//  - A frame with a flag outside accepted_flags is malformed
+//    kInternedEndpoints is off by default, ids from another process would resolve to unrelated endpoints
+class FrameDecoder {
+public:
+    explicit FrameDecoder(std::size_t max_size = Frame::kDefaultMaxSize, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), std::uint8_t accepted_flags = Frame::kChecksum);
+
+    // Call f(Message&&) for each frame completed within [data, data + size)
+    //  - Returns false on a malformed frame, Reset() must be called before feeding more
+    template <typename F>
+    bool Feed(const std::uint8_t* data, std::size_t size, F&& f)
+    {
+        while (size != 0 && state_ != State::kError) {
+            const auto consumed = Consume(data, size);
+
+            data += consumed;
+            size -= consumed;
+
+            if (state_ == State::kDone) {
+                if (unknown_to_)
+                    ++drop_count_;
+                else
+                    f(std::move(message_));
+
+                Restart();
+            }
+        }
+
+        return state_ != State::kError;
+    }
+
+    // Drop any partial frame and the error state
+    void Reset();
+
+    bool HasError() const noexcept { return state_ == State::kError; }
+
+    // No partial frame is pending
+    bool IsIdle() const noexcept { return state_ == State::kLength && fixed_read_ == 0; }
+
+    // Well-formed frames skipped for being sent to an unknown endpoint
+    std::uint64_t GetDropCount() const noexcept { return drop_count_; }
+
+private:
+    enum class State {
+        kLength,
+        kFlags,
+        kId,
+        kEndpoint,
+        kName,
+        kCount,
+        kType,
+        kTypeExtension,
+        kFixed,
+        kVarint,
+        kArraySize,
+        kArrayData,
+        kChecksum,
+        kDone,
+        kError,
+    };
+
+    // Consume until a frame is done or input runs out, returns consumed size
+    std::size_t Consume(const std::uint8_t* data, std::size_t size);
+
+    void Restart();
+    void Fail() noexcept { state_ = State::kError; }
+
+    // Returns true once the varint is complete
+    bool StepVarint(std::uint8_t byte);
+    bool StepFixed(std::uint8_t byte);
+
+    void StartVarint(State state);
+    void StartFixed(State state, std::size_t size);
+
+    void OnEndpoint(std::uint64_t value);
+    void OnName();
+    void SetEndpoint(Endpoint endpoint);
+    void StartItem();
+    void OnScalar(std::uint64_t raw);
+    void OnArraySize(std::uint64_t size);
+    void FinishArray();
+    void FinishItem();
+    void FinishBody();
+
+    // Frame bytes left after the trailing checksum
+    std::size_t GetBodyRemain() const noexcept;
+
+    const std::size_t max_size_;
+    std::pmr::memory_resource* const resource_;
+    const std::uint8_t accepted_flags_;
+
+    State state_ { State::kLength };
+    Message message_;
+
+    // Frame bytes left after LENGTH
+    std::size_t remain_ { 0 };
+    std::uint8_t flags_ { 0 };
+    std::uint32_t crc_ { 0 };
+
+    std::uint64_t varint_ { 0 };
+    std::size_t varint_shift_ { 0 };
+    std::uint64_t fixed_ { 0 };
+    std::size_t fixed_size_ { 0 };
+    std::size_t fixed_read_ { 0 };
+
+    // 0 for from, 1 for to
+    std::size_t endpoint_index_ { 0 };
+    std::string name_;
+    std::size_t name_remain_ { 0 };
+    bool unknown_to_ { false };
+
+    std::uint64_t drop_count_ { 0 };
+
+    std::uint64_t item_count_ { 0 };
+    std::uint64_t item_index_ { 0 };
+    std::size_t type_ { 0 };
+
+    // Array item being filled in network byte order
+    Message::Item array_;
+    std::uint8_t* array_data_ { nullptr };
+    std::size_t array_remain_ { 0 };
+};
+
+#endif // FRAME_H_
\ No newline at end of file
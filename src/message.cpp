@@ -5,18 +5,17 @@
 #include <cstring>
 
 #include <algorithm>
-#include <array>
-#include <functional>
 #include <limits>
 #include <memory_resource>
-#include <numeric>
 
+#include "message_view.h"
 #include "util/bit.h"
+#include "util/varint.h"
 
 namespace detail {
 
 template <typename T>
-inline constexpr bool is_array_like = type_traits::is_vector_v<T> || std::is_same_v<T, std::string>;
+inline constexpr bool is_array_like = type_traits::is_vector_v<T> || std::is_same_v<T, std::pmr::string>;
 
 template <typename T>
 constexpr std::uint8_t CalculateArraySize(T value)
@@ -37,29 +36,27 @@ constexpr std::uint8_t CalculateArraySize(T value)
 
 std::size_t CalculateTotalSize(const Message::Items& items)
 {
-    return std::transform_reduce(
-        std::cbegin(items),
-        std::cend(items),
-        std::size(items),
-        std::plus<> {},
-        [](const auto& item) {
-            return std::visit([](auto&& value) -> std::size_t {
-                using T = type_traits::remove_cvref_t<decltype(value)>;
+    std::size_t total_size = std::size(items);
 
-                if constexpr (std::is_integral_v<T>) {
-                    return sizeof(T);
-                } else if constexpr (detail::is_array_like<T>) {
+    for (std::size_t i = 0; i < std::size(items); ++i) {
+        total_size += items.Visit(i, [](auto&& value) -> std::size_t {
+            using T = type_traits::remove_cvref_t<decltype(value)>;
 
-                    const auto container_size = std::size(value);
-                    const auto array_size = CalculateArraySize(container_size);
+            if constexpr (std::is_integral_v<T>) {
+                return sizeof(T);
+            } else if constexpr (detail::is_array_like<T>) {
 
-                    return array_size + container_size * sizeof(typename T::value_type);
-                } else {
-                    return 0;
-                }
-            },
-                item);
+                const auto container_size = std::size(value);
+                const auto array_size = CalculateArraySize(container_size);
+
+                return array_size + container_size * sizeof(typename T::value_type);
+            } else {
+                return 0;
+            }
         });
+    }
+
+    return total_size;
 }
 
 // Encode type and size within 8-bit
@@ -83,93 +80,120 @@ std::size_t CalculateTotalSize(const Message::Items& items)
 // +--------+========+~~~~~~~~+
 // |YYYYXXXX|  SIZE  |  DATA  |
 // +--------+========+~~~~~~~~+
-std::uint8_t Encode(const Message::Item& item)
+template <typename T>
+std::uint8_t Encode(const T& value)
 {
-    const auto size_code = std::visit(
-        [](auto&& value) -> std::uint8_t {
-            using T = type_traits::remove_cvref_t<decltype(value)>;
+    constexpr auto type_code = static_cast<std::uint8_t>(type_traits::variant_index_v<T, Message::Item>);
 
-            if constexpr (std::is_integral_v<T>) {
-                return 0;
-            } else if constexpr (detail::is_array_like<T>) {
-                return CalculateArraySize(std::size(value));
-            } else {
-                return 0;
-            }
-        },
-        item);
-
-    return (size_code << 4) | static_cast<std::uint8_t>(item.index());
+    if constexpr (std::is_integral_v<T>) {
+        return type_code;
+    } else if constexpr (detail::is_array_like<T>) {
+        return static_cast<std::uint8_t>(CalculateArraySize(std::size(value)) << 4) | type_code;
+    } else {
+        return 0;
+    }
 }
 
 template <typename T>
-void SerializeInt(std::vector<std::uint8_t>& buffer, T value)
+void SerializeInt(std::uint8_t*& first, T value)
 {
     static_assert(std::is_integral_v<T>);
 
     if constexpr (sizeof(T) == 1) {
-        buffer.emplace_back(static_cast<std::uint8_t>(value));
+        *first = static_cast<std::uint8_t>(value);
     } else {
         if constexpr (bit::endian::native == bit::endian::little && sizeof(T) != 1)
             value = bit::hton(value);
 
-        const auto* ptr = reinterpret_cast<const std::uint8_t*>(&value);
-        buffer.insert(std::cend(buffer), ptr, ptr + sizeof(T));
+        std::memcpy(first, &value, sizeof(T));
     }
+
+    first += sizeof(T);
 }
 
-template <typename T>
-void SerializeArray(std::vector<std::uint8_t>& buffer, const T& container)
+void SerializeArraySize(std::uint8_t*& first, std::size_t container_size)
 {
-    static_assert(detail::is_array_like<T>);
-
-    const auto container_size = std::size(container);
-    const auto array_size = CalculateArraySize(container_size);
-    const auto value_size = container_size * sizeof(typename T::value_type);
-
-    switch (array_size) {
+    switch (CalculateArraySize(container_size)) {
     case 1:
-        SerializeInt(buffer, static_cast<std::uint8_t>(container_size));
+        SerializeInt(first, static_cast<std::uint8_t>(container_size));
         break;
     case 2:
-        SerializeInt(buffer, static_cast<std::uint16_t>(container_size));
+        SerializeInt(first, static_cast<std::uint16_t>(container_size));
         break;
     case 4:
-        SerializeInt(buffer, static_cast<std::uint32_t>(container_size));
+        SerializeInt(first, static_cast<std::uint32_t>(container_size));
         break;
     case 8:
-        SerializeInt(buffer, static_cast<std::uint64_t>(container_size));
+        SerializeInt(first, static_cast<std::uint64_t>(container_size));
         break;
     default:
         assert(false);
         break;
     }
+}
+
+template <typename T>
+void SerializeArrayData(std::uint8_t*& first, const T& container)
+{
+    static_assert(detail::is_array_like<T>);
+
+    const auto container_size = std::size(container);
+    const auto value_size = container_size * sizeof(typename T::value_type);
 
     if (container_size == 0)
         return;
 
-    if constexpr (bit::endian::native == bit::endian::little && sizeof(typename T::value_type) != 1) {
-        static constexpr std::size_t kBufferSize { 1024 * sizeof(typename T::value_type) };
+    bit::hton_n(std::data(container), container_size, first);
 
-        std::array<std::byte, kBufferSize> stack_buffer;
-        std::pmr::monotonic_buffer_resource mbr { std::data(stack_buffer), std::size(stack_buffer) };
-        std::pmr::vector<typename T::value_type> copy { std::cbegin(container), std::cend(container), &mbr };
+    first += value_size;
+}
 
-        std::transform(
-            std::begin(copy),
-            std::end(copy),
-            std::begin(copy),
-            bit::hton<typename T::value_type>);
+// Write the whole body into first, which must hold CalculateTotalSize(items) + 1 bytes
+//  - gather(value, first) can take over the data of an array item by returning true
+//  - Returns the end of written data, or nullptr if an item can't be encoded
+template <typename Gather>
+std::uint8_t* SerializeItems(const Message::Items& items, std::uint8_t* first, Gather&& gather)
+{
+    const auto item_count = static_cast<std::uint8_t>(std::min(std::size_t { 0xFF }, std::size(items)));
+    SerializeInt(first, item_count);
 
-        const auto* value_ptr = reinterpret_cast<const std::uint8_t*>(std::data(copy));
-        buffer.insert(std::cend(buffer), value_ptr, value_ptr + value_size);
-    } else {
-        const auto* value_ptr = reinterpret_cast<const std::uint8_t*>(std::data(container));
-        buffer.insert(std::cend(buffer), value_ptr, value_ptr + value_size);
+    for (std::size_t i = 0; i < std::size(items); ++i) {
+        const auto encoded = items.Visit(i, [&first, &gather](auto&& value) {
+            using T = type_traits::remove_cvref_t<decltype(value)>;
+
+            const auto code = Encode(value);
+            if (code == 0)
+                return false;
+
+            SerializeInt(first, code);
+
+            if constexpr (std::is_integral_v<T>) {
+                SerializeInt(first, value);
+            } else if constexpr (detail::is_array_like<T>) {
+                SerializeArraySize(first, std::size(value));
+
+                if (!gather(value, first))
+                    SerializeArrayData(first, value);
+            }
+
+            return true;
+        });
+
+        // e.g. float in kV1 or an empty item, callers report it as failure
+        if (!encoded)
+            return nullptr;
     }
+
+    return first;
+}
+
+std::uint8_t* SerializeItems(const Message::Items& items, std::uint8_t* first)
+{
+    return SerializeItems(items, first, [](auto&&, auto*) { return false; });
 }
 
-std::pair<Message::Item, std::uint8_t> Decode(std::uint8_t code)
+// Array items are constructed with resource
+std::pair<Message::Item, std::uint8_t> Decode(std::uint8_t code, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
 {
     std::pair<Message::Item, std::uint8_t> ret;
     auto& [item, size] = ret;
@@ -211,26 +235,25 @@ std::pair<Message::Item, std::uint8_t> Decode(std::uint8_t code)
         break;
     // Array type
     case 11:
-        item.emplace<11>();
+        item.emplace<11>(resource);
         break;
     case 12:
-        item.emplace<12>();
+        item.emplace<12>(resource);
         break;
     case 13:
-        item.emplace<13>();
+        item.emplace<13>(resource);
         break;
-    // Default type
+    // Default type, or a code from untrusted input that no type has
+    //  - Left as std::monostate, callers reject it
     default:
-        // item.emplace<0>();
-        assert(false);
         break;
     }
 
     auto has_single_bit = [](auto x) { return x != 0 && (x & (x - 1)) == 0; };
 
-    if (type_code >= 10 && type_code <= 12 && !has_single_bit(size_code)) {
+    if (type_code >= 11 && type_code <= 13 && !has_single_bit(size_code)) {
         item.emplace<0>();
-    } else if (type_code < 10 && size_code != 0) {
+    } else if (type_code < 11 && size_code != 0) {
         item.emplace<0>();
     } else {
         size = static_cast<std::uint8_t>(size_code >> 4);
@@ -259,98 +282,509 @@ T DeserializeInt(const std::uint8_t* first)
     }
 }
 
+std::size_t DeserializeArraySize(const std::uint8_t* first, std::uint8_t array_size)
+{
+    switch (array_size) {
+    case 1:
+        return DeserializeInt<std::uint8_t>(first);
+    case 2:
+        return DeserializeInt<std::uint16_t>(first);
+    case 4:
+        return DeserializeInt<std::uint32_t>(first);
+    case 8:
+        return static_cast<std::size_t>(DeserializeInt<std::uint64_t>(first));
+    default:
+        assert(false);
+        return 0;
+    }
+}
+
 template <typename T>
 std::size_t DeserializeArray(T& container, const std::uint8_t* first, std::uint8_t array_size)
 {
     static_assert(detail::is_array_like<T>);
 
-    auto container_size = [first, array_size]() -> std::size_t {
-        switch (array_size) {
-        case 1:
-            return DeserializeInt<std::uint8_t>(first);
-        case 2:
-            return DeserializeInt<std::uint16_t>(first);
-        case 4:
-            return DeserializeInt<std::uint32_t>(first);
-        case 8:
-            return static_cast<std::size_t>(DeserializeInt<std::uint64_t>(first));
-        default:
-            assert(false);
-            return 0;
-        }
-    }();
+    const auto container_size = DeserializeArraySize(first, array_size);
 
     if (container_size == 0)
         return array_size;
 
-    const auto* ptr = reinterpret_cast<const typename T::value_type*>(first + array_size);
+    container.resize(container_size);
+    bit::ntoh_n(first + array_size, container_size, std::data(container));
+
+    return array_size + container_size * sizeof(typename T::value_type);
+}
+
+// Size of the item data following the code byte
+// Returns std::nullopt if the data doesn't fit in [first, last)
+std::optional<std::size_t> PeekItemSize(const Message::Item& item, std::uint8_t array_size, const std::uint8_t* first, const std::uint8_t* last)
+{
+    const auto remain = static_cast<std::size_t>(last - first);
+
+    return std::visit([remain, first, array_size](auto&& value) -> std::optional<std::size_t> {
+        using T = type_traits::remove_cvref_t<decltype(value)>;
+
+        if constexpr (std::is_integral_v<T>) {
+            if (remain < sizeof(T))
+                return std::nullopt;
+
+            return sizeof(T);
+        } else if constexpr (detail::is_array_like<T>) {
+            if (remain < array_size)
+                return std::nullopt;
 
-    container.reserve(container_size);
-    container.assign(ptr, ptr + container_size);
+            const auto container_size = DeserializeArraySize(first, array_size);
+            if (container_size > (remain - array_size) / sizeof(typename T::value_type))
+                return std::nullopt;
 
-    if constexpr (bit::endian::native == bit::endian::little && sizeof(typename T::value_type) != 1) {
-        std::transform(
-            std::begin(container),
-            std::end(container),
-            std::begin(container),
-            bit::ntoh<typename T::value_type>);
+            return array_size + container_size * sizeof(typename T::value_type);
+        } else {
+            return std::nullopt;
+        }
+    },
+        item);
+}
+
+// Encoding v2
+//  - Item count and array sizes are LEB128 varints
+//  - Integers wider than 8-bit are varints, signed ones are zigzag mapped first
+//  - float, double and int array elements are fixed width in network byte order, so views keep random access
+//
+// +~~~~~~~~+========+========+
+// | COUNT  |  ITEM  |  ...   |
+// +~~~~~~~~+========+========+
+//
+// Type code 0x0F is an escape, followed by a varint of the type code minus 0x0F
+// +--------+~~~~~~~~+~~~~~~~~+
+// |0000XXXX| (TYPE) |  DATA  |
+// +--------+~~~~~~~~+~~~~~~~~+
+//
+// Array DATA
+// +~~~~~~~~+~~~~~~~~+
+// |  SIZE  |  DATA  |
+// +~~~~~~~~+~~~~~~~~+
+constexpr std::size_t kEscapeCode { 0x0F };
+
+constexpr std::size_t TypeCodeSizeV2(std::size_t type)
+{
+    return type < kEscapeCode ? 1 : 1 + varint::EncodedSize(type - kEscapeCode);
+}
+
+template <typename T>
+std::uint64_t ToVarint(T value)
+{
+    static_assert(std::is_integral_v<T>);
+
+    if constexpr (std::is_signed_v<T>)
+        return varint::ZigZagEncode(value);
+    else
+        return static_cast<std::uint64_t>(value);
+}
+
+template <typename T>
+auto ToBits(T value)
+{
+    static_assert(std::is_floating_point_v<T>);
+
+    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits;
+    static_assert(sizeof(bits) == sizeof(T));
+
+    std::memcpy(&bits, &value, sizeof(T));
+
+    return bits;
+}
+
+// Size including type code, 0 if the item can't be encoded
+template <typename T>
+std::size_t CalculateItemSizeV2(const T& value)
+{
+    constexpr auto type = type_traits::variant_index_v<T, Message::Item>;
+
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+        return TypeCodeSizeV2(type) + 1;
+    } else if constexpr (std::is_integral_v<T>) {
+        return TypeCodeSizeV2(type) + varint::EncodedSize(ToVarint(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return TypeCodeSizeV2(type) + sizeof(T);
+    } else if constexpr (detail::is_array_like<T>) {
+        const auto container_size = std::size(value);
+
+        return TypeCodeSizeV2(type) + varint::EncodedSize(container_size) + container_size * sizeof(typename T::value_type);
+    } else {
+        return 0;
     }
+}
 
-    return array_size + container_size * sizeof(typename T::value_type);
+std::size_t CalculateTotalSizeV2(const Message::Items& items)
+{
+    std::size_t total_size = varint::EncodedSize(std::size(items));
+
+    for (std::size_t i = 0; i < std::size(items); ++i)
+        total_size += items.Visit(i, [](auto&& value) { return CalculateItemSizeV2(value); });
+
+    return total_size;
 }
 
-} // namespace detail
+void SerializeTypeCodeV2(std::uint8_t*& first, std::size_t type)
+{
+    if (type < kEscapeCode) {
+        *first++ = static_cast<std::uint8_t>(type);
+    } else {
+        *first++ = static_cast<std::uint8_t>(kEscapeCode);
+        first = varint::Encode(type - kEscapeCode, first);
+    }
+}
+
+// Same as SerializeItems(), first must hold CalculateTotalSizeV2(items) bytes
+template <typename Gather>
+std::uint8_t* SerializeItemsV2(const Message::Items& items, std::uint8_t* first, Gather&& gather)
+{
+    first = varint::Encode(std::size(items), first);
+
+    for (std::size_t i = 0; i < std::size(items); ++i) {
+        const auto encoded = items.Visit(i, [&first, &gather](auto&& value) {
+            using T = type_traits::remove_cvref_t<decltype(value)>;
+
+            if constexpr (std::is_same_v<T, std::monostate>) {
+                return false;
+            } else {
+                SerializeTypeCodeV2(first, type_traits::variant_index_v<T, Message::Item>);
+
+                if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+                    SerializeInt(first, value);
+                } else if constexpr (std::is_integral_v<T>) {
+                    first = varint::Encode(ToVarint(value), first);
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    SerializeInt(first, ToBits(value));
+                } else if constexpr (detail::is_array_like<T>) {
+                    first = varint::Encode(std::size(value), first);
+
+                    if (!gather(value, first))
+                        SerializeArrayData(first, value);
+                }
 
-std::vector<std::uint8_t> Message::Serialize(const Message& message)
+                return true;
+            }
+        });
+
+        if (!encoded)
+            return nullptr;
+    }
+
+    return first;
+}
+
+template <typename Gather>
+std::uint8_t* SerializeItems(const Message::Items& items, std::uint8_t* first, Message::Encoding encoding, Gather&& gather)
 {
-    std::vector<std::uint8_t> buffer;
+    if (encoding == Message::Encoding::kV2)
+        return SerializeItemsV2(items, first, std::forward<Gather>(gather));
 
-    const auto& items = message.body;
-    const auto total_size = 1 /* item_count */ + detail::CalculateTotalSize(items);
+    return SerializeItems(items, first, std::forward<Gather>(gather));
+}
 
-    if (total_size != 1) {
-        buffer.reserve(total_size);
+std::uint8_t* SerializeItems(const Message::Items& items, std::uint8_t* first, Message::Encoding encoding)
+{
+    return SerializeItems(items, first, encoding, [](auto&&, auto*) { return false; });
+}
 
-        const auto item_count = static_cast<std::uint8_t>(std::min(std::size_t { 0xFF }, std::size(items)));
-        detail::SerializeInt(buffer, item_count);
+// Functions below return the end of read data, or nullptr if it doesn't fit in [first, last) or is malformed
+
+const std::uint8_t* DeserializeTypeCodeV2(const std::uint8_t* first, const std::uint8_t* last, std::size_t& type)
+{
+    if (first == last)
+        return nullptr;
+
+    const auto code = *first++;
+
+    if (code < kEscapeCode) {
+        type = code;
+        return first;
     }
 
-    for (const auto& item : items) {
-        const auto code = detail::Encode(item);
-        if (code == 0) {
-            assert(false);
-            buffer.clear();
-            buffer.shrink_to_fit();
-            break;
+    std::uint64_t extension;
+    if (code != kEscapeCode || !(first = varint::Decode(first, last, extension)) || extension >= std::variant_size_v<Message::Item>)
+        return nullptr;
+
+    type = kEscapeCode + static_cast<std::size_t>(extension);
+
+    return first;
+}
+
+const std::uint8_t* DeserializeArraySizeV2(const std::uint8_t* first, const std::uint8_t* last, std::size_t value_size, std::size_t& container_size)
+{
+    std::uint64_t size;
+    if (!(first = varint::Decode(first, last, size)) || size > static_cast<std::size_t>(last - first) / value_size)
+        return nullptr;
+
+    container_size = static_cast<std::size_t>(size);
+
+    return first;
+}
+
+template <typename T>
+const std::uint8_t* DeserializeValueV2(const std::uint8_t* first, const std::uint8_t* last, T& value)
+{
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+        if (first == last)
+            return nullptr;
+
+        value = DeserializeInt<T>(first);
+
+        return first + 1;
+    } else if constexpr (std::is_integral_v<T>) {
+        std::uint64_t raw;
+        if (!(first = varint::Decode(first, last, raw)))
+            return nullptr;
+
+        if constexpr (std::is_signed_v<T>) {
+            const auto decoded = varint::ZigZagDecode(raw);
+            if (decoded < std::numeric_limits<T>::min() || decoded > std::numeric_limits<T>::max())
+                return nullptr;
+
+            value = static_cast<T>(decoded);
+        } else {
+            if (raw > std::numeric_limits<T>::max())
+                return nullptr;
+
+            value = static_cast<T>(raw);
         }
 
-        detail::SerializeInt(buffer, code);
+        return first;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if (static_cast<std::size_t>(last - first) < sizeof(T))
+            return nullptr;
 
-        std::visit([&buffer](auto&& value) {
-            using T = type_traits::remove_cvref_t<decltype(value)>;
+        const auto bits = DeserializeInt<decltype(ToBits(value))>(first);
+        std::memcpy(&value, &bits, sizeof(T));
 
-            if constexpr (std::is_integral_v<T>) {
-                detail::SerializeInt(buffer, value);
-            } else if constexpr (detail::is_array_like<T>) {
-                detail::SerializeArray(buffer, value);
+        return first + sizeof(T);
+    } else if constexpr (detail::is_array_like<T>) {
+        std::size_t container_size;
+        if (!(first = DeserializeArraySizeV2(first, last, sizeof(typename T::value_type), container_size)))
+            return nullptr;
+
+        value.resize(container_size);
+
+        if (container_size != 0)
+            bit::ntoh_n(first, container_size, std::data(value));
+
+        return first + container_size * sizeof(typename T::value_type);
+    } else {
+        return nullptr;
+    }
+}
+
+// Same as DeserializeValueV2() without copying array data
+template <typename T>
+const std::uint8_t* SkipValueV2(const std::uint8_t* first, const std::uint8_t* last)
+{
+    if constexpr (detail::is_array_like<T>) {
+        std::size_t container_size;
+        if (!(first = DeserializeArraySizeV2(first, last, sizeof(typename T::value_type), container_size)))
+            return nullptr;
+
+        return first + container_size * sizeof(typename T::value_type);
+    } else if constexpr (std::is_same_v<T, std::monostate>) {
+        return nullptr;
+    } else {
+        T value;
+        return DeserializeValueV2(first, last, value);
+    }
+}
+
+bool DeserializeItemsV2(Message::Items& items, const std::uint8_t* first, const std::uint8_t* last)
+{
+    std::uint64_t item_count;
+    if (!(first = varint::Decode(first, last, item_count)))
+        return false;
+
+    // Count is untrusted, but every item takes at least 2 bytes
+    items.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(item_count, static_cast<std::size_t>(last - first) / 2)));
+
+    auto* resource = items.get_allocator().resource();
+
+    for (std::uint64_t i = 0; i < item_count; ++i) {
+        std::size_t type;
+        if (!(first = DeserializeTypeCodeV2(first, last, type)))
+            return false;
+
+        first = type_traits::visit_alternative<Message::Item, const std::uint8_t*>(type, [&items, first, last, resource](auto identity) -> const std::uint8_t* {
+            using T = typename decltype(identity)::type;
+
+            if constexpr (std::is_same_v<T, std::monostate>) {
+                return nullptr;
+            } else {
+                auto value = [resource] {
+                    if constexpr (detail::is_array_like<T>)
+                        return T { resource };
+                    else
+                        return T {};
+                }();
+
+                const auto* next = DeserializeValueV2(first, last, value);
+                if (next)
+                    items.emplace_back(std::in_place_type<T>, std::move(value));
+
+                return next;
             }
-        },
-            item);
+        });
+
+        if (!first)
+            return false;
     }
 
-    assert(total_size == 1 || (total_size == buffer.capacity() && total_size == buffer.size()));
+    return first == last;
+}
+
+// Non-empty shared body is serialized once per encoding, nullptr if not shared or it can't be serialized
+const std::vector<std::uint8_t>* GetCached(const Message::Items& items, Message::Encoding encoding)
+{
+    if (!items.IsShared() || items.empty())
+        return nullptr;
+
+    return items.GetCached(static_cast<std::size_t>(encoding), [encoding](const Message::Items& shared) -> std::optional<std::vector<std::uint8_t>> {
+        const auto size = encoding == Message::Encoding::kV2 ? CalculateTotalSizeV2(shared) : 1 /* item_count */ + CalculateTotalSize(shared);
+        std::vector<std::uint8_t> buffer(size);
+
+        if (!SerializeItems(shared, std::data(buffer), encoding))
+            return std::nullopt;
+
+        return buffer;
+    });
+}
+
+} // namespace detail
+
+std::size_t Message::SerializedSize(const Message& message, Encoding encoding)
+{
+    // Empty body is serialized as an empty buffer
+    if (message.body.empty())
+        return 0;
+
+    if (const auto* cached = detail::GetCached(message.body, encoding))
+        return std::size(*cached);
+
+    if (encoding == Encoding::kV2)
+        return detail::CalculateTotalSizeV2(message.body);
+
+    return 1 /* item_count */ + detail::CalculateTotalSize(message.body);
+}
+
+std::vector<std::uint8_t> Message::Serialize(const Message& message, Encoding encoding)
+{
+    if (const auto* cached = detail::GetCached(message.body, encoding))
+        return *cached;
+
+    std::vector<std::uint8_t> buffer(SerializedSize(message, encoding));
+
+    if (!buffer.empty() && !detail::SerializeItems(message.body, std::data(buffer), encoding)) {
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
 
     return buffer;
 }
 
-std::optional<Message> Message::Deserialize(const std::vector<std::uint8_t>& buffer)
+std::pmr::vector<std::uint8_t> Message::Serialize(const Message& message, std::pmr::memory_resource* resource, Encoding encoding)
+{
+    if (const auto* cached = detail::GetCached(message.body, encoding))
+        return { std::cbegin(*cached), std::cend(*cached), resource };
+
+    std::pmr::vector<std::uint8_t> buffer(SerializedSize(message, encoding), resource);
+
+    if (!buffer.empty() && !detail::SerializeItems(message.body, std::data(buffer), encoding))
+        buffer.clear();
+
+    return buffer;
+}
+
+std::optional<std::size_t> Message::SerializeTo(const Message& message, std::uint8_t* first, std::size_t size, Encoding encoding)
+{
+    const auto total_size = SerializedSize(message, encoding);
+    if (total_size > size)
+        return std::nullopt;
+
+    if (const auto* cached = detail::GetCached(message.body, encoding)) {
+        std::memcpy(first, std::data(*cached), total_size);
+        return total_size;
+    }
+
+    if (total_size != 0 && !detail::SerializeItems(message.body, first, encoding))
+        return std::nullopt;
+
+    return total_size;
+}
+
+std::size_t Message::SerializeGather(const Message& message, std::vector<std::uint8_t>& scratch, std::vector<Segment>& segments, std::size_t threshold, Encoding encoding)
+{
+    const auto total_size = SerializedSize(message, encoding);
+
+    scratch.resize(total_size);
+    segments.clear();
+
+    if (total_size == 0)
+        return 0;
+
+    // Whole message is one segment, referring to the shared body
+    if (const auto* cached = detail::GetCached(message.body, encoding)) {
+        scratch.clear();
+        segments.push_back({ std::data(*cached), std::size(*cached) });
+
+        return total_size;
+    }
+
+    // Pointers into scratch stay valid as it never grows after this point
+    auto* segment_first = std::data(scratch);
+
+    auto gather = [&segments, &segment_first, threshold](auto&& value, std::uint8_t* first) {
+        using T = type_traits::remove_cvref_t<decltype(value)>;
+
+        // Integer arrays need byteswapping on little-endian, so they're always copied
+        if constexpr (bit::endian::native == bit::endian::little && sizeof(typename T::value_type) != 1) {
+            return false;
+        } else {
+            const auto value_size = std::size(value) * sizeof(typename T::value_type);
+            if (value_size < threshold)
+                return false;
+
+            if (first != segment_first)
+                segments.push_back({ segment_first, static_cast<std::size_t>(first - segment_first) });
+
+            segments.push_back({ reinterpret_cast<const std::uint8_t*>(std::data(value)), value_size });
+            segment_first = first;
+
+            return true;
+        }
+    };
+
+    auto* last = detail::SerializeItems(message.body, std::data(scratch), encoding, gather);
+    if (!last) {
+        scratch.clear();
+        segments.clear();
+
+        return 0;
+    }
+
+    if (last != segment_first)
+        segments.push_back({ segment_first, static_cast<std::size_t>(last - segment_first) });
+
+    scratch.resize(static_cast<std::size_t>(last - std::data(scratch)));
+
+    return total_size;
+}
+
+std::optional<Message> Message::Deserialize(const std::uint8_t* data, std::size_t size, Encoding encoding, std::pmr::memory_resource* resource)
 {
-    auto maybe_message = std::make_optional<Message>();
+    auto maybe_message = std::make_optional<Message>(allocator_type { resource });
     auto& message = *maybe_message;
 
-    if (!buffer.empty()) {
-        auto first = std::data(buffer);
-        const auto last = first + std::size(buffer);
+    if (size != 0 && encoding == Encoding::kV2) {
+        if (!detail::DeserializeItemsV2(message.body, data, data + size))
+            maybe_message.reset();
+    } else if (size != 0) {
+        auto first = data;
+        const auto last = first + size;
 
         const auto item_count = detail::DeserializeInt<std::uint8_t>(first);
         message.body.reserve(item_count);
@@ -358,12 +792,16 @@ std::optional<Message> Message::Deserialize(const std::vector<std::uint8_t>& buf
         ++first;
 
         while (first < last) {
-            auto [item, size] = detail::Decode(*first);
+            auto [item, size] = detail::Decode(*first, resource);
             if (item.index() == 0)
                 break;
 
             ++first;
 
+            // Truncated item or one claiming more data than is left
+            if (!detail::PeekItemSize(item, size, first, last))
+                return std::nullopt;
+
             const auto read = std::visit([first, size = size](auto&& value) -> std::size_t {
                 using T = type_traits::remove_cvref_t<decltype(value)>;
 
@@ -389,4 +827,139 @@ std::optional<Message> Message::Deserialize(const std::vector<std::uint8_t>& buf
     }
 
     return maybe_message;
+}
+
+std::optional<MessageView> MessageView::Parse(const std::uint8_t* data, std::size_t size, Message::Encoding encoding)
+{
+    auto maybe_view = std::make_optional<MessageView>();
+    auto& view = *maybe_view;
+
+    view.data_ = data;
+    view.size_ = size;
+    view.encoding_ = encoding;
+
+    if (size > std::numeric_limits<std::uint32_t>::max())
+        return std::nullopt;
+
+    if (size != 0 && encoding == Message::Encoding::kV2) {
+        auto first = data;
+        const auto last = first + size;
+
+        std::uint64_t item_count;
+        if (!(first = varint::Decode(first, last, item_count)))
+            return std::nullopt;
+
+        view.offsets_.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(item_count, static_cast<std::size_t>(last - first) / 2)));
+
+        for (std::uint64_t i = 0; i < item_count; ++i) {
+            const auto offset = static_cast<std::uint32_t>(first - data);
+
+            std::size_t type;
+            if (!(first = detail::DeserializeTypeCodeV2(first, last, type)))
+                return std::nullopt;
+
+            first = type_traits::visit_alternative<Message::Item, const std::uint8_t*>(type, [first, last](auto identity) {
+                return detail::SkipValueV2<typename decltype(identity)::type>(first, last);
+            });
+
+            if (!first)
+                return std::nullopt;
+
+            view.offsets_.emplace_back(offset);
+        }
+
+        if (first != last)
+            maybe_view.reset();
+    } else if (size != 0) {
+        auto first = data;
+        const auto last = first + size;
+
+        const auto item_count = detail::DeserializeInt<std::uint8_t>(first);
+        view.offsets_.reserve(item_count);
+
+        ++first;
+
+        while (first < last) {
+            const auto offset = static_cast<std::uint32_t>(first - data);
+            const auto [item, array_size] = detail::Decode(*first);
+            if (item.index() == 0)
+                break;
+
+            ++first;
+
+            const auto read = detail::PeekItemSize(item, array_size, first, last);
+            if (!read)
+                return std::nullopt;
+
+            view.offsets_.emplace_back(offset);
+            first += *read;
+        }
+
+        if (first != last)
+            maybe_view.reset();
+    }
+
+    return maybe_view;
+}
+
+MessageView::Item MessageView::operator[](std::size_t index) const
+{
+    assert(index < std::size(offsets_));
+
+    const auto* first = data_ + offsets_[index];
+
+    if (encoding_ == Message::Encoding::kV2) {
+        // Already validated by Parse()
+        const auto* last = data_ + size_;
+
+        std::size_t type { 0 };
+        first = detail::DeserializeTypeCodeV2(first, last, type);
+
+        return type_traits::visit_alternative<Message::Item, Item>(type, [first, last](auto identity) -> Item {
+            using T = typename decltype(identity)::type;
+
+            if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
+                T value {};
+                detail::DeserializeValueV2(first, last, value);
+
+                return Item { std::in_place_type<T>, value };
+            } else if constexpr (detail::is_array_like<T>) {
+                std::size_t container_size { 0 };
+                const auto* ptr = detail::DeserializeArraySizeV2(first, last, sizeof(typename T::value_type), container_size);
+
+                if constexpr (std::is_same_v<T, std::pmr::string>)
+                    return Item { std::in_place_type<std::string_view>, reinterpret_cast<const char*>(ptr), container_size };
+                else
+                    return Item { std::in_place_type<ArrayView<typename T::value_type>>, ptr, container_size };
+            } else {
+                return Item {};
+            }
+        });
+    }
+
+    const auto [item, array_size] = detail::Decode(*first);
+
+    ++first;
+
+    return std::visit([first, array_size = array_size](auto&& value) -> Item {
+        using T = type_traits::remove_cvref_t<decltype(value)>;
+
+        if constexpr (std::is_integral_v<T>) {
+            return Item { std::in_place_type<T>, detail::DeserializeInt<T>(first) };
+        } else if constexpr (std::is_same_v<T, std::pmr::string>) {
+            const auto container_size = detail::DeserializeArraySize(first, array_size);
+            const auto* ptr = reinterpret_cast<const char*>(first + array_size);
+
+            return Item { std::in_place_type<std::string_view>, ptr, container_size };
+        } else if constexpr (detail::is_array_like<T>) {
+            using View = ArrayView<typename T::value_type>;
+
+            const auto container_size = detail::DeserializeArraySize(first, array_size);
+
+            return Item { std::in_place_type<View>, first + array_size, container_size };
+        } else {
+            return Item {};
+        }
+    },
+        item);
 }
\ No newline at end of file
@@ -1,81 +1,166 @@
 #ifndef MESSAGE_H_
 #define MESSAGE_H_
 
+#include <cstddef>
 #include <cstdint>
 
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "endpoint.h"
+#include "message_body.h"
 #include "util/type_traits.h"
 
 struct Message {
-    using Item = std::variant<
-        /* Default type */ std::monostate,
-        /* Integer type */ bool, char, std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t,
-        /* Array type   */ std::vector<std::uint8_t>, std::vector<int>, std::string>;
-    using Items = std::vector<Item>;
+    using Item = MessageBody::Item;
+    using Items = MessageBody;
 
-    // Number of types is limited due to encoding
-    static_assert(std::variant_size_v<Item> <= 0x0F);
+    // Body and every array item are allocated from the same memory resource
+    using allocator_type = MessageBody::allocator_type;
+
+    enum class Encoding {
+        // Fixed width integers and 4-bit type code, float and double are not supported
+        //  - A body holding them fails to serialize, see Serialize
+        kV1,
+        // Varint integers and extensible type code
+        kV2,
+    };
 
     Message() = default;
 
-    template <typename Id, typename... Values>
-    Message(Id id, Values&&... values)
+    explicit Message(const allocator_type& allocator)
+        : body { allocator }
     {
-        static_assert(std::is_integral_v<Id> || std::is_enum_v<Id>);
+    }
 
+    template <typename Id, typename... Values, std::enable_if_t<std::is_integral_v<Id> || std::is_enum_v<Id>, int> = 0>
+    Message(Id id, Values&&... values)
+    {
         auto& self = *this;
 
         self.id = static_cast<std::uint16_t>(id);
-        self.body.reserve(sizeof...(values));
 
-        (self << ... << std::forward<Values>(values));
+        if constexpr (sizeof...(values) != 0) {
+            self.body.reserve(sizeof...(values));
+
+            (self << ... << std::forward<Values>(values));
+        }
+    }
+
+    allocator_type get_allocator() const
+    {
+        return body.get_allocator();
     }
 
+    // std::string and std::vector are copied into the message's memory resource
     template <typename Value>
     friend Message& operator<<(Message& message, Value&& value)
     {
         using T = type_traits::remove_cvref_t<Value>;
-        static_assert(std::is_constructible_v<Item, T> || std::is_constructible_v<std::string, T> || std::is_enum_v<T>);
 
-        if constexpr (std::is_constructible_v<std::string, T>) {
-            message.body.emplace_back(std::in_place_type<std::string>, std::forward<Value>(value));
+        auto* resource = message.body.get_allocator().resource();
+
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            if constexpr (std::is_same_v<T, std::pmr::string> && std::is_rvalue_reference_v<Value&&>)
+                message.body.emplace_back(std::in_place_type<std::pmr::string>, std::move(value), resource);
+            else
+                message.body.emplace_back(std::in_place_type<std::pmr::string>, std::string_view { value }, resource);
+        } else if constexpr (type_traits::is_vector_v<T>) {
+            using Vector = std::pmr::vector<typename T::value_type>;
+            static_assert(std::is_constructible_v<Item, Vector>);
+
+            if constexpr (std::is_same_v<T, Vector> && std::is_rvalue_reference_v<Value&&>)
+                message.body.emplace_back(std::in_place_type<Vector>, std::move(value), resource);
+            else
+                message.body.emplace_back(std::in_place_type<Vector>, std::cbegin(value), std::cend(value), resource);
         } else if constexpr (std::is_enum_v<T>) {
             using Int = std::underlying_type_t<T>;
             message.body.emplace_back(std::in_place_type<Int>, static_cast<Int>(value));
         } else {
+            static_assert(std::is_constructible_v<Item, T>);
             message.body.emplace_back(std::in_place_type<T>, std::forward<Value>(value));
         }
 
         return message;
     }
 
+    // Value can be either std or std::pmr container
     template <typename Value>
     friend Message& operator>>(Message& message, Value& value)
     {
-        static_assert(std::is_constructible_v<Item, Value> || std::is_enum_v<Value>);
-
-        if constexpr (std::is_enum_v<Value>) {
+        if constexpr (std::is_same_v<Value, std::string> || std::is_same_v<Value, std::pmr::string>) {
+            auto str = message.body.Extract<std::pmr::string>();
+
+            if constexpr (std::is_same_v<Value, std::pmr::string>)
+                value = std::move(str);
+            else
+                value.assign(std::cbegin(str), std::cend(str));
+        } else if constexpr (type_traits::is_vector_v<Value>) {
+            using Vector = std::pmr::vector<typename Value::value_type>;
+            auto vec = message.body.Extract<Vector>();
+
+            if constexpr (std::is_same_v<Value, Vector>)
+                value = std::move(vec);
+            else
+                value.assign(std::cbegin(vec), std::cend(vec));
+        } else if constexpr (std::is_enum_v<Value>) {
             using Int = std::underlying_type_t<Value>;
-            value = static_cast<Value>(std::get<Int>(std::move(message.body.back())));
+            value = static_cast<Value>(message.body.Extract<Int>());
         } else {
-            value = std::get<Value>(std::move(message.body.back()));
+            static_assert(std::is_constructible_v<Item, Value>);
+            value = message.body.Extract<Value>();
         }
 
-        message.body.pop_back();
-
         return message;
     }
 
-    static std::vector<std::uint8_t> Serialize(const Message& message);
-    static std::optional<Message> Deserialize(const std::vector<std::uint8_t>& buffer);
+    // Contiguous piece of a serialized message, can be copied into struct iovec
+    struct Segment {
+        const std::uint8_t* data;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t kGatherThreshold { 1024 };
+
+    // A body with an item the encoding can't carry, float or double in kV1 or std::monostate, fails
+    //  - Serialize then returns an empty buffer, SerializeTo std::nullopt and SerializeGather 0
+    //  - SerializedSize doesn't check it
+    static std::size_t SerializedSize(const Message& message, Encoding encoding = Encoding::kV1);
+    static std::vector<std::uint8_t> Serialize(const Message& message, Encoding encoding = Encoding::kV1);
+    static std::pmr::vector<std::uint8_t> Serialize(const Message& message, std::pmr::memory_resource* resource, Encoding encoding = Encoding::kV1);
+
+    // Write into [first, first + size), return written size or std::nullopt if it doesn't fit
+    static std::optional<std::size_t> SerializeTo(const Message& message, std::uint8_t* first, std::size_t size, Encoding encoding = Encoding::kV1);
+
+    // Split into segments without copying string and byte array data larger than threshold
+    //  - Other data is written into scratch
+    //  - Segments refer to both message and scratch, which must not be modified until sent
+    //  - Returns total size of segments
+    static std::size_t SerializeGather(const Message& message, std::vector<std::uint8_t>& scratch, std::vector<Segment>& segments, std::size_t threshold = kGatherThreshold, Encoding encoding = Encoding::kV1);
+
+    // Encoding isn't recorded in the buffer, so it must match the one used for serialization
+    static std::optional<Message> Deserialize(const std::uint8_t* data, std::size_t size, Encoding encoding, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    static std::optional<Message> Deserialize(const std::vector<std::uint8_t>& buffer, Encoding encoding, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    {
+        return Deserialize(std::data(buffer), std::size(buffer), encoding, resource);
+    }
+
+    static std::optional<Message> Deserialize(const std::vector<std::uint8_t>& buffer, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    {
+        return Deserialize(std::data(buffer), std::size(buffer), Encoding::kV1, resource);
+    }
+
+    Endpoint from;
+    Endpoint to;
 
-    std::string from;
-    std::string to;
+    // body.Share() makes copies O(1) and caches Serialize() on the shared block
     Items body;
     std::uint16_t id { 0 };
 };
@@ -0,0 +1,223 @@
+#include "message_body.h"
+
+#include <cstring>
+
+#include <limits>
+
+namespace {
+
+constexpr std::size_t BlockSize(std::size_t capacity)
+{
+    return capacity * (sizeof(std::uint64_t) + sizeof(std::uint8_t));
+}
+
+} // namespace
+
+MessageBody::MessageBody(const MessageBody& other, const allocator_type& allocator)
+    : MessageBody { allocator }
+{
+    Assign(other);
+}
+
+MessageBody::MessageBody(MessageBody&& other) noexcept
+    : local_ {}
+    , size_ { other.size_ }
+    , capacity_ { other.capacity_ }
+    , arrays_ { std::move(other.arrays_) }
+    , shared_ { std::move(other.shared_) }
+{
+    if (other.IsLocal()) {
+        local_ = other.local_;
+    } else {
+        heap_ = other.heap_;
+        other.local_ = {};
+        other.capacity_ = kInlineCapacity;
+    }
+
+    other.size_ = 0;
+}
+
+MessageBody::~MessageBody()
+{
+    Deallocate();
+}
+
+MessageBody& MessageBody::operator=(const MessageBody& other)
+{
+    if (this != &other)
+        Assign(other);
+
+    return *this;
+}
+
+MessageBody& MessageBody::operator=(MessageBody&& other)
+{
+    if (this == &other)
+        return *this;
+
+    // Memory from another resource can't be taken over
+    if (get_allocator() != other.get_allocator()) {
+        Assign(std::move(other));
+        other.clear();
+
+        return *this;
+    }
+
+    Deallocate();
+
+    if (other.IsLocal()) {
+        local_ = other.local_;
+    } else {
+        heap_ = other.heap_;
+        capacity_ = other.capacity_;
+
+        other.local_ = {};
+        other.capacity_ = kInlineCapacity;
+    }
+
+    size_ = other.size_;
+    arrays_ = std::move(other.arrays_);
+    shared_ = std::move(other.shared_);
+
+    other.size_ = 0;
+    other.arrays_.clear();
+
+    return *this;
+}
+
+void MessageBody::reserve(std::size_t capacity)
+{
+    Unshare();
+
+    if (capacity <= capacity_)
+        return;
+
+    assert(capacity <= std::numeric_limits<std::uint32_t>::max());
+
+    auto* resource = get_allocator().resource();
+    auto* block = static_cast<std::uint64_t*>(resource->allocate(BlockSize(capacity), alignof(std::uint64_t)));
+
+    std::memcpy(block, Values(), size_ * sizeof(std::uint64_t));
+    std::memcpy(block + capacity, Tags(), size_);
+
+    Deallocate();
+
+    heap_ = block;
+    capacity_ = static_cast<std::uint32_t>(capacity);
+}
+
+void MessageBody::clear() noexcept
+{
+    size_ = 0;
+    arrays_.clear();
+    shared_.reset();
+}
+
+void MessageBody::pop_back()
+{
+    Unshare();
+
+    assert(size_ != 0);
+
+    if (IsArray(Tags()[--size_]))
+        arrays_.pop_back();
+}
+
+void MessageBody::emplace_back(Item&& item)
+{
+    std::visit([this](auto&& value) {
+        using T = type_traits::remove_cvref_t<decltype(value)>;
+
+        if constexpr (IsArray(type_traits::variant_index_v<T, Item>))
+            emplace_back(std::in_place_type<T>, std::move(value), get_allocator().resource());
+        else
+            emplace_back(std::in_place_type<T>, value);
+    },
+        std::move(item));
+}
+
+void MessageBody::Share()
+{
+    if (shared_)
+        return;
+
+    // Leaves this body empty, keeping its resource for later changes
+    shared_ = std::make_shared<const Shared>(std::move(*this));
+}
+
+void MessageBody::CopyShared()
+{
+    const auto shared = std::move(shared_);
+    Assign(shared->body);
+}
+
+bool operator==(const MessageBody& lhs_body, const MessageBody& rhs_body)
+{
+    if (lhs_body.shared_ && lhs_body.shared_ == rhs_body.shared_)
+        return true;
+
+    const auto& lhs = lhs_body.Self();
+    const auto& rhs = rhs_body.Self();
+
+    if (lhs.size_ != rhs.size_ || std::memcmp(lhs.Tags(), rhs.Tags(), lhs.size_) != 0)
+        return false;
+
+    for (std::size_t i = 0; i < lhs.size_; ++i) {
+        if (!MessageBody::IsArray(lhs.Tags()[i]) && lhs.Values()[i] != rhs.Values()[i])
+            return false;
+    }
+
+    return lhs.arrays_ == rhs.arrays_;
+}
+
+void MessageBody::Deallocate() noexcept
+{
+    if (IsLocal())
+        return;
+
+    get_allocator().resource()->deallocate(heap_, BlockSize(capacity_), alignof(std::uint64_t));
+
+    local_ = {};
+    capacity_ = kInlineCapacity;
+}
+
+template <typename Body>
+void MessageBody::Assign(Body&& other)
+{
+    clear();
+
+    // Shared block is taken as is, whatever the resource
+    if (other.shared_) {
+        if constexpr (std::is_rvalue_reference_v<Body&&>)
+            shared_ = std::move(other.shared_);
+        else
+            shared_ = other.shared_;
+
+        return;
+    }
+
+    reserve(other.size_);
+
+    std::memcpy(Values(), other.Values(), other.size_ * sizeof(std::uint64_t));
+    std::memcpy(Tags(), other.Tags(), other.size_);
+
+    size_ = other.size_;
+
+    // Array positions stay the same as arrays_ is rebuilt in order
+    auto* resource = get_allocator().resource();
+    arrays_.reserve(std::size(other.arrays_));
+
+    for (auto& array : other.arrays_) {
+        std::visit([this, resource](auto&& value) {
+            using T = type_traits::remove_cvref_t<decltype(value)>;
+
+            if constexpr (IsArray(type_traits::variant_index_v<T, Item>)) {
+                if constexpr (std::is_rvalue_reference_v<Body&&>)
+                    arrays_.emplace_back(std::in_place_type<T>, std::move(value), resource);
+                else
+                    arrays_.emplace_back(std::in_place_type<T>, value, resource);
+            }
+        },
+            array);
+    }
+}
\ No newline at end of file
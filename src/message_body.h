@@ -0,0 +1,305 @@
+#ifndef MESSAGE_BODY_H_
+#define MESSAGE_BODY_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "util/type_traits.h"
+
+// Items of a Message, packed by kind
+//  - Each item is an 8-bit tag and a 64-bit value, up to kInlineCapacity items need no allocation
+//  - Integer and floating point items are stored in the value itself
+//  - Array items live out of line in arrays_, value holds their position
+//  - Share() freezes the items into a refcounted block, copies then share it until one of them is changed
+class MessageBody {
+public:
+    using Item = std::variant<
+        /* Default type */ std::monostate,
+        /* Integer type */ bool, char, std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t,
+        /* Array type   */ std::pmr::vector<std::uint8_t>, std::pmr::vector<int>, std::pmr::string,
+        /* Float type   */ float, double>;
+
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    static constexpr std::size_t kInlineCapacity { 4 };
+
+    // Serialized forms cached on a shared body, one per Message::Encoding
+    static constexpr std::size_t kCacheSlots { 2 };
+
+    static constexpr std::size_t kFirstArrayIndex { type_traits::variant_index_v<std::pmr::vector<std::uint8_t>, Item> };
+    static constexpr std::size_t kLastArrayIndex { type_traits::variant_index_v<std::pmr::string, Item> };
+
+    // Only array items are stored out of line
+    static constexpr bool IsArray(std::size_t index) noexcept
+    {
+        return index >= kFirstArrayIndex && index <= kLastArrayIndex;
+    }
+
+    MessageBody() noexcept
+        : MessageBody { allocator_type {} }
+    {
+    }
+
+    explicit MessageBody(const allocator_type& allocator) noexcept
+        : local_ {}
+        , arrays_ { allocator }
+    {
+    }
+
+    // Like std::pmr containers, copies use the default resource unless one is given
+    MessageBody(const MessageBody& other)
+        : MessageBody { other, allocator_type {} }
+    {
+    }
+
+    MessageBody(const MessageBody& other, const allocator_type& allocator);
+    MessageBody(MessageBody&& other) noexcept;
+    ~MessageBody();
+
+    MessageBody& operator=(const MessageBody& other);
+    MessageBody& operator=(MessageBody&& other);
+
+    allocator_type get_allocator() const noexcept { return arrays_.get_allocator(); }
+
+    std::size_t size() const noexcept { return Self().size_; }
+    std::size_t capacity() const noexcept { return Self().capacity_; }
+    bool empty() const noexcept { return Self().size_ == 0; }
+
+    void reserve(std::size_t capacity);
+    void clear() noexcept;
+    void pop_back();
+
+    // Copying a shared body only copies a pointer, thread-safe as the block is never modified
+    //  - Any change copies the items back into get_allocator() first
+    void Share();
+    bool IsShared() const noexcept { return shared_ != nullptr; }
+
+    // Result of make(const MessageBody&) kept on the shared block, made at most once per slot
+    //  - nullptr if the body isn't shared or make returned std::nullopt
+    template <typename F>
+    const std::vector<std::uint8_t>* GetCached(std::size_t slot, F&& make) const;
+
+    // Array items must already use get_allocator()
+    template <typename T, typename... Args>
+    void emplace_back(std::in_place_type_t<T>, Args&&... args)
+    {
+        constexpr auto kIndex = type_traits::variant_index_v<T, Item>;
+        static_assert(kIndex != std::variant_npos);
+
+        Unshare();
+
+        if (size_ == capacity_)
+            reserve(capacity_ * 2);
+
+        if constexpr (IsArray(kIndex)) {
+            Values()[size_] = std::size(arrays_);
+            arrays_.emplace_back(std::in_place_type<T>, std::forward<Args>(args)...);
+        } else {
+            Values()[size_] = ToValue(T(std::forward<Args>(args)...));
+        }
+
+        Tags()[size_] = static_cast<std::uint8_t>(kIndex);
+        ++size_;
+    }
+
+    void emplace_back(Item&& item);
+
+    // Position of the item's type in Item
+    std::size_t GetIndex(std::size_t index) const
+    {
+        const auto& self = Self();
+        assert(index < self.size_);
+
+        return self.Tags()[index];
+    }
+
+    // Call f with the item as its own type, scalars are passed by value
+    template <typename F>
+    decltype(auto) Visit(std::size_t index, F&& f) const
+    {
+        const auto& self = Self();
+        assert(index < self.size_);
+
+        const auto tag = self.Tags()[index];
+        const auto value = self.Values()[index];
+
+        if (IsArray(tag))
+            return std::visit(std::forward<F>(f), self.arrays_[value]);
+
+        return VisitScalar(tag, value, std::forward<F>(f));
+    }
+
+    // Remove the last item and return it, throws std::bad_variant_access if it isn't a T
+    template <typename T>
+    T Extract()
+    {
+        constexpr auto kIndex = type_traits::variant_index_v<T, Item>;
+        static_assert(kIndex != std::variant_npos && kIndex != 0);
+
+        // Checked before unsharing, so a failed Extract copies nothing
+        {
+            const auto& self = Self();
+            assert(self.size_ != 0);
+
+            if (self.Tags()[self.size_ - 1] != kIndex)
+                throw std::bad_variant_access {};
+        }
+
+        Unshare();
+        --size_;
+
+        if constexpr (IsArray(kIndex)) {
+            auto value = std::get<T>(std::move(arrays_.back()));
+            arrays_.pop_back();
+
+            return value;
+        } else {
+            return FromValue<T>(Values()[size_]);
+        }
+    }
+
+    friend bool operator==(const MessageBody& lhs, const MessageBody& rhs);
+    friend bool operator!=(const MessageBody& lhs, const MessageBody& rhs) { return !(lhs == rhs); }
+
+private:
+    struct Shared;
+
+    struct Local {
+        std::array<std::uint64_t, kInlineCapacity> values;
+        std::array<std::uint8_t, kInlineCapacity> tags;
+    };
+
+    // Floating point items keep their bit pattern
+    template <typename T>
+    static std::uint64_t ToValue(T value) noexcept
+    {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            return 0;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(T));
+
+            return bits;
+        } else {
+            return static_cast<std::uint64_t>(value);
+        }
+    }
+
+    template <typename T>
+    static T FromValue(std::uint64_t value) noexcept
+    {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            return T {};
+        } else if constexpr (std::is_floating_point_v<T>) {
+            T result;
+            std::memcpy(&result, &value, sizeof(T));
+
+            return result;
+        } else {
+            return static_cast<T>(value);
+        }
+    }
+
+    template <std::size_t I = 0, typename F>
+    static decltype(auto) VisitScalar(std::uint8_t tag, std::uint64_t value, F&& f)
+    {
+        using T = std::variant_alternative_t<I, Item>;
+
+        if constexpr (IsArray(I)) {
+            return VisitScalar<I + 1>(tag, value, std::forward<F>(f));
+        } else {
+            if constexpr (I + 1 < std::variant_size_v<Item>) {
+                if (tag != I)
+                    return VisitScalar<I + 1>(tag, value, std::forward<F>(f));
+            }
+
+            return std::forward<F>(f)(FromValue<T>(value));
+        }
+    }
+
+    bool IsLocal() const noexcept { return capacity_ == kInlineCapacity; }
+
+    // Items are read from here, the shared block's body or this one
+    const MessageBody& Self() const noexcept;
+
+    void Unshare()
+    {
+        if (shared_)
+            CopyShared();
+    }
+
+    void CopyShared();
+
+    // Heap block holds capacity_ values followed by capacity_ tags
+    std::uint64_t* Values() noexcept { return IsLocal() ? std::data(local_.values) : heap_; }
+    const std::uint64_t* Values() const noexcept { return IsLocal() ? std::data(local_.values) : heap_; }
+    std::uint8_t* Tags() noexcept { return IsLocal() ? std::data(local_.tags) : reinterpret_cast<std::uint8_t*>(heap_ + capacity_); }
+    const std::uint8_t* Tags() const noexcept { return IsLocal() ? std::data(local_.tags) : reinterpret_cast<const std::uint8_t*>(heap_ + capacity_); }
+
+    void Deallocate() noexcept;
+
+    // Copy or move every item of other, keeping this resource
+    template <typename Body>
+    void Assign(Body&& other);
+
+    union {
+        Local local_;
+        std::uint64_t* heap_;
+    };
+
+    std::uint32_t size_ { 0 };
+    std::uint32_t capacity_ { kInlineCapacity };
+
+    // Only array alternatives, in item order
+    std::pmr::vector<Item> arrays_;
+
+    // Items live here instead while shared, this body's own storage is then empty
+    std::shared_ptr<const Shared> shared_;
+};
+
+struct MessageBody::Shared {
+    explicit Shared(MessageBody&& body) noexcept
+        : body { std::move(body) }
+    {
+    }
+
+    const MessageBody body;
+
+    mutable std::array<std::once_flag, kCacheSlots> once;
+    mutable std::array<std::optional<std::vector<std::uint8_t>>, kCacheSlots> cache;
+};
+
+inline const MessageBody& MessageBody::Self() const noexcept
+{
+    return shared_ ? shared_->body : *this;
+}
+
+template <typename F>
+const std::vector<std::uint8_t>* MessageBody::GetCached(std::size_t slot, F&& make) const
+{
+    assert(slot < kCacheSlots);
+
+    if (!shared_)
+        return nullptr;
+
+    const auto& shared = *shared_;
+
+    std::call_once(shared.once[slot], [&shared, slot, &make] { shared.cache[slot] = std::forward<F>(make)(shared.body); });
+
+    return shared.cache[slot] ? &*shared.cache[slot] : nullptr;
+}
+
+#endif // MESSAGE_BODY_H_
\ No newline at end of file
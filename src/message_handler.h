@@ -5,6 +5,8 @@
 #include <utility>
 
 #include "message.h"
+#include "message_pool.h"
+#include "util/type_traits.h"
 
 class MessageHandler {
 public:
@@ -19,10 +21,30 @@ public:
         pimpl_->Post(std::move(message));
     }
 
+    // Messages in [first, last) are moved from
+    void PostBatch(Message* first, Message* last)
+    {
+        pimpl_->PostBatch(first, last);
+    }
+
+    // Message shared with other receivers, e.g. by MessageRouter::Publish
+    void PostShared(const std::shared_ptr<const Message>& message)
+    {
+        pimpl_->PostShared(message);
+    }
+
 private:
+    template <typename T>
+    using PostBatchOp = decltype(std::declval<T&>().PostBatch(std::declval<Message*>(), std::declval<Message*>()));
+
+    template <typename T>
+    using PostSharedOp = decltype(std::declval<T&>().PostShared(std::declval<const std::shared_ptr<const Message>&>()));
+
     struct HandlerConcept {
         virtual ~HandlerConcept() = default;
         virtual void Post(Message&& message) = 0;
+        virtual void PostBatch(Message* first, Message* last) = 0;
+        virtual void PostShared(const std::shared_ptr<const Message>& message) = 0;
     };
 
     template <typename T>
@@ -38,6 +60,30 @@ private:
             object.Post(std::move(message));
         }
 
+        // Fall back to Post if the handler has no batch interface
+        void PostBatch(Message* first, Message* last) override
+        {
+            if constexpr (type_traits::is_detected_v<PostBatchOp, T>) {
+                object.PostBatch(first, last);
+            } else {
+                for (; first != last; ++first)
+                    object.Post(std::move(*first));
+            }
+        }
+
+        // Fall back to Post with a copy if the handler can't take a shared message
+        void PostShared(const std::shared_ptr<const Message>& message) override
+        {
+            if constexpr (type_traits::is_detected_v<PostSharedOp, T>) {
+                object.PostShared(message);
+            } else {
+                auto copy = MessagePool::Acquire();
+                copy = *message;
+
+                object.Post(std::move(copy));
+            }
+        }
+
         T object;
     };
 
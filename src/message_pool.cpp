@@ -0,0 +1,48 @@
+#include "message_pool.h"
+
+#include <vector>
+
+namespace {
+
+std::vector<Message>& LocalFreeList()
+{
+    thread_local std::vector<Message> messages;
+    return messages;
+}
+
+} // namespace
+
+Message MessagePool::Acquire()
+{
+    auto& messages = LocalFreeList();
+
+    if (messages.empty())
+        return Message { Message::allocator_type { GetResource() } };
+
+    auto message = std::move(messages.back());
+    messages.pop_back();
+
+    return message;
+}
+
+void MessagePool::Release(Message&& message)
+{
+    auto& messages = LocalFreeList();
+
+    if (std::size(messages) >= kCapacity || message.get_allocator().resource() != GetResource())
+        return;
+
+    // Array items go back to the resource, body keeps its capacity
+    message.body.clear();
+    message.from = {};
+    message.to = {};
+    message.id = 0;
+
+    messages.push_back(std::move(message));
+}
+
+std::pmr::memory_resource* MessagePool::GetResource()
+{
+    static auto* resource = new std::pmr::synchronized_pool_resource;
+    return resource;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef MESSAGE_POOL_H_
+#define MESSAGE_POOL_H_
+
+#include <cstddef>
+
+#include <memory_resource>
+
+#include "message.h"
+
+// Recycles Message objects, so their body keeps its capacity between uses
+//  - Each thread keeps up to kCapacity released messages, more are destroyed
+//  - Every pooled message allocates from a shared synchronized_pool_resource,
+//    so memory freed on one thread is reused by others without going through malloc
+class MessagePool {
+public:
+    static constexpr std::size_t kCapacity { 64 };
+
+    // Empty message from this thread's free list, or a new one using GetResource()
+    static Message Acquire();
+
+    // Message is cleared before it is kept
+    //  - Destroyed instead if the free list is full or it uses another resource
+    static void Release(Message&& message);
+
+    // Never destroyed, messages may outlive static destruction in thread_local storage
+    static std::pmr::memory_resource* GetResource();
+};
+
+#endif // MESSAGE_POOL_H_
\ No newline at end of file
@@ -1,28 +1,890 @@
 #include "message_router.h"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "message_pool.h"
+#include "util/spin.h"
+
+namespace {
+
+// Move count elements from the front or the back of queue to out
+template <typename T>
+void TakeFront(std::deque<T>& queue, std::size_t count, std::vector<T>& out)
+{
+    const auto last = std::begin(queue) + static_cast<std::ptrdiff_t>(count);
+
+    std::move(std::begin(queue), last, std::back_inserter(out));
+    queue.erase(std::begin(queue), last);
+}
+
+template <typename T>
+void TakeBack(std::deque<T>& queue, std::size_t count, std::vector<T>& out)
+{
+    const auto first = std::end(queue) - static_cast<std::ptrdiff_t>(count);
+
+    std::move(first, std::end(queue), std::back_inserter(out));
+    queue.erase(first, std::end(queue));
+}
+
+// Route whose handler the current worker is running, so Unregister within it doesn't wait for itself
+thread_local const void* current_route { nullptr };
+
+} // namespace
+
+MessageRouter::MessageRouter()
+{
+    auto worker_count = worker_count_.load(std::memory_order_relaxed);
+    if (worker_count == 0)
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(worker_count);
+
+    // Spinning only pays off if a producer can run on another core meanwhile
+    const auto spin = std::thread::hardware_concurrency() > 1 ? kMinSpin : 0;
+
+    for (std::size_t i = 0; i < worker_count; ++i)
+        workers_.emplace_back(std::make_unique<Worker>())->spin = spin;
+
+    for (std::size_t i = 0; i < worker_count; ++i)
+        workers_[i]->thread = std::thread { &MessageRouter::Run, this, std::ref(*workers_[i]), i };
+}
+
 MessageRouter::~MessageRouter()
 {
-    TaskerBase::Stop();
+    for (auto& worker : workers_) {
+        std::lock_guard lock { worker->mutex };
+
+        done_.store(true, std::memory_order_relaxed);
+        worker->cv.notify_one();
+    }
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+void MessageRouter::SetWorkerCount(std::size_t count)
+{
+    worker_count_.store(count, std::memory_order_relaxed);
+}
+
+bool MessageRouter::Post(Message message)
+{
+    return Post(std::move(message), true);
+}
+
+bool MessageRouter::TryPost(Message message)
+{
+    return Post(std::move(message), false);
+}
+
+std::size_t MessageRouter::PostBatch(Message* first, Message* last)
+{
+    return PostBatch(first, last, true);
+}
+
+std::size_t MessageRouter::TryPostBatch(Message* first, Message* last)
+{
+    return PostBatch(first, last, false);
+}
+
+void MessageRouter::Register(Endpoint endpoint, MessageHandler handler, Delivery delivery)
+{
+    Register(endpoint, std::move(handler), delivery, QueueOptions {});
+}
+
+void MessageRouter::Register(Endpoint endpoint, MessageHandler handler, Delivery delivery, QueueOptions options)
+{
+    const auto id = endpoint.GetId();
+    auto route = std::make_shared<Route>(endpoint, std::move(handler), delivery, options);
+
+    handlers_.Update([id, &route](HandlerTable& handlers) {
+        if (id >= std::size(handlers))
+            handlers.resize(id + 1);
+        else if (handlers[id])
+            return false;
+
+        handlers[id] = std::move(route);
+
+        return true;
+    });
+}
+
+void MessageRouter::Unregister(Endpoint endpoint)
+{
+    const auto id = endpoint.GetId();
+    std::shared_ptr<Route> route;
+
+    handlers_.Update([id, &route](HandlerTable& handlers) {
+        if (id >= std::size(handlers) || !handlers[id])
+            return false;
+
+        // Queued tasks still refer to the route, make them skip delivery
+        handlers[id]->active.store(false, std::memory_order_seq_cst);
+        route = std::move(handlers[id]);
+
+        return true;
+    });
+
+    if (!route)
+        return;
+
+    // Producers blocked on it give up
+    std::unique_lock lock { route->mutex };
+    route->cv.notify_all();
+
+    // Deliveries that saw active before it was cleared finish, a handler unregistering its own endpoint excluded
+    const std::size_t self = current_route == route.get() ? 1 : 0;
+
+    route->cv.wait(lock, [&route, self] { return route->delivering.load(std::memory_order_seq_cst) <= self; });
+}
+
+void MessageRouter::Subscribe(std::string_view pattern, Endpoint endpoint)
+{
+    topics_.Update([pattern, endpoint](TopicTrie<Endpoint>& topics) {
+        return topics.Insert(pattern, endpoint);
+    });
+}
+
+void MessageRouter::Unsubscribe(std::string_view pattern, Endpoint endpoint)
+{
+    topics_.Update([pattern, endpoint](TopicTrie<Endpoint>& topics) {
+        return topics.Erase(pattern, endpoint);
+    });
+}
+
+std::size_t MessageRouter::Publish(std::string_view topic, Message message)
+{
+    std::vector<Endpoint::Id> ids;
+
+    topics_.Read([topic, &ids](const TopicTrie<Endpoint>& topics) {
+        topics.Match(topic, [&ids](Endpoint endpoint) { ids.push_back(endpoint.GetId()); });
+    });
+
+    // Overlapping patterns deliver once
+    std::sort(std::begin(ids), std::end(ids));
+    ids.erase(std::unique(std::begin(ids), std::end(ids)), std::end(ids));
+
+    // Handlers without PostShared get a copy of the shared body, not of its items
+    message.body.Share();
+
+    const auto shared = std::make_shared<const Message>(std::move(message));
+
+    // Grouped by worker, so each one is locked and woken once
+    std::vector<std::vector<Task>> groups(std::size(workers_));
+    std::size_t accepted = 0;
+
+    handlers_.Read([this, &ids, &shared, &groups, &accepted](const HandlerTable& handlers) {
+        auto recorder = metrics_.Record();
+
+#if MESSAGE_ROUTER_METRICS
+        const auto enqueued = RouterMetrics::Now();
+#endif
+
+        for (const auto id : ids) {
+            if (id >= std::size(handlers) || !handlers[id])
+                continue;
+
+            const auto& route = handlers[id];
+
+            if (!Reserve(*route)) {
+                recorder.Dropped(id);
+                continue;
+            }
+
+            recorder.Posted(id);
+            recorder.Queued(id, route->queued.load(std::memory_order_relaxed));
+
+            auto& task = groups[GetWorkerIndex(*route)].emplace_back();
+            task.route = route;
+            task.shared = shared;
+
+#if MESSAGE_ROUTER_METRICS
+            task.enqueued = enqueued;
+#endif
+
+            ++accepted;
+        }
+    });
+
+    bool has_stealable = false;
+
+    for (std::size_t i = 0; i < std::size(groups); ++i) {
+        auto& tasks = groups[i];
+
+        if (!tasks.empty())
+            has_stealable |= Push(*workers_[i], std::data(tasks), std::data(tasks) + std::size(tasks));
+    }
+
+    if (has_stealable && sleeping_count_.load(std::memory_order_seq_cst) != 0)
+        WakeIdleWorker();
+
+    return accepted;
+}
+
+std::vector<RouterMetrics::Stats> MessageRouter::GetStats() const
+{
+    auto stats = metrics_.GetStats();
+
+    handlers_.Read([&stats](const HandlerTable& handlers) {
+        for (auto& endpoint : stats) {
+            const auto id = endpoint.endpoint.GetId();
+
+            if (id < std::size(handlers) && handlers[id])
+                endpoint.queue_depth = handlers[id]->queued.load(std::memory_order_relaxed);
+        }
+    });
+
+    return stats;
+}
+
+void MessageRouter::ResetStats()
+{
+    metrics_.ResetStats();
+}
+
+bool MessageRouter::Post(Message&& message, bool wait)
+{
+    const auto id = message.to.GetId();
+
+    auto route = handlers_.Read([id](const HandlerTable& handlers) -> std::shared_ptr<Route> {
+        return id < std::size(handlers) ? handlers[id] : nullptr;
+    });
+
+    const auto admission = route ? Admit(route, message, wait) : Admission::kRejected;
+
+    {
+        auto recorder = metrics_.Record();
+        Record(recorder, id, admission, route.get());
+    }
+
+    if (admission != Admission::kReserved) {
+        if (admission == Admission::kRejected)
+            MessagePool::Release(std::move(message));
+
+        return admission == Admission::kReplaced;
+    }
+
+    auto& worker = *workers_[GetWorkerIndex(*route)];
+
+#if MESSAGE_ROUTER_METRICS
+    Task task { std::move(route), std::move(message), RouterMetrics::Now() };
+#else
+    Task task { std::move(route), std::move(message) };
+#endif
+
+    if (Push(worker, &task, &task + 1) && sleeping_count_.load(std::memory_order_seq_cst) != 0)
+        WakeIdleWorker();
+
+    return true;
+}
+
+std::size_t MessageRouter::PostBatch(Message* first, Message* last, bool wait)
+{
+    std::vector<Task> tasks;
+    tasks.reserve(static_cast<std::size_t>(last - first));
+
+    // Routes are resolved in one read-side section, admission may block so it's done outside
+    handlers_.Read([first, last, &tasks](const HandlerTable& handlers) {
+        for (auto it = first; it != last; ++it) {
+            const auto id = it->to.GetId();
+            tasks.push_back({ id < std::size(handlers) ? handlers[id] : nullptr, std::move(*it) });
+        }
+    });
+
+    // Grouped by worker, so each one is locked and woken once
+    std::vector<std::vector<Task>> groups(std::size(workers_));
+    std::size_t accepted = 0;
+    bool has_stealable = false;
+
+    auto flush = [this, &groups, &has_stealable] {
+        for (std::size_t i = 0; i < std::size(groups); ++i) {
+            auto& group = groups[i];
+
+            if (!group.empty()) {
+                has_stealable |= Push(*workers_[i], std::data(group), std::data(group) + std::size(group));
+                group.clear();
+            }
+        }
+    };
+
+    auto accept = [this, &groups, &accepted](Task& task, Admission admission, RouterMetrics::Recorder& recorder) {
+        Record(recorder, task.message.to.GetId(), admission, task.route.get());
+
+        if (admission == Admission::kReserved) {
+#if MESSAGE_ROUTER_METRICS
+            task.enqueued = RouterMetrics::Now();
+#endif
+            groups[GetWorkerIndex(*task.route)].push_back(std::move(task));
+        } else if (admission == Admission::kRejected) {
+            MessagePool::Release(std::move(task.message));
+            return;
+        }
+
+        ++accepted;
+    };
+
+    for (auto it = std::begin(tasks); it != std::end(tasks); ++it) {
+        // The shard isn't held while blocked
+        {
+            auto recorder = metrics_.Record();
+
+            for (; it != std::end(tasks); ++it) {
+                const auto admission = it->route ? Admit(it->route, it->message, false) : Admission::kRejected;
+
+                if (admission == Admission::kRejected && wait && it->route && it->route->options.overflow == Overflow::kBlock)
+                    break;
+
+                accept(*it, admission, recorder);
+            }
+        }
+
+        if (it == std::end(tasks))
+            break;
+
+        // Earlier messages of this batch may be the ones filling the queue
+        flush();
+
+        const auto admission = Admit(it->route, it->message, true);
+        auto recorder = metrics_.Record();
+
+        accept(*it, admission, recorder);
+    }
+
+    flush();
+
+    if (has_stealable && sleeping_count_.load(std::memory_order_seq_cst) != 0)
+        WakeIdleWorker();
+
+    return accepted;
+}
+
+MessageRouter::Admission MessageRouter::Admit(const std::shared_ptr<Route>& route, Message& message, bool wait)
+{
+    if (route->options.coalesce && Coalesce(*route, message))
+        return Admission::kReplaced;
+
+    while (!Reserve(*route)) {
+        switch (route->options.overflow) {
+        case Overflow::kBlock:
+            if (!wait || !WaitForRoom(*route))
+                return Admission::kRejected;
+
+            break;
+        case Overflow::kDropNewest:
+            return Admission::kRejected;
+        case Overflow::kDropOldest:
+        case Overflow::kCoalesce:
+            return Replace(route, message) ? Admission::kReplaced : Admission::kRejected;
+        }
+    }
+
+    // Another producer may have stashed the same id since Coalesce
+    if (route->options.coalesce && !Stash(*route, message)) {
+        Dequeue(*route, 1);
+        return Admission::kReplaced;
+    }
+
+    return Admission::kReserved;
+}
+
+bool MessageRouter::Reserve(Route& route)
+{
+    const auto capacity = route.options.capacity;
+
+    if (capacity == QueueOptions::kUnbounded) {
+        route.queued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    auto queued = route.queued.load(std::memory_order_relaxed);
+
+    do {
+        if (queued >= capacity)
+            return false;
+    } while (!route.queued.compare_exchange_weak(queued, queued + 1, std::memory_order_relaxed));
+
+    return true;
+}
+
+// Takes over the slot of a queued task, so the queue depth doesn't change
+//  - Fails if every queued message is already taken by a worker for delivery
+bool MessageRouter::Replace(const std::shared_ptr<Route>& route, Message& message)
+{
+    // Queued tasks of a coalescing route don't own their message
+    if (route->options.coalesce)
+        return false;
+
+    const auto drop_oldest = route->options.overflow == Overflow::kDropOldest;
+
+    auto replace = [&route, &message, drop_oldest](std::deque<Task>& queue) {
+        const auto it = std::find_if(std::begin(queue), std::end(queue), [&route, &message, drop_oldest](const Task& task) {
+            return task.route == route && (drop_oldest || (!task.shared && task.message.id == message.id));
+        });
+
+        if (it == std::end(queue))
+            return false;
+
+        MessagePool::Release(std::move(it->message));
+
+        if (drop_oldest) {
+            // Goes to the back, keeping FIFO order of the handler's messages
+            queue.erase(it);
+
+#if MESSAGE_ROUTER_METRICS
+            queue.push_back({ route, std::move(message), RouterMetrics::Now() });
+#else
+            queue.push_back({ route, std::move(message) });
+#endif
+        } else {
+            it->message = std::move(message);
+        }
+
+        return true;
+    };
+
+    if (route->delivery == Delivery::kOrdered) {
+        std::lock_guard lock { route->strand_mutex };
+
+        // Nodes can't be unlinked from the middle, so dropping the oldest shifts later tasks forward
+        std::optional<Task>* last = nullptr;
+        bool replaced = false;
+
+        route->strand.ForEach([&message, drop_oldest, &last, &replaced](TaskNode& node) {
+            auto& task = *node.task;
+
+            if (drop_oldest) {
+                if (last)
+                    last->emplace(std::move(task));
+                else
+                    MessagePool::Release(std::move(task.message));
+
+                last = &node.task;
+            } else if (!replaced && !task.shared && task.message.id == message.id) {
+                MessagePool::Release(std::exchange(task.message, std::move(message)));
+                replaced = true;
+            }
+        });
+
+        if (last) {
+#if MESSAGE_ROUTER_METRICS
+            last->emplace(Task { route, std::move(message), RouterMetrics::Now() });
+#else
+            last->emplace(Task { route, std::move(message) });
+#endif
+            replaced = true;
+        }
+
+        return replaced;
+    }
+
+    for (auto& worker : workers_) {
+        std::lock_guard lock { worker->mutex };
+
+        if (replace(worker->unordered))
+            return true;
+    }
+
+    return false;
+}
+
+// Replaces the pending message with the same id, if any
+bool MessageRouter::Coalesce(Route& route, Message& message)
+{
+    std::lock_guard lock { route.mutex };
+
+    const auto it = route.pending.find(message.id);
+    if (it == std::end(route.pending))
+        return false;
+
+    MessagePool::Release(std::exchange(it->second, std::move(message)));
+
+    return true;
+}
+
+// Moves message into pending and leaves only its id, to and from to be queued
+//  - Returns false if the id was already pending, the message replaced it instead
+bool MessageRouter::Stash(Route& route, Message& message)
+{
+    std::lock_guard lock { route.mutex };
+
+    // Moves from message only if inserted
+    const auto [it, inserted] = route.pending.try_emplace(message.id, std::move(message));
+
+    if (!inserted)
+        MessagePool::Release(std::exchange(it->second, std::move(message)));
+
+    message.body.clear();
+
+    return inserted;
+}
+
+// Swaps every queued id for the latest message posted with it
+void MessageRouter::Unstash(Route& route, std::vector<Message>& batch)
+{
+    std::lock_guard lock { route.mutex };
+
+    for (auto& message : batch) {
+        const auto it = route.pending.find(message.id);
+
+        if (it != std::end(route.pending)) {
+            message = std::move(it->second);
+            route.pending.erase(it);
+        }
+    }
+}
+
+// Returns false once the route is unregistered
+bool MessageRouter::WaitForRoom(Route& route)
+{
+    route.waiting.fetch_add(1, std::memory_order_seq_cst);
+
+    {
+        std::unique_lock lock { route.mutex };
+
+        route.cv.wait(lock, [&route] {
+            return !route.active.load(std::memory_order_relaxed) || route.queued.load(std::memory_order_seq_cst) < route.options.capacity;
+        });
+    }
+
+    route.waiting.fetch_sub(1, std::memory_order_relaxed);
+
+    return route.active.load(std::memory_order_relaxed);
+}
+
+void MessageRouter::Dequeue(Route& route, std::size_t count)
+{
+    route.queued.fetch_sub(count, std::memory_order_seq_cst);
+
+    if (route.waiting.load(std::memory_order_seq_cst) != 0) {
+        std::lock_guard lock { route.mutex };
+        route.cv.notify_all();
+    }
+}
+
+void MessageRouter::Record(RouterMetrics::Recorder& recorder, Endpoint::Id id, Admission admission, const Route* route)
+{
+    switch (admission) {
+    case Admission::kReserved:
+        recorder.Posted(id);
+        recorder.Queued(id, route->queued.load(std::memory_order_relaxed));
+        break;
+    case Admission::kReplaced:
+        // Posted message is queued in place of a dropped one
+        recorder.Posted(id);
+        recorder.Dropped(id);
+        break;
+    case Admission::kRejected:
+        recorder.Dropped(id);
+        break;
+    }
+}
+
+void MessageRouter::Run(Worker& worker, std::size_t index)
+{
+    // Reused across batches
+    std::vector<std::shared_ptr<Route>> strands;
+    std::vector<Task> tasks;
+    std::vector<Message> batch;
+
+    for (;;) {
+        if (Pop(worker, strands, tasks) || Steal(index, strands, tasks)) {
+            Drain(strands, tasks);
+            Deliver(tasks, batch);
+            tasks.clear();
+
+            Reschedule(worker, strands);
+            strands.clear();
+            continue;
+        }
+
+        if (Spin(worker))
+            continue;
+
+        std::unique_lock lock { worker.mutex };
+
+        auto has_task = [this, &worker] {
+            return !worker.strands.empty() || !worker.unordered.empty() || stealable_count_.load(std::memory_order_seq_cst) != 0;
+        };
+
+        worker.sleeping = true;
+        sleeping_count_.fetch_add(1, std::memory_order_seq_cst);
+
+        worker.cv.wait(lock, [this, &has_task] { return done_.load(std::memory_order_relaxed) || has_task(); });
+
+        worker.sleeping = false;
+        sleeping_count_.fetch_sub(1, std::memory_order_relaxed);
+
+        // Drain queued tasks before exit
+        if (done_.load(std::memory_order_relaxed) && worker.strands.empty() && worker.unordered.empty())
+            break;
+    }
+}
+
+// Where a strand is first queued or an unordered task is pushed, other workers may steal either
+std::size_t MessageRouter::GetWorkerIndex(const Route& route) const
+{
+    const auto worker_count = std::size(workers_);
+
+    if (route.delivery == Delivery::kOrdered)
+        return route.endpoint.GetId() % worker_count;
+
+    thread_local std::size_t next { 0 };
+
+    return next++ % worker_count;
 }
 
-void MessageRouter::Register(std::string_view id, MessageHandler handler)
+// Returns true if any strand or unordered task is queued, either can be stolen
+//  - Ordered tasks join their route's strand without locking, only a strand found idle is queued here
+bool MessageRouter::Push(Worker& worker, Task* first, Task* last)
 {
-    std::lock_guard lock { mutex_ };
+    std::size_t stealable = 0;
+
+    for (auto it = first; it != last; ++it) {
+        if (it->route->delivery == Delivery::kUnordered) {
+            ++stealable;
+            continue;
+        }
+
+        auto* node = NodePool<TaskNode>::Acquire();
+        node->task.emplace(std::move(*it));
+
+        // Left set only if the strand has to be queued
+        it->route = node->task->route;
+
+        if (it->route->strand.Push(node))
+            ++stealable;
+        else
+            it->route.reset();
+    }
+
+    if (stealable == 0)
+        return false;
+
+    bool notify = false;
 
-    handlers_.try_emplace(id, std::move(handler));
+    {
+        std::lock_guard lock { worker.mutex };
+
+        for (; first != last; ++first) {
+            if (!first->route)
+                continue;
+
+            if (first->route->delivery == Delivery::kOrdered)
+                worker.strands.push_back(std::move(first->route));
+            else
+                worker.unordered.emplace_back(std::move(*first));
+        }
+
+        stealable_count_.fetch_add(stealable, std::memory_order_seq_cst);
+        notify = worker.sleeping;
+    }
+
+    if (notify)
+        worker.cv.notify_one();
+
+    return true;
 }
 
-void MessageRouter::Unregister(std::string_view id)
+// Take half of strands and unordered tasks from the front, leaving the rest to be stolen
+bool MessageRouter::Pop(Worker& worker, std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks)
 {
-    std::lock_guard lock { mutex_ };
+    std::lock_guard lock { worker.mutex };
 
-    handlers_.erase(id);
+    const auto strand_count = (std::size(worker.strands) + 1) / 2;
+    const auto task_count = (std::size(worker.unordered) + 1) / 2;
+
+    TakeFront(worker.strands, strand_count, strands);
+    TakeFront(worker.unordered, task_count, tasks);
+
+    if (strand_count + task_count != 0)
+        stealable_count_.fetch_sub(strand_count + task_count, std::memory_order_relaxed);
+
+    return !strands.empty() || !tasks.empty();
 }
 
-void MessageRouter::Process(Message message)
+// Take half of strands and unordered tasks from the back of the first non-empty victim
+bool MessageRouter::Steal(std::size_t index, std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks)
 {
-    std::shared_lock lock { mutex_ };
+    if (stealable_count_.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    const auto worker_count = std::size(workers_);
+
+    for (std::size_t i = 1; i < worker_count; ++i) {
+        auto& victim = *workers_[(index + i) % worker_count];
+        std::lock_guard lock { victim.mutex };
+
+        const auto strand_count = (std::size(victim.strands) + 1) / 2;
+        const auto task_count = (std::size(victim.unordered) + 1) / 2;
+
+        if (strand_count + task_count != 0) {
+            TakeBack(victim.strands, strand_count, strands);
+            TakeBack(victim.unordered, task_count, tasks);
+            stealable_count_.fetch_sub(strand_count + task_count, std::memory_order_relaxed);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Take up to kStrandBatch tasks of each strand in order, this worker stays its consumer until Reschedule
+void MessageRouter::Drain(const std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks)
+{
+    for (const auto& route : strands) {
+        std::unique_lock<std::mutex> lock;
+
+        if (route->IsReplaceable())
+            lock = std::unique_lock { route->strand_mutex };
+
+        for (std::size_t count = 0; count < kStrandBatch; ++count) {
+            auto* node = route->strand.Pop();
+            if (!node)
+                break;
+
+            tasks.push_back(std::move(*node->task));
+            node->task.reset();
+
+            NodePool<TaskNode>::Release(node);
+        }
+    }
+}
+
+// Strands with tasks left go to the back of this worker, the others are released
+void MessageRouter::Reschedule(Worker& worker, std::vector<std::shared_ptr<Route>>& strands)
+{
+    const auto last = std::remove_if(std::begin(strands), std::end(strands), [](const std::shared_ptr<Route>& route) {
+        return route->strand.Release();
+    });
+
+    strands.erase(last, std::end(strands));
+
+    if (strands.empty())
+        return;
+
+    {
+        std::lock_guard lock { worker.mutex };
+
+        std::move(std::begin(strands), std::end(strands), std::back_inserter(worker.strands));
+        stealable_count_.fetch_add(std::size(strands), std::memory_order_seq_cst);
+    }
+
+    // Idle workers may take some of them
+    if (sleeping_count_.load(std::memory_order_seq_cst) != 0)
+        WakeIdleWorker();
+}
+
+// Poll for work before sleeping, so a burst of posts needs no wakeup
+bool MessageRouter::Spin(Worker& worker)
+{
+    for (std::size_t i = 0; i < worker.spin; ++i) {
+        if (stealable_count_.load(std::memory_order_relaxed) != 0) {
+            worker.spin = std::min(worker.spin * 2, kMaxSpin);
+            return true;
+        }
+
+        SpinPause();
+    }
+
+    worker.spin = std::max(worker.spin / 2, std::min(worker.spin, kMinSpin));
+
+    return false;
+}
+
+void MessageRouter::WakeIdleWorker()
+{
+    for (auto& worker : workers_) {
+        std::unique_lock lock { worker->mutex };
+
+        if (worker->sleeping) {
+            lock.unlock();
+            worker->cv.notify_one();
+            break;
+        }
+    }
+}
+
+// Hand each handler its messages as one batch, keeping per-handler order
+void MessageRouter::Deliver(std::vector<Task>& tasks, std::vector<Message>& batch)
+{
+    std::stable_sort(std::begin(tasks), std::end(tasks), [](const auto& lhs, const auto& rhs) {
+        return std::less<> {}(lhs.route.get(), rhs.route.get());
+    });
+
+    for (auto first = std::begin(tasks); first != std::end(tasks);) {
+        auto& route = *first->route;
+        const auto last = std::find_if(first, std::end(tasks), [&route](const auto& task) { return task.route.get() != &route; });
+
+        const auto count = static_cast<std::size_t>(std::distance(first, last));
+
+        Dequeue(route, count);
+
+        // Counted before active is checked, so Unregister either sees the delivery or makes it skip
+        route.delivering.fetch_add(1, std::memory_order_seq_cst);
+        const auto active = route.active.load(std::memory_order_seq_cst);
+
+#if MESSAGE_ROUTER_METRICS
+        {
+            const auto id = route.endpoint.GetId();
+            const auto now = RouterMetrics::Now();
+            auto recorder = metrics_.Record();
+
+            if (active) {
+                for (auto it = first; it != last; ++it)
+                    recorder.Delivered(id, now - it->enqueued);
+            } else {
+                recorder.Dropped(id, count);
+            }
+        }
+#endif
+
+        // Handler code runs outside any read-side section, Task::route keeps the route alive
+        const auto* outer_route = std::exchange(current_route, &route);
+
+        // Published messages split the batch, so the handler still sees them in order
+        for (auto it = first; it != last;) {
+            if (it->shared) {
+                if (active)
+                    route.handler.PostShared(it->shared);
+
+                ++it;
+                continue;
+            }
+
+            const auto run_last = std::find_if(it, last, [](const Task& task) { return task.shared != nullptr; });
+
+            for (; it != run_last; ++it)
+                batch.emplace_back(std::move(it->message));
+
+            if (route.options.coalesce)
+                Unstash(route, batch);
+
+            if (active)
+                route.handler.PostBatch(std::data(batch), std::data(batch) + std::size(batch));
+
+            // Whatever the handler didn't move out is recycled on this worker
+            for (auto& message : batch)
+                MessagePool::Release(std::move(message));
+
+            batch.clear();
+        }
+
+        current_route = outer_route;
+
+        // Unregister waits on cv once active is cleared
+        route.delivering.fetch_sub(1, std::memory_order_seq_cst);
+
+        if (!route.active.load(std::memory_order_seq_cst)) {
+            std::lock_guard lock { route.mutex };
+            route.cv.notify_all();
+        }
 
-    if (auto it = handlers_.find(message.to); it != std::cend(handlers_))
-        it->second.Post(std::move(message));
+        first = last;
+    }
 }
\ No newline at end of file
@@ -1,29 +1,240 @@
 #ifndef MESSAGE_ROUTER_H_
 #define MESSAGE_ROUTER_H_
 
-#include <shared_mutex>
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "singleton.h"
-#include "tasker.h"
 
 #include "message_handler.h"
+#include "router_metrics.h"
+#include "util/mailbox.h"
+#include "util/node_pool.h"
+#include "util/rcu.h"
+#include "util/topic_trie.h"
 
-class MessageRouter : public Singleton<MessageRouter>, public TaskerBase<MessageRouter, Message> {
+class MessageRouter : public Singleton<MessageRouter> {
 public:
+    enum class Delivery {
+        // FIFO per destination, the handler's strand is delivered by one worker at a time
+        //  - Any worker may pick up the strand, an idle handler holds no thread
+        kOrdered,
+        // Any worker may deliver, so messages can be reordered or delivered concurrently
+        kUnordered,
+    };
+
+    // What Post does when a handler already has capacity messages queued
+    enum class Overflow {
+        // Post waits for room, TryPost fails
+        kBlock,
+        // The posted message is dropped
+        kDropNewest,
+        // The oldest queued message to the handler is dropped
+        kDropOldest,
+        // A queued message with the same id is replaced, otherwise the posted one is dropped
+        kCoalesce,
+    };
+
+    struct QueueOptions {
+        static constexpr std::size_t kUnbounded { std::numeric_limits<std::size_t>::max() };
+
+        std::size_t capacity { kUnbounded };
+        Overflow overflow { Overflow::kBlock };
+
+        // At most one queued message per id, a later one replaces it in place
+        //  - Capacity then bounds distinct ids, and kDropOldest/kCoalesce drop the posted message
+        bool coalesce { false };
+    };
+
+    MessageRouter();
     ~MessageRouter();
 
-    void Register(std::string_view id, MessageHandler handler);
-    void Unregister(std::string_view id);
+    // Must be called before the first GetInstance(), defaults to the number of cores
+    static void SetWorkerCount(std::size_t count);
+
+    // Returns false if the message is dropped, by an unknown destination or by the handler's Overflow
+    //  - Blocks while a kBlock handler is full, must not be called within MessageHandler::Post for it
+    bool Post(Message message);
+
+    // Same as Post, but fails instead of blocking
+    bool TryPost(Message message);
+
+    // Messages in [first, last) are moved from, returns the number accepted
+    std::size_t PostBatch(Message* first, Message* last);
+    std::size_t TryPostBatch(Message* first, Message* last);
+
+    // Neither waits for handlers of other endpoints, so both may be called within MessageHandler::Post
+    //  - Unregister returns once no delivery to the endpoint is in flight, other than the calling handler's own
+    //  - Handlers unregistering each other's endpoints at once deadlock
+    //  - Capacity counts messages posted and not yet handed to the handler
+    void Register(Endpoint endpoint, MessageHandler handler, Delivery delivery = Delivery::kOrdered);
+    void Register(Endpoint endpoint, MessageHandler handler, Delivery delivery, QueueOptions options);
+    void Unregister(Endpoint endpoint);
+
+    // Topic levels are separated by '/', patterns may use '+' and '#' as in TopicTrie
+    //  - Subscribers are registered endpoints, subscriptions are kept across Unregister
+    void Subscribe(std::string_view pattern, Endpoint endpoint);
+    void Unsubscribe(std::string_view pattern, Endpoint endpoint);
+
+    // Queue message for every endpoint subscribed to topic, returns the number of them
+    //  - Subscribers share one immutable copy, see MessageHandler::PostShared
+    //  - Never blocks, a full subscriber misses the message whatever its Overflow
+    std::size_t Publish(std::string_view topic, Message message);
+
+    // Merged from every thread, empty if MESSAGE_ROUTER_METRICS is 0
+    std::vector<RouterMetrics::Stats> GetStats() const;
+    void ResetStats();
 
 private:
-    friend TaskerBase;
+    struct Route;
+
+    struct Task {
+        std::shared_ptr<Route> route;
+        Message message;
+
+#if MESSAGE_ROUTER_METRICS
+        RouterMetrics::Clock::time_point enqueued {};
+#endif
+
+        // Set by Publish, message is unused
+        std::shared_ptr<const Message> shared {};
+    };
+
+    // Queued on a strand, taken from NodePool by Push and returned by Drain
+    //  - task is move constructed in place, assigning would copy a message from another memory resource
+    struct TaskNode {
+        std::atomic<TaskNode*> next { nullptr };
+        std::optional<Task> task;
+    };
+
+    struct Route {
+        Route(Endpoint endpoint, MessageHandler&& handler, Delivery delivery, QueueOptions options)
+            : endpoint { endpoint }
+            , handler { std::move(handler) }
+            , delivery { delivery }
+            , options { options }
+        {
+        }
+
+        // Overflow searches queued tasks, see Replace
+        bool IsReplaceable() const noexcept
+        {
+            return !options.coalesce && (options.overflow == Overflow::kDropOldest || options.overflow == Overflow::kCoalesce);
+        }
+
+        Endpoint endpoint;
+        MessageHandler handler;
+        Delivery delivery;
+        QueueOptions options;
+
+        // Cleared by Unregister, checked on delivery
+        std::atomic_bool active { true };
+
+        // Deliveries in progress, each counts itself before checking active, Unregister waits for them on cv
+        std::atomic<std::size_t> delivering { 0 };
+
+        // Reserved by Post, released when handed to the handler
+        std::atomic<std::size_t> queued { 0 };
+
+        // Producers blocked by kBlock
+        std::atomic<std::size_t> waiting { 0 };
+        std::condition_variable cv;
+
+        // With QueueOptions::coalesce, queued tasks only carry the id and the message waits here
+        std::unordered_map<std::uint16_t, Message> pending;
+
+        // Guards pending and waits on cv
+        std::mutex mutex;
+
+        // kOrdered only, producers push without locking and the worker running the strand pops
+        //  - Scheduled on a worker while it has tasks, so no other worker runs it
+        Mailbox<TaskNode> strand;
+
+        // Held by Drain and Replace of IsReplaceable() routes, so ForEach never runs alongside Pop
+        //  - Push never takes it, only a producer overflowing such a route does
+        std::mutex strand_mutex;
+    };
+
+    enum class Admission {
+        kReserved,
+        // Took the place of a queued message, nothing to push
+        kReplaced,
+        kRejected,
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        // Both can be stolen by other workers
+        std::deque<std::shared_ptr<Route>> strands;
+        std::deque<Task> unordered;
+
+        bool sleeping { false };
+        std::thread thread;
+
+        // Polls before sleeping, doubled when polling found work and halved when it didn't
+        std::size_t spin { 0 };
+    };
+
+    // Indexed by Endpoint::Id
+    using HandlerTable = std::vector<std::shared_ptr<Route>>;
+
+    // Tasks taken from a strand per run, the rest waits behind other strands of the worker
+    static constexpr std::size_t kStrandBatch { 256 };
+
+    // Bounds of Worker::spin, in SpinPause() calls
+    static constexpr std::size_t kMinSpin { 16 };
+    static constexpr std::size_t kMaxSpin { 4096 };
+
+    bool Post(Message&& message, bool wait);
+    std::size_t PostBatch(Message* first, Message* last, bool wait);
+    Admission Admit(const std::shared_ptr<Route>& route, Message& message, bool wait);
+    bool Reserve(Route& route);
+    bool Replace(const std::shared_ptr<Route>& route, Message& message);
+    bool Coalesce(Route& route, Message& message);
+    bool Stash(Route& route, Message& message);
+    void Unstash(Route& route, std::vector<Message>& batch);
+    bool WaitForRoom(Route& route);
+    void Dequeue(Route& route, std::size_t count);
+    static void Record(RouterMetrics::Recorder& recorder, Endpoint::Id id, Admission admission, const Route* route);
+
+    void Run(Worker& worker, std::size_t index);
+    std::size_t GetWorkerIndex(const Route& route) const;
+    bool Push(Worker& worker, Task* first, Task* last);
+    bool Pop(Worker& worker, std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks);
+    bool Steal(std::size_t index, std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks);
+    void Drain(const std::vector<std::shared_ptr<Route>>& strands, std::vector<Task>& tasks);
+    void Reschedule(Worker& worker, std::vector<std::shared_ptr<Route>>& strands);
+    bool Spin(Worker& worker);
+    void WakeIdleWorker();
+    void Deliver(std::vector<Task>& tasks, std::vector<Message>& batch);
+
+    static inline std::atomic<std::size_t> worker_count_ { 0 };
+
+    // Routing never blocks on registration, see Rcu
+    Rcu<HandlerTable> handlers_;
+    Rcu<TopicTrie<Endpoint>> topics_;
 
-    void Process(Message message);
+    RouterMetrics metrics_;
 
-    std::unordered_map<std::string_view, MessageHandler> handlers_;
-    std::shared_mutex mutex_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    // Strands and unordered tasks queued on any worker
+    std::atomic<std::size_t> stealable_count_ { 0 };
+    std::atomic<std::size_t> sleeping_count_ { 0 };
+    std::atomic_bool done_ { false };
 };
 
 #endif // MESSAGE_ROUTER_H_
\ No newline at end of file
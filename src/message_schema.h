@@ -0,0 +1,365 @@
+#ifndef MESSAGE_SCHEMA_H_
+#define MESSAGE_SCHEMA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "message.h"
+#include "util/bit.h"
+#include "util/type_traits.h"
+
+// Message body with a fixed sequence of field types, known at compile time
+//  - Serialize produces the same bytes as Message::Serialize with Encoding::kV1 for the equivalent body
+//  - Every type code is a constant, only array sizes are computed at runtime
+//  - Without array fields the serialized size is kMinSize, a constant
+//  - Fields are integers, enums, std::string and std::vector<std::uint8_t or int>, or their std::pmr forms
+//
+// DEFINE_MESSAGE(Heartbeat, std::uint16_t, std::string, std::vector<int>);
+//
+// Heartbeat heartbeat { 1, "alive", { 1, 2, 3 } };
+// auto buffer = heartbeat.Serialize();
+// auto result = Heartbeat::Deserialize(buffer);
+// auto& name = result->Get<1>();
+template <typename Derived, typename... Fields>
+class MessageSchema {
+private:
+    template <typename T>
+    static constexpr auto ToItemType(type_traits::type_identity<T>)
+    {
+        if constexpr (std::is_enum_v<T>)
+            return type_traits::type_identity<std::underlying_type_t<T>> {};
+        else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::pmr::string>)
+            return type_traits::type_identity<std::pmr::string> {};
+        else if constexpr (type_traits::is_vector_v<T>)
+            return type_traits::type_identity<std::pmr::vector<typename T::value_type>> {};
+        else
+            return type_traits::type_identity<T> {};
+    }
+
+    // Message::Item alternative a field is stored as
+    template <typename T>
+    using ItemType = typename decltype(ToItemType(type_traits::type_identity<T> {}))::type;
+
+    template <typename T>
+    static constexpr std::size_t kTypeCode { type_traits::variant_index_v<ItemType<T>, Message::Item> };
+
+    template <typename T>
+    static constexpr bool kIsArray { MessageBody::IsArray(kTypeCode<T>) };
+
+    // Type code and, for integers, the value
+    template <typename T>
+    static constexpr std::size_t kFieldSize { kIsArray<T> ? 1 : 1 + sizeof(ItemType<T>) };
+
+    static_assert(sizeof...(Fields) != 0, "Empty body is serialized as an empty buffer");
+    static_assert(sizeof...(Fields) <= std::numeric_limits<std::uint8_t>::max());
+    static_assert(((kTypeCode<Fields> != std::variant_npos) && ...), "Field type has no Message::Item alternative");
+    static_assert(((kTypeCode<Fields> != 0 && kTypeCode<Fields> <= MessageBody::kLastArrayIndex) && ...), "Field type has no Encoding::kV1 type code");
+
+public:
+    using Tuple = std::tuple<Fields...>;
+
+    static constexpr std::size_t kFieldCount { sizeof...(Fields) };
+
+    // Item count and every field, excluding array sizes and data
+    static constexpr std::size_t kMinSize { 1 + (kFieldSize<Fields> + ...) };
+
+    static constexpr bool kFixedSize { !(kIsArray<Fields> || ...) };
+
+    MessageSchema() = default;
+
+    MessageSchema(Fields... values)
+        : values_ { std::move(values)... }
+    {
+    }
+
+    template <std::size_t I>
+    auto& Get() noexcept { return std::get<I>(values_); }
+
+    template <std::size_t I>
+    const auto& Get() const noexcept { return std::get<I>(values_); }
+
+    Tuple& GetValues() noexcept { return values_; }
+    const Tuple& GetValues() const noexcept { return values_; }
+
+    std::size_t SerializedSize() const noexcept
+    {
+        if constexpr (kFixedSize) {
+            return kMinSize;
+        } else {
+            return std::apply([](const auto&... values) { return kMinSize + (ArraySize(values) + ...); }, values_);
+        }
+    }
+
+    std::vector<std::uint8_t> Serialize() const
+    {
+        std::vector<std::uint8_t> buffer(SerializedSize());
+        SerializeFields(std::data(buffer));
+
+        return buffer;
+    }
+
+    // Write into [first, first + size), return written size or std::nullopt if it doesn't fit
+    std::optional<std::size_t> SerializeTo(std::uint8_t* first, std::size_t size) const
+    {
+        const auto total_size = SerializedSize();
+        if (total_size > size)
+            return std::nullopt;
+
+        SerializeFields(first);
+
+        return total_size;
+    }
+
+    // Fails unless data holds exactly these types in order
+    static std::optional<Derived> Deserialize(const std::uint8_t* data, std::size_t size)
+    {
+        std::optional<Derived> result { std::in_place };
+
+        const auto* last = data + size;
+
+        if (size < kMinSize || *data != kFieldCount)
+            return std::nullopt;
+
+        const auto* first = std::apply([data, last](auto&... values) {
+            const auto* first = data + 1;
+            ((first = first ? DeserializeField(first, last, values) : nullptr), ...);
+
+            return first;
+        }, result->values_);
+
+        if (first != last)
+            result.reset();
+
+        return result;
+    }
+
+    static std::optional<Derived> Deserialize(const std::vector<std::uint8_t>& buffer)
+    {
+        return Deserialize(std::data(buffer), std::size(buffer));
+    }
+
+    // Same items as operator<< of every field in order
+    Message ToMessage(std::uint16_t id, const Message::allocator_type& allocator = {}) const
+    {
+        Message message { allocator };
+        message.id = id;
+        message.body.reserve(kFieldCount);
+
+        std::apply([&message](const auto&... values) { (message << ... << values); }, values_);
+
+        return message;
+    }
+
+    // Fails if the body doesn't hold exactly these types in order
+    static std::optional<Derived> FromMessage(const Message& message)
+    {
+        if (std::size(message.body) != kFieldCount)
+            return std::nullopt;
+
+        std::optional<Derived> result { std::in_place };
+
+        const auto matched = std::apply([&message](auto&... values) {
+            std::size_t index = 0;
+
+            return (FromItem(message.body, index++, values) && ...);
+        }, result->values_);
+
+        if (!matched)
+            result.reset();
+
+        return result;
+    }
+
+    friend bool operator==(const MessageSchema& lhs, const MessageSchema& rhs) { return lhs.values_ == rhs.values_; }
+    friend bool operator!=(const MessageSchema& lhs, const MessageSchema& rhs) { return lhs.values_ != rhs.values_; }
+
+private:
+    // Same as CalculateArraySize in message.cpp
+    static constexpr std::uint8_t ArraySizeWidth(std::size_t size) noexcept
+    {
+        if (size <= std::numeric_limits<std::uint8_t>::max())
+            return 1;
+        else if (size <= std::numeric_limits<std::uint16_t>::max())
+            return 2;
+        else if (size <= std::numeric_limits<std::uint32_t>::max())
+            return 4;
+        else
+            return 8;
+    }
+
+    // Serialized size not counted in kMinSize
+    template <typename T>
+    static std::size_t ArraySize(const T& value) noexcept
+    {
+        if constexpr (kIsArray<T>)
+            return ArraySizeWidth(std::size(value)) + std::size(value) * sizeof(typename T::value_type);
+        else
+            return 0;
+    }
+
+    template <typename Int>
+    static std::uint8_t* WriteInt(std::uint8_t* first, Int value) noexcept
+    {
+        if constexpr (sizeof(Int) != 1)
+            value = bit::hton(value);
+
+        std::memcpy(first, &value, sizeof(Int));
+
+        return first + sizeof(Int);
+    }
+
+    template <typename Int>
+    static Int ReadInt(const std::uint8_t* first) noexcept
+    {
+        Int value;
+        std::memcpy(&value, first, sizeof(Int));
+
+        if constexpr (sizeof(Int) != 1)
+            value = bit::ntoh(value);
+
+        return value;
+    }
+
+    void SerializeFields(std::uint8_t* first) const noexcept
+    {
+        *first++ = static_cast<std::uint8_t>(kFieldCount);
+
+        std::apply([&first](const auto&... values) { ((first = SerializeField(first, values)), ...); }, values_);
+    }
+
+    template <typename T>
+    static std::uint8_t* SerializeField(std::uint8_t* first, const T& value) noexcept
+    {
+        constexpr auto kCode = static_cast<std::uint8_t>(kTypeCode<T>);
+
+        if constexpr (kIsArray<T>) {
+            const auto count = std::size(value);
+            const auto width = ArraySizeWidth(count);
+
+            *first++ = static_cast<std::uint8_t>(width << 4) | kCode;
+
+            switch (width) {
+            case 1:
+                first = WriteInt(first, static_cast<std::uint8_t>(count));
+                break;
+            case 2:
+                first = WriteInt(first, static_cast<std::uint16_t>(count));
+                break;
+            case 4:
+                first = WriteInt(first, static_cast<std::uint32_t>(count));
+                break;
+            default:
+                first = WriteInt(first, static_cast<std::uint64_t>(count));
+                break;
+            }
+
+            if (count != 0)
+                bit::hton_n(std::data(value), count, first);
+
+            return first + count * sizeof(typename T::value_type);
+        } else {
+            *first++ = kCode;
+
+            return WriteInt(first, static_cast<ItemType<T>>(value));
+        }
+    }
+
+    // Returns the end of the field, or nullptr if it doesn't match T or is truncated
+    template <typename T>
+    static const std::uint8_t* DeserializeField(const std::uint8_t* first, const std::uint8_t* last, T& value)
+    {
+        constexpr auto kCode = kTypeCode<T>;
+
+        if (first == last)
+            return nullptr;
+
+        const auto code = *first++;
+
+        if constexpr (kIsArray<T>) {
+            using Value = typename T::value_type;
+
+            const auto width = static_cast<std::size_t>(code >> 4);
+
+            if ((code & 0x0F) != kCode || (width != 1 && width != 2 && width != 4 && width != 8) || static_cast<std::size_t>(last - first) < width)
+                return nullptr;
+
+            std::uint64_t count = 0;
+
+            switch (width) {
+            case 1:
+                count = ReadInt<std::uint8_t>(first);
+                break;
+            case 2:
+                count = ReadInt<std::uint16_t>(first);
+                break;
+            case 4:
+                count = ReadInt<std::uint32_t>(first);
+                break;
+            default:
+                count = ReadInt<std::uint64_t>(first);
+                break;
+            }
+
+            first += width;
+
+            if (count > static_cast<std::size_t>(last - first) / sizeof(Value))
+                return nullptr;
+
+            value.resize(static_cast<std::size_t>(count));
+
+            if (count != 0)
+                bit::ntoh_n(first, static_cast<std::size_t>(count), std::data(value));
+
+            return first + count * sizeof(Value);
+        } else {
+            using Item = ItemType<T>;
+
+            if (code != kCode || static_cast<std::size_t>(last - first) < sizeof(Item))
+                return nullptr;
+
+            value = static_cast<T>(ReadInt<Item>(first));
+
+            return first + sizeof(Item);
+        }
+    }
+
+    template <typename T>
+    static bool FromItem(const MessageBody& body, std::size_t index, T& value)
+    {
+        if (body.GetIndex(index) != kTypeCode<T>)
+            return false;
+
+        body.Visit(index, [&value](auto&& item) {
+            using Item = type_traits::remove_cvref_t<decltype(item)>;
+
+            if constexpr (std::is_same_v<Item, ItemType<T>>) {
+                if constexpr (kIsArray<T>)
+                    value.assign(std::cbegin(item), std::cend(item));
+                else
+                    value = static_cast<T>(item);
+            }
+        });
+
+        return true;
+    }
+
+    Tuple values_;
+};
+
+// Typed message named Name with fields of the given types, see MessageSchema
+#define DEFINE_MESSAGE(Name, ...)                                      \
+    struct Name : public MessageSchema<Name, __VA_ARGS__> {            \
+        using MessageSchema<Name, __VA_ARGS__>::MessageSchema;         \
+    }
+
+#endif // MESSAGE_SCHEMA_H_
\ No newline at end of file
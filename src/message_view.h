@@ -0,0 +1,140 @@
+#ifndef MESSAGE_VIEW_H_
+#define MESSAGE_VIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "message.h"
+#include "util/bit.h"
+
+// Read-only view over a buffer produced by Message::Serialize
+//  - Buffer is validated once in Parse() and must outlive the view
+//  - Array items are never copied, integer arrays are byteswapped on access
+class MessageView {
+public:
+    template <typename T>
+    class ArrayView {
+    public:
+        static_assert(std::is_integral_v<T>);
+
+        class Iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = T;
+
+            Iterator() = default;
+
+            explicit Iterator(const std::uint8_t* ptr)
+                : ptr_ { ptr }
+            {
+            }
+
+            T operator*() const
+            {
+                return Load(ptr_);
+            }
+
+            Iterator& operator++()
+            {
+                ptr_ += sizeof(T);
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
+            friend bool operator==(const Iterator& lhs, const Iterator& rhs) { return lhs.ptr_ == rhs.ptr_; }
+            friend bool operator!=(const Iterator& lhs, const Iterator& rhs) { return lhs.ptr_ != rhs.ptr_; }
+
+        private:
+            const std::uint8_t* ptr_ { nullptr };
+        };
+
+        ArrayView() = default;
+
+        ArrayView(const std::uint8_t* data, std::size_t size)
+            : data_ { data }
+            , size_ { size }
+        {
+        }
+
+        T operator[](std::size_t index) const
+        {
+            return Load(data_ + index * sizeof(T));
+        }
+
+        Iterator begin() const { return Iterator { data_ }; }
+        Iterator end() const { return Iterator { data_ + size_bytes() }; }
+
+        // Raw bytes in network byte order
+        const std::uint8_t* data() const noexcept { return data_; }
+        std::size_t size() const noexcept { return size_; }
+        std::size_t size_bytes() const noexcept { return size_ * sizeof(T); }
+        bool empty() const noexcept { return size_ == 0; }
+
+    private:
+        static T Load(const std::uint8_t* ptr)
+        {
+            T value;
+            std::memcpy(&value, ptr, sizeof(T));
+
+            return bit::ntoh(value);
+        }
+
+        const std::uint8_t* data_ { nullptr };
+        std::size_t size_ { 0 };
+    };
+
+    // Same type codes as Message::Item
+    using Item = std::variant<
+        /* Default type */ std::monostate,
+        /* Integer type */ bool, char, std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t,
+        /* Array type   */ ArrayView<std::uint8_t>, ArrayView<int>, std::string_view,
+        /* Float type   */ float, double>;
+
+    static_assert(std::variant_size_v<Item> == std::variant_size_v<Message::Item>);
+
+    MessageView() = default;
+
+    static std::optional<MessageView> Parse(const std::uint8_t* data, std::size_t size, Message::Encoding encoding = Message::Encoding::kV1);
+
+    static std::optional<MessageView> Parse(const std::vector<std::uint8_t>& buffer, Message::Encoding encoding = Message::Encoding::kV1)
+    {
+        return Parse(std::data(buffer), std::size(buffer), encoding);
+    }
+
+    Item operator[](std::size_t index) const;
+
+    template <typename T>
+    T Get(std::size_t index) const
+    {
+        return std::get<T>((*this)[index]);
+    }
+
+    std::size_t size() const noexcept { return std::size(offsets_); }
+    bool empty() const noexcept { return offsets_.empty(); }
+
+private:
+    const std::uint8_t* data_ { nullptr };
+    std::size_t size_ { 0 };
+    Message::Encoding encoding_ { Message::Encoding::kV1 };
+
+    // Offset of each item's code byte
+    std::vector<std::uint32_t> offsets_;
+};
+
+#endif // MESSAGE_VIEW_H_
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "requester.h"
+
+#include <iterator>
+
+#include "message_pool.h"
+#include "message_router.h"
+
+namespace {
+
+constexpr auto kTokenIndex = type_traits::variant_index_v<std::uint32_t, Message::Item>;
+
+} // namespace
+
+Requester::Requester(Endpoint endpoint)
+    : endpoint_ { endpoint }
+{
+    // Unordered, replies to different requests don't wait for each other
+    MessageRouter::GetInstance().Register(endpoint_, Handler { this }, MessageRouter::Delivery::kUnordered);
+}
+
+Requester::~Requester()
+{
+    // No delivery is in flight once it returns
+    MessageRouter::GetInstance().Unregister(endpoint_);
+
+    std::unordered_map<std::uint16_t, Pending> pending;
+
+    {
+        std::lock_guard lock { mutex_ };
+        pending.swap(pending_);
+    }
+
+    auto& timer = Timer::GetInstance();
+
+    for (auto& [slot, request] : pending) {
+        timer.Unregister(request.timer);
+        request.callback(std::nullopt);
+    }
+}
+
+bool Requester::Request(Message message, std::chrono::nanoseconds timeout, Callback callback)
+{
+    std::uint32_t token = 0;
+
+    {
+        std::lock_guard lock { mutex_ };
+
+        if (std::size(pending_) >= kMaxPending)
+            return false;
+
+        // Skip slots still in flight, a free one is found since fewer than kMaxPending are
+        do
+            token = next_token_++;
+        while (pending_.count(ToSlot(token)) != 0);
+
+        // Scheduled under the lock, so the timeout can't arrive before the slot is taken
+        const auto timer = Timer::GetInstance().RegisterOnce(endpoint_, ToSlot(token), timeout);
+        pending_.emplace(ToSlot(token), Pending { token, timer, std::move(callback) });
+    }
+
+    message.from = endpoint_;
+    message << token;
+
+    if (MessageRouter::GetInstance().Post(std::move(message)))
+        return true;
+
+    std::lock_guard lock { mutex_ };
+
+    // Post may block past the timeout, which then took the slot and called back with std::nullopt
+    const auto it = pending_.find(ToSlot(token));
+    if (it == std::end(pending_) || it->second.token != token)
+        return true;
+
+    Timer::GetInstance().Unregister(it->second.timer);
+    pending_.erase(it);
+
+    return false;
+}
+
+bool Requester::Reply(Message& request, Message reply)
+{
+    reply.from = request.to;
+    reply.to = request.from;
+    reply << request.body.Extract<std::uint32_t>();
+
+    return MessageRouter::GetInstance().Post(std::move(reply));
+}
+
+void Requester::OnMessage(Message&& message)
+{
+    // Timer messages carry nothing but the slot as id
+    if (message.body.empty())
+        OnTimeout(message.id);
+    else
+        OnReply(std::move(message));
+}
+
+void Requester::OnReply(Message&& message)
+{
+    const auto size = std::size(message.body);
+
+    // Not a reply to this requester
+    if (message.body.GetIndex(size - 1) != kTokenIndex) {
+        MessagePool::Release(std::move(message));
+        return;
+    }
+
+    const auto token = message.body.Extract<std::uint32_t>();
+    Callback callback;
+
+    {
+        std::lock_guard lock { mutex_ };
+
+        // A late reply finds its slot gone or reused
+        const auto it = pending_.find(ToSlot(token));
+        if (it == std::end(pending_) || it->second.token != token) {
+            MessagePool::Release(std::move(message));
+            return;
+        }
+
+        Timer::GetInstance().Unregister(it->second.timer);
+        callback = std::move(it->second.callback);
+        pending_.erase(it);
+    }
+
+    callback(std::move(message));
+}
+
+void Requester::OnTimeout(std::uint16_t slot)
+{
+    Callback callback;
+
+    {
+        std::lock_guard lock { mutex_ };
+
+        // The slot may be reused by a request whose timer is still running
+        const auto it = pending_.find(slot);
+        if (it == std::end(pending_) || Timer::GetInstance().IsActive(it->second.timer))
+            return;
+
+        callback = std::move(it->second.callback);
+        pending_.erase(it);
+    }
+
+    callback(std::nullopt);
+}
@@ -0,0 +1,146 @@
+#ifndef REQUESTER_H_
+#define REQUESTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define REQUESTER_COROUTINE 1
+#endif
+
+#include "endpoint.h"
+#include "message.h"
+#include "timer.h"
+
+// Request/response over MessageRouter, registered as its own endpoint
+//  - Request appends a std::uint32_t token to the body, the responder hands it back with Reply
+//  - Replies are delivered unordered, so callbacks run concurrently on router workers
+//  - Timeouts are one-shot Timer schedules posted to the same endpoint, rounded up to its resolution
+//  - At most kMaxPending requests are in flight, the token's low 16 bits double as the timeout message id
+class Requester {
+public:
+    // std::nullopt on timeout or when the requester is destroyed
+    using Callback = std::function<void(std::optional<Message>)>;
+
+    static constexpr std::size_t kMaxPending { 1 << 16 };
+
+    explicit Requester(Endpoint endpoint);
+
+    // Pending callbacks are called with std::nullopt
+    //  - Must not be called within one of its callbacks
+    ~Requester();
+
+    Requester(const Requester&) = delete;
+    Requester& operator=(const Requester&) = delete;
+
+    Endpoint GetEndpoint() const noexcept { return endpoint_; }
+
+    // Post message to message.to from this endpoint, callback is called once with the reply
+    //  - Returns false without calling callback if the router drops it or kMaxPending is reached
+    //  - A kBlock Post may outlast timeout, if it then fails callback already had std::nullopt and true is returned
+    bool Request(Message message, std::chrono::nanoseconds timeout, Callback callback);
+
+    // Pop the token off request and post reply back to request.from with it
+    //  - Throws std::bad_variant_access if request has no token as its last item
+    static bool Reply(Message& request, Message reply);
+
+#ifdef REQUESTER_COROUTINE
+    class Awaitable;
+
+    // co_await resumes on the router worker delivering the reply, or on the caller if it can't be posted
+    Awaitable Request(Message message, std::chrono::nanoseconds timeout);
+#endif
+
+private:
+    struct Pending {
+        std::uint32_t token;
+        Timer::Handle timer;
+        Callback callback;
+    };
+
+    struct Handler {
+        void Post(Message&& message) { requester->OnMessage(std::move(message)); }
+
+        Requester* requester;
+    };
+
+    static std::uint16_t ToSlot(std::uint32_t token) noexcept { return static_cast<std::uint16_t>(token); }
+
+    void OnMessage(Message&& message);
+    void OnReply(Message&& message);
+    void OnTimeout(std::uint16_t slot);
+
+    const Endpoint endpoint_;
+
+    // Keyed by ToSlot(token)
+    std::unordered_map<std::uint16_t, Pending> pending_;
+    std::uint32_t next_token_ { 0 };
+    std::mutex mutex_;
+};
+
+#ifdef REQUESTER_COROUTINE
+
+class Requester::Awaitable {
+public:
+    bool await_ready() const noexcept { return false; }
+
+    // Resumed right away if the request can't be posted
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        // Once posted, the reply may resume the coroutine and destroy this before Request returns
+        auto* result = &result_;
+
+        return requester_.Request(std::move(message_), timeout_, [result, handle](std::optional<Message> reply) {
+            *result = std::move(reply);
+            handle.resume();
+        });
+    }
+
+    std::optional<Message> await_resume() noexcept { return std::move(result_); }
+
+private:
+    friend class Requester;
+
+    Awaitable(Requester& requester, Message&& message, std::chrono::nanoseconds timeout)
+        : requester_ { requester }
+        , message_ { std::move(message) }
+        , timeout_ { timeout }
+    {
+    }
+
+    Requester& requester_;
+    Message message_;
+    std::chrono::nanoseconds timeout_;
+    std::optional<Message> result_;
+};
+
+inline Requester::Awaitable Requester::Request(Message message, std::chrono::nanoseconds timeout)
+{
+    return { *this, std::move(message), timeout };
+}
+
+// Coroutine started from a handler's Post, e.g. `Handle(Message message) -> AsyncTask`
+//  - Runs on the calling worker until its first co_await, then wherever it is resumed
+//  - Detached, the frame is freed when it returns, exceptions terminate
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept { }
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+#endif // REQUESTER_COROUTINE
+
+#endif // REQUESTER_H_
@@ -0,0 +1,185 @@
+#include "router_metrics.h"
+
+#if MESSAGE_ROUTER_METRICS
+
+// This thread's shard of each instance it recorded into
+//  - Usually a single entry, the router's
+//  - Destroyed at thread exit, retiring every shard whose instance still exists
+class RouterMetrics::ThreadShards {
+public:
+    ~ThreadShards()
+    {
+        for (const auto& entry : entries_) {
+            if (const auto registry = entry.registry.lock())
+                Retire(*registry, *entry.shard);
+        }
+    }
+
+    Shard& Get(RouterMetrics& metrics)
+    {
+        for (const auto& entry : entries_) {
+            if (entry.owner == metrics.id_)
+                return *entry.shard;
+        }
+
+        // Entries of destroyed instances have nothing left to retire
+        entries_.erase(std::remove_if(std::begin(entries_), std::end(entries_), [](const Entry& entry) { return entry.registry.expired(); }), std::end(entries_));
+
+        auto& registry = *metrics.registry_;
+        std::lock_guard lock { registry.mutex };
+
+        auto* shard = registry.shards.emplace_back(std::make_unique<Shard>()).get();
+        entries_.push_back({ metrics.id_, metrics.registry_, shard });
+
+        return *shard;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t owner;
+        std::weak_ptr<Registry> registry;
+        Shard* shard;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+std::vector<RouterMetrics::Stats> RouterMetrics::GetStats() const
+{
+    std::vector<Totals> totals;
+
+    {
+        std::lock_guard lock { registry_->mutex };
+
+        totals = registry_->retired;
+
+        for (const auto& shard : registry_->shards) {
+            std::lock_guard shard_lock { shard->mutex };
+            Accumulate(*shard, totals);
+        }
+    }
+
+    std::vector<Stats> result;
+    std::lock_guard lock { latency_mutex_ };
+
+    for (std::size_t id = 0; id < std::size(totals); ++id) {
+        const auto& total = totals[id];
+
+        if (total.posted == 0 && total.delivered == 0 && total.dropped == 0)
+            continue;
+
+        Histogram latency;
+
+        if (id < std::size(latencies_) && latencies_[id])
+            latencies_[id]->MergeInto(latency);
+
+        auto& stats = result.emplace_back();
+        stats.endpoint = Endpoint::FromId(static_cast<Endpoint::Id>(id));
+        stats.posted = total.posted;
+        stats.delivered = total.delivered;
+        stats.dropped = total.dropped;
+        stats.max_queue_depth = total.max_queue_depth;
+        stats.mean = std::chrono::nanoseconds { latency.GetMean() };
+        stats.p50 = std::chrono::nanoseconds { latency.GetPercentile(50.0) };
+        stats.p99 = std::chrono::nanoseconds { latency.GetPercentile(99.0) };
+        stats.p999 = std::chrono::nanoseconds { latency.GetPercentile(99.9) };
+        stats.max = std::chrono::nanoseconds { latency.GetMax() };
+    }
+
+    return result;
+}
+
+// Counts recorded meanwhile may survive the reset, chunks are kept
+void RouterMetrics::ResetStats()
+{
+    {
+        std::lock_guard lock { registry_->mutex };
+
+        registry_->retired.clear();
+
+        for (auto& shard : registry_->shards) {
+            std::lock_guard shard_lock { shard->mutex };
+
+            for (auto& chunk : shard->chunks) {
+                if (!chunk)
+                    continue;
+
+                for (auto& counters : *chunk) {
+                    counters.posted.store(0, std::memory_order_relaxed);
+                    counters.delivered.store(0, std::memory_order_relaxed);
+                    counters.dropped.store(0, std::memory_order_relaxed);
+                    counters.max_queue_depth.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    std::lock_guard lock { latency_mutex_ };
+
+    for (auto& latency : latencies_) {
+        if (latency)
+            latency->Reset();
+    }
+}
+
+std::size_t RouterMetrics::GetShardCount() const
+{
+    std::lock_guard lock { registry_->mutex };
+
+    return std::size(registry_->shards);
+}
+
+RouterMetrics::Shard& RouterMetrics::GetShard()
+{
+    thread_local ThreadShards shards;
+
+    return shards.Get(*this);
+}
+
+AtomicHistogram& RouterMetrics::GetLatency(Endpoint::Id id)
+{
+    std::lock_guard lock { latency_mutex_ };
+
+    if (id >= std::size(latencies_))
+        latencies_.resize(id + 1);
+
+    if (!latencies_[id])
+        latencies_[id] = std::make_unique<AtomicHistogram>();
+
+    return *latencies_[id];
+}
+
+void RouterMetrics::Accumulate(const Shard& shard, std::vector<Totals>& totals)
+{
+    for (std::size_t chunk = 0; chunk < std::size(shard.chunks); ++chunk) {
+        if (!shard.chunks[chunk])
+            continue;
+
+        if (std::size(totals) < (chunk + 1) * kChunkSize)
+            totals.resize((chunk + 1) * kChunkSize);
+
+        for (std::size_t i = 0; i < kChunkSize; ++i) {
+            const auto& counters = (*shard.chunks[chunk])[i];
+            auto& total = totals[chunk * kChunkSize + i];
+
+            total.posted += counters.posted.load(std::memory_order_relaxed);
+            total.delivered += counters.delivered.load(std::memory_order_relaxed);
+            total.dropped += counters.dropped.load(std::memory_order_relaxed);
+            total.max_queue_depth = std::max(total.max_queue_depth, counters.max_queue_depth.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void RouterMetrics::Retire(Registry& registry, Shard& shard)
+{
+    std::lock_guard lock { registry.mutex };
+
+    Accumulate(shard, registry.retired);
+
+    const auto it = std::find_if(std::begin(registry.shards), std::end(registry.shards), [&shard](const auto& live) { return live.get() == &shard; });
+
+    if (it != std::end(registry.shards))
+        registry.shards.erase(it);
+}
+
+#endif // MESSAGE_ROUTER_METRICS
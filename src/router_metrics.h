@@ -0,0 +1,204 @@
+#ifndef ROUTER_METRICS_H_
+#define ROUTER_METRICS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "endpoint.h"
+#include "util/histogram.h"
+
+// Define MESSAGE_ROUTER_METRICS=0 to compile every counter and timestamp out of MessageRouter
+#ifndef MESSAGE_ROUTER_METRICS
+#define MESSAGE_ROUTER_METRICS 1
+#endif
+
+// Per-endpoint counters of MessageRouter
+//  - Each thread records into its own shard, shards are merged on read
+//  - A thread's shard is folded into a retired total when it exits, so counts of exited producers are kept
+//  - Latency histograms are shared by every shard, one per delivered endpoint
+class RouterMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        Endpoint endpoint;
+
+        std::uint64_t posted { 0 };
+        std::uint64_t delivered { 0 };
+
+        // Unknown destination, overflow or a coalesced replacement on Post, or unregistered while queued
+        std::uint64_t dropped { 0 };
+
+        // Queued and not yet handed to the handler, 0 once unregistered
+        std::size_t queue_depth { 0 };
+        std::size_t max_queue_depth { 0 };
+
+        // From Post to the handler being called
+        std::chrono::nanoseconds mean { 0 };
+        std::chrono::nanoseconds p50 { 0 };
+        std::chrono::nanoseconds p99 { 0 };
+        std::chrono::nanoseconds p999 { 0 };
+        std::chrono::nanoseconds max { 0 };
+    };
+
+#if MESSAGE_ROUTER_METRICS
+private:
+    // Written only by the shard's thread with relaxed atomics, so readers and ResetStats never block it
+    struct Counters {
+        std::atomic<std::uint64_t> posted { 0 };
+        std::atomic<std::uint64_t> delivered { 0 };
+        std::atomic<std::uint64_t> dropped { 0 };
+        std::atomic<std::size_t> max_queue_depth { 0 };
+
+        // The endpoint's entry of latencies_, looked up on the shard's first delivery to it
+        //  - Only used by the shard's thread
+        AtomicHistogram* latency { nullptr };
+    };
+
+    // Counters of kChunkSize consecutive endpoint ids, never moved once allocated
+    static constexpr std::size_t kChunkSize { 64 };
+    using Chunk = std::array<Counters, kChunkSize>;
+
+    struct Shard {
+        // Indexed by Endpoint::Id / kChunkSize, null until the thread records for one of its ids
+        //  - Only the shard's thread adds chunks, under mutex, readers walk them under mutex
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::mutex mutex;
+    };
+
+    struct Totals {
+        std::uint64_t posted { 0 };
+        std::uint64_t delivered { 0 };
+        std::uint64_t dropped { 0 };
+        std::size_t max_queue_depth { 0 };
+    };
+
+    // Shards of live threads, and what exited threads recorded
+    //  - Shared with each thread's shard cache, which retires the shard at thread exit if this still exists
+    struct Registry {
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        // Indexed by Endpoint::Id
+        std::vector<Totals> retired;
+        std::mutex mutex;
+    };
+
+    class ThreadShards;
+
+public:
+    // Updates this thread's shard, no lock is taken once the shard has counters for the endpoint
+    class Recorder {
+    public:
+        Recorder(RouterMetrics& metrics, Shard& shard)
+            : metrics_ { metrics }
+            , shard_ { shard }
+        {
+        }
+
+        void Posted(Endpoint::Id id, std::size_t count = 1) { Get(id).posted.fetch_add(count, std::memory_order_relaxed); }
+        void Dropped(Endpoint::Id id, std::size_t count = 1) { Get(id).dropped.fetch_add(count, std::memory_order_relaxed); }
+
+        void Queued(Endpoint::Id id, std::size_t depth)
+        {
+            auto& max = Get(id).max_queue_depth;
+
+            if (depth > max.load(std::memory_order_relaxed))
+                max.store(depth, std::memory_order_relaxed);
+        }
+
+        void Delivered(Endpoint::Id id, std::chrono::nanoseconds latency)
+        {
+            auto& counters = Get(id);
+            counters.delivered.fetch_add(1, std::memory_order_relaxed);
+
+            if (!counters.latency)
+                counters.latency = &metrics_.GetLatency(id);
+
+            counters.latency->Record(static_cast<std::uint64_t>(std::max(latency.count(), std::chrono::nanoseconds::rep { 0 })));
+        }
+
+    private:
+        Counters& Get(Endpoint::Id id)
+        {
+            const auto chunk = id / kChunkSize;
+
+            if (chunk >= std::size(shard_.chunks) || !shard_.chunks[chunk])
+                AddChunk(chunk);
+
+            return (*shard_.chunks[chunk])[id % kChunkSize];
+        }
+
+        void AddChunk(std::size_t chunk)
+        {
+            std::lock_guard lock { shard_.mutex };
+
+            if (chunk >= std::size(shard_.chunks))
+                shard_.chunks.resize(chunk + 1);
+
+            shard_.chunks[chunk] = std::make_unique<Chunk>();
+        }
+
+        RouterMetrics& metrics_;
+        Shard& shard_;
+    };
+
+    static Clock::time_point Now() noexcept { return Clock::now(); }
+
+    Recorder Record() { return Recorder { *this, GetShard() }; }
+
+    // Endpoints with any recorded activity, ordered by id
+    //  - Current queue depths are filled in by MessageRouter
+    std::vector<Stats> GetStats() const;
+    void ResetStats();
+
+    // One per thread that recorded and hasn't exited
+    std::size_t GetShardCount() const;
+
+private:
+    Shard& GetShard();
+    AtomicHistogram& GetLatency(Endpoint::Id id);
+
+    // Add the shard's counters to totals, indexed by Endpoint::Id
+    //  - The shard's thread may still be recording, its mutex must be held unless that thread is the caller
+    static void Accumulate(const Shard& shard, std::vector<Totals>& totals);
+
+    // Fold shard into retired and free it, called at its thread's exit
+    static void Retire(Registry& registry, Shard& shard);
+
+    static inline std::atomic<std::uint64_t> next_id_ { 1 };
+
+    // Keys each thread's shard cache, a later instance may reuse this address
+    const std::uint64_t id_ { next_id_.fetch_add(1, std::memory_order_relaxed) };
+
+    const std::shared_ptr<Registry> registry_ { std::make_shared<Registry>() };
+
+    // Indexed by Endpoint::Id, one per endpoint rather than per shard, since any worker may run a strand
+    //  - Never freed, so shards keep pointers to them, ResetStats only clears them
+    //  - Guarded by latency_mutex_, which is never held while taking another mutex
+    std::vector<std::unique_ptr<AtomicHistogram>> latencies_;
+    mutable std::mutex latency_mutex_;
+#else
+    class Recorder {
+    public:
+        void Posted(Endpoint::Id, std::size_t = 1) { }
+        void Dropped(Endpoint::Id, std::size_t = 1) { }
+        void Queued(Endpoint::Id, std::size_t) { }
+    };
+
+    Recorder Record() { return {}; }
+
+    std::vector<Stats> GetStats() const { return {}; }
+    void ResetStats() { }
+    std::size_t GetShardCount() const { return 0; }
+#endif
+};
+
+#endif // ROUTER_METRICS_H_
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "shm_ring.h"
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+namespace {
+
+std::size_t RoundUpCapacity(std::size_t capacity) noexcept
+{
+    std::size_t result = ShmRing::kMinCapacity;
+
+    while (result < capacity)
+        result <<= 1;
+
+    return result;
+}
+
+void* Map(int fd, std::size_t size) noexcept
+{
+    auto* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    return address == MAP_FAILED ? nullptr : address;
+}
+
+} // namespace
+
+std::optional<ShmRing> ShmRing::Create(const std::string& name, std::size_t capacity)
+{
+    capacity = RoundUpCapacity(capacity);
+
+    const auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return std::nullopt;
+
+    const auto mapped_size = sizeof(Control) + capacity;
+    void* address = nullptr;
+
+    if (::ftruncate(fd, static_cast<off_t>(mapped_size)) == 0)
+        address = Map(fd, mapped_size);
+
+    ::close(fd);
+
+    if (!address) {
+        ::shm_unlink(name.c_str());
+        return std::nullopt;
+    }
+
+    // ftruncate zero-fills, so no record is published yet
+    auto* control = new (address) Control;
+    control->capacity = capacity;
+    control->head.store(0, std::memory_order_relaxed);
+    control->tail.store(0, std::memory_order_relaxed);
+    control->sleeping.store(0, std::memory_order_relaxed);
+
+    // Robust, so a process dying inside Wait or Notify doesn't block the others forever
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&control->mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&control->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    // Written last, Open rejects a segment that is still being set up
+    control->magic.store(kMagic, std::memory_order_release);
+
+    return ShmRing { address, mapped_size };
+}
+
+std::optional<ShmRing> ShmRing::Open(const std::string& name)
+{
+    const auto fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return std::nullopt;
+
+    struct stat st { };
+    void* address = nullptr;
+    std::size_t mapped_size = 0;
+
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) > sizeof(Control)) {
+        mapped_size = static_cast<std::size_t>(st.st_size);
+        address = Map(fd, mapped_size);
+    }
+
+    ::close(fd);
+
+    if (!address)
+        return std::nullopt;
+
+    const auto* control = static_cast<const Control*>(address);
+
+    if (control->magic.load(std::memory_order_acquire) != kMagic || sizeof(Control) + control->capacity != mapped_size) {
+        ::munmap(address, mapped_size);
+        return std::nullopt;
+    }
+
+    return ShmRing { address, mapped_size };
+}
+
+void ShmRing::Unlink(const std::string& name)
+{
+    ::shm_unlink(name.c_str());
+}
+
+ShmRing::ShmRing(void* address, std::size_t mapped_size) noexcept
+    : control_ { static_cast<Control*>(address) }
+    , data_ { static_cast<std::uint8_t*>(address) + sizeof(Control) }
+    , capacity_ { static_cast<std::size_t>(control_->capacity) }
+    , mapped_size_ { mapped_size }
+{
+}
+
+ShmRing::ShmRing(ShmRing&& other) noexcept
+    : control_ { std::exchange(other.control_, nullptr) }
+    , data_ { std::exchange(other.data_, nullptr) }
+    , capacity_ { std::exchange(other.capacity_, 0) }
+    , mapped_size_ { std::exchange(other.mapped_size_, 0) }
+{
+}
+
+ShmRing& ShmRing::operator=(ShmRing&& other) noexcept
+{
+    if (this != &other) {
+        Unmap();
+
+        control_ = std::exchange(other.control_, nullptr);
+        data_ = std::exchange(other.data_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        mapped_size_ = std::exchange(other.mapped_size_, 0);
+    }
+
+    return *this;
+}
+
+ShmRing::~ShmRing()
+{
+    Unmap();
+}
+
+void ShmRing::Wait(std::chrono::milliseconds timeout)
+{
+    timespec deadline { };
+    ::clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    const auto nanoseconds = deadline.tv_nsec + std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    deadline.tv_sec += static_cast<time_t>(nanoseconds / 1000000000);
+    deadline.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+
+    Lock();
+
+    // Pairs with the fence in Notify, either the producer sees sleeping or we see its record
+    control_->sleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    const auto tail = control_->tail.load(std::memory_order_relaxed);
+
+    if (GetHeader(tail)->tag.load(std::memory_order_relaxed) != tail + 1) {
+        // EOWNERDEAD leaves the mutex locked like success
+        if (pthread_cond_timedwait(&control_->cond, &control_->mutex, &deadline) == EOWNERDEAD)
+            pthread_mutex_consistent(&control_->mutex);
+    }
+
+    control_->sleeping.store(0, std::memory_order_relaxed);
+    pthread_mutex_unlock(&control_->mutex);
+}
+
+void ShmRing::Wake()
+{
+    Lock();
+    pthread_cond_signal(&control_->cond);
+    pthread_mutex_unlock(&control_->mutex);
+}
+
+void ShmRing::Notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Locking waits until the consumer is inside pthread_cond_timedwait, so the signal isn't lost
+    if (control_->sleeping.load(std::memory_order_relaxed) != 0)
+        Wake();
+}
+
+void ShmRing::Lock()
+{
+    if (pthread_mutex_lock(&control_->mutex) == EOWNERDEAD)
+        pthread_mutex_consistent(&control_->mutex);
+}
+
+void ShmRing::Unmap() noexcept
+{
+    if (control_)
+        ::munmap(control_, mapped_size_);
+}
\ No newline at end of file
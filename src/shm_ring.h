@@ -0,0 +1,223 @@
+#ifndef SHM_RING_H_
+#define SHM_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Multi-producer single-consumer ring of byte records in POSIX shared memory
+//  - Producers in any process reserve space with a CAS on head and write the record in place
+//  - A record is published by storing its position in its header, so a slow producer only delays records behind it
+//  - The consumer clears every 16-byte aligned tag word it has read, so a stale payload can't pass for a header
+//  - A record never wraps, the space left at the end is skipped with a padding record
+//  - The consumer sleeps on a process-shared condition variable while the ring is empty
+class ShmRing {
+public:
+    static constexpr std::size_t kAlignment { 16 };
+    static constexpr std::size_t kMinCapacity { 4096 };
+
+    // Fails if name already exists, capacity is rounded up to a power of two of at least kMinCapacity
+    static std::optional<ShmRing> Create(const std::string& name, std::size_t capacity);
+
+    // Fails if name doesn't exist or isn't a ShmRing
+    static std::optional<ShmRing> Open(const std::string& name);
+
+    // Existing mappings stay valid
+    static void Unlink(const std::string& name);
+
+    ShmRing(ShmRing&& other) noexcept;
+    ShmRing& operator=(ShmRing&& other) noexcept;
+    ~ShmRing();
+
+    std::size_t GetCapacity() const noexcept { return capacity_; }
+
+    // Larger records are rejected by both TryWrite and Write
+    //  - Half the ring, so a record and the padding before it always fit once the ring drains
+    std::size_t GetMaxRecordSize() const noexcept
+    {
+        return std::min<std::size_t>(capacity_ / 2 - sizeof(RecordHeader), std::numeric_limits<std::uint32_t>::max());
+    }
+
+    // Call fill(std::uint8_t* data) to write exactly size bytes into the ring
+    //  - Returns false if the ring is full
+    template <typename F>
+    bool TryWrite(std::size_t size, F&& fill)
+    {
+        if (size > GetMaxRecordSize())
+            return false;
+
+        const auto record_size = Align(sizeof(RecordHeader) + size);
+        auto head = control_->head.load(std::memory_order_relaxed);
+
+        for (;;) {
+            const auto offset = GetOffset(head);
+            const auto padding = capacity_ - offset < record_size ? capacity_ - offset : 0;
+
+            // Stale tail only underestimates free space
+            if (head + padding + record_size - control_->tail.load(std::memory_order_acquire) > capacity_)
+                return false;
+
+            if (control_->head.compare_exchange_weak(head, head + padding + record_size, std::memory_order_relaxed))
+                break;
+        }
+
+        if (GetOffset(head) + record_size > capacity_) {
+            const auto padding = capacity_ - GetOffset(head);
+
+            Publish(head, padding - sizeof(RecordHeader), RecordHeader::kPadding);
+            head += padding;
+        }
+
+        fill(data_ + GetOffset(head) + sizeof(RecordHeader));
+        Publish(head, size, 0);
+        Notify();
+
+        return true;
+    }
+
+    // Like TryWrite, but spins and then yields while the ring is full
+    //  - Returns false only if size exceeds GetMaxRecordSize()
+    template <typename F>
+    bool Write(std::size_t size, F&& fill)
+    {
+        if (size > GetMaxRecordSize())
+            return false;
+
+        for (std::size_t attempt = 0; !TryWrite(size, fill); ++attempt) {
+            if (attempt >= kSpinCount)
+                std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    // Call f(const std::uint8_t* data, std::size_t size) for up to max_count published records in order
+    //  - Only one thread across all processes may read
+    //  - Record memory is reused once f returns
+    //  - Returns number of records passed to f
+    template <typename F>
+    std::size_t Read(F&& f, std::size_t max_count = std::numeric_limits<std::size_t>::max())
+    {
+        auto tail = control_->tail.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+
+        while (count < max_count) {
+            const auto* header = GetHeader(tail);
+
+            if (header->tag.load(std::memory_order_acquire) != tail + 1)
+                break;
+
+            if (header->flags & RecordHeader::kPadding) {
+                // Its body was cleared on the previous lap and never written since
+                Clear(tail, sizeof(RecordHeader));
+                tail += capacity_ - GetOffset(tail);
+            } else {
+                const auto record_size = Align(sizeof(RecordHeader) + header->size);
+
+                f(reinterpret_cast<const std::uint8_t*>(header + 1), static_cast<std::size_t>(header->size));
+                Clear(tail, record_size);
+                tail += record_size;
+                ++count;
+            }
+
+            // Release space record by record, producers may be waiting on it
+            control_->tail.store(tail, std::memory_order_release);
+        }
+
+        return count;
+    }
+
+    // Block the consumer until a record may be available, Wake() is called or timeout passes
+    void Wait(std::chrono::milliseconds timeout);
+
+    // Wake the consumer from Wait(), from any thread or process
+    void Wake();
+
+private:
+    static constexpr std::uint64_t kMagic { 0x474e495247534d31 };
+    static constexpr std::size_t kSpinCount { 64 };
+
+    struct RecordHeader {
+        static constexpr std::uint32_t kPadding { 1 };
+
+        // Position + 1 once published, never matches a stale record at the same offset
+        //  - 0 while unpublished, the consumer clears it together with every payload word that may become a tag
+        std::atomic<std::uint64_t> tag;
+        std::uint32_t size;
+        std::uint32_t flags;
+    };
+
+    static_assert(sizeof(RecordHeader) == kAlignment);
+
+    // Positions grow monotonically, offset in the ring is position & (capacity - 1)
+    struct Control {
+        std::atomic<std::uint64_t> magic;
+        std::uint64_t capacity;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+
+        alignas(64) std::atomic<std::uint64_t> head;
+        alignas(64) std::atomic<std::uint64_t> tail;
+        alignas(64) std::atomic<std::uint32_t> sleeping;
+    };
+
+    // Shared between processes, so they must not rely on a process-local lock
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+    static constexpr std::size_t Align(std::size_t size) noexcept
+    {
+        return (size + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    ShmRing(void* address, std::size_t mapped_size) noexcept;
+
+    std::size_t GetOffset(std::uint64_t position) const noexcept
+    {
+        return static_cast<std::size_t>(position & (capacity_ - 1));
+    }
+
+    RecordHeader* GetHeader(std::uint64_t position) const noexcept
+    {
+        return reinterpret_cast<RecordHeader*>(data_ + GetOffset(position));
+    }
+
+    // Zero the word a header would take at each kAlignment step of [position, position + size)
+    //  - Called by the consumer before releasing the space, a payload could hold a future position + 1
+    void Clear(std::uint64_t position, std::size_t size) noexcept
+    {
+        for (std::size_t offset = 0; offset < size; offset += kAlignment)
+            GetHeader(position + offset)->tag.store(0, std::memory_order_relaxed);
+    }
+
+    void Publish(std::uint64_t position, std::size_t size, std::uint32_t flags)
+    {
+        auto* header = GetHeader(position);
+        header->size = static_cast<std::uint32_t>(size);
+        header->flags = flags;
+        header->tag.store(position + 1, std::memory_order_release);
+    }
+
+    // Signal only if the consumer announced it's going to sleep
+    void Notify();
+
+    void Lock();
+    void Unmap() noexcept;
+
+    Control* control_ { nullptr };
+    std::uint8_t* data_ { nullptr };
+    std::size_t capacity_ { 0 };
+    std::size_t mapped_size_ { 0 };
+};
+
+#endif // SHM_RING_H_
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "shm_transport.h"
+
+#include <cassert>
+
+#include <iterator>
+#include <vector>
+
+#include "frame.h"
+#include "message_pool.h"
+#include "message_router.h"
+
+void ShmSender::Post(Message&& message)
+{
+    if (!Write(message))
+        drop_count_->fetch_add(1, std::memory_order_relaxed);
+
+    MessagePool::Release(std::move(message));
+}
+
+void ShmSender::PostBatch(Message* first, Message* last)
+{
+    std::uint64_t drop_count = 0;
+
+    for (; first != last; ++first) {
+        if (!Write(*first))
+            ++drop_count;
+
+        MessagePool::Release(std::move(*first));
+    }
+
+    if (drop_count != 0)
+        drop_count_->fetch_add(drop_count, std::memory_order_relaxed);
+}
+
+bool ShmSender::Write(const Message& message)
+{
+    // Checked before reserving, a reserved record is always published
+    const auto size = Frame::SerializedSize(message);
+    if (size == 0)
+        return false;
+
+    return ring_->Write(size, [&message, size](std::uint8_t* data) {
+        [[maybe_unused]] const auto written = Frame::SerializeTo(message, data, size);
+        assert(written == size);
+    });
+}
+
+ShmReceiver::ShmReceiver(std::shared_ptr<ShmRing> ring)
+    : ring_ { std::move(ring) }
+    , thread_ { &ShmReceiver::Run, this }
+{
+}
+
+ShmReceiver::~ShmReceiver()
+{
+    done_.store(true, std::memory_order_relaxed);
+    ring_->Wake();
+
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void ShmReceiver::Run()
+{
+    std::vector<Message> batch;
+    batch.reserve(kBatchSize);
+
+    while (!done_.load(std::memory_order_relaxed)) {
+        const auto count = ring_->Read([this, &batch](const std::uint8_t* data, std::size_t size) {
+            if (auto message = Frame::Deserialize(data, size, MessagePool::GetResource()))
+                batch.push_back(std::move(*message));
+            else
+                error_count_.fetch_add(1, std::memory_order_relaxed);
+        }, kBatchSize);
+
+        if (!batch.empty()) {
+            MessageRouter::GetInstance().PostBatch(std::data(batch), std::data(batch) + std::size(batch));
+            batch.clear();
+        }
+
+        if (count == 0)
+            ring_->Wait(kWaitTimeout);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef SHM_TRANSPORT_H_
+#define SHM_TRANSPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "message.h"
+#include "shm_ring.h"
+
+// MessageHandler forwarding to another process through a ShmRing
+//  - Register it for a remote endpoint, Post writes a Frame straight into the ring
+//  - Endpoints travel by name, since ids are only meaningful within one process
+//  - Blocks while the ring is full, messages larger than the ring or that can't be framed are dropped
+class ShmSender {
+public:
+    explicit ShmSender(std::shared_ptr<ShmRing> ring)
+        : ring_ { std::move(ring) }
+    {
+    }
+
+    void Post(Message&& message);
+
+    // Messages in [first, last) are moved from
+    void PostBatch(Message* first, Message* last);
+
+    // Number of messages that didn't fit in the ring or couldn't be framed
+    std::uint64_t GetDropCount() const noexcept { return drop_count_->load(std::memory_order_relaxed); }
+
+private:
+    bool Write(const Message& message);
+
+    std::shared_ptr<ShmRing> ring_;
+
+    // Shared by copies, MessageHandler takes the handler by value
+    std::shared_ptr<std::atomic<std::uint64_t>> drop_count_ { std::make_shared<std::atomic<std::uint64_t>>(0) };
+};
+
+// Consumer side of a ShmRing, posts every frame read from it to MessageRouter
+//  - Runs its own thread, frames read together are posted with one PostBatch
+//  - Must be the only reader of the ring
+class ShmReceiver {
+public:
+    static constexpr std::size_t kBatchSize { 64 };
+
+    // Bounds how long the destructor waits for the thread
+    static constexpr std::chrono::milliseconds kWaitTimeout { 100 };
+
+    explicit ShmReceiver(std::shared_ptr<ShmRing> ring);
+    ~ShmReceiver();
+
+    ShmReceiver(const ShmReceiver&) = delete;
+    ShmReceiver& operator=(const ShmReceiver&) = delete;
+
+    // Number of records that failed to decode or were sent to an endpoint unknown to this process
+    std::uint64_t GetErrorCount() const noexcept { return error_count_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+
+    std::shared_ptr<ShmRing> ring_;
+    std::atomic<std::uint64_t> error_count_ { 0 };
+    std::atomic_bool done_ { false };
+    std::thread thread_;
+};
+
+#endif // SHM_TRANSPORT_H_
\ No newline at end of file
@@ -0,0 +1,567 @@
+#include "socket_bridge.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <iterator>
+#include <vector>
+
+#include "frame.h"
+#include "message_pool.h"
+#include "message_router.h"
+
+struct SocketSender::Connection {
+    Connection(int fd, int epoll_fd)
+        : fd { fd }
+        , epoll_fd { epoll_fd }
+        , decoder { Frame::kDefaultMaxSize, MessagePool::GetResource() }
+    {
+    }
+
+    // Append a frame, returns false if it can't be sent
+    bool Enqueue(const Message& message)
+    {
+        const auto size = Frame::SerializedSize(message);
+
+        if (fd < 0 || size == 0 || std::size(pending) - offset + size > kMaxPendingSize)
+            return false;
+
+        const auto first = std::size(pending);
+        pending.resize(first + size);
+
+        // A partial frame would desync the peer's decoder for the rest of the stream
+        if (!Frame::SerializeTo(message, std::data(pending) + first, size)) {
+            pending.resize(first);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Send as much as the socket takes, EPOLLOUT is armed for the rest
+    //  - While armed, the bridge thread flushes and new frames only queue behind
+    void Flush()
+    {
+        if (fd < 0 || want_write)
+            return;
+
+        while (offset < std::size(pending)) {
+            const auto sent = ::send(fd, std::data(pending) + offset, std::size(pending) - offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+            if (sent > 0) {
+                offset += static_cast<std::size_t>(sent);
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // Keep the unsent tail from growing behind a slow reader
+                if (offset >= std::size(pending) / 2) {
+                    pending.erase(std::begin(pending), std::begin(pending) + static_cast<std::ptrdiff_t>(offset));
+                    offset = 0;
+                }
+
+                SetWantWrite(true);
+                return;
+            } else {
+                // Bridge thread sees the error and closes the connection
+                ::shutdown(fd, SHUT_RDWR);
+                break;
+            }
+        }
+
+        pending.clear();
+        offset = 0;
+    }
+
+    void SetWantWrite(bool value)
+    {
+        epoll_event event { };
+        event.events = value ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.fd = fd;
+
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        want_write = value;
+    }
+
+    // Guards the members below, held while sending so fd isn't closed meanwhile
+    std::mutex mutex;
+    int fd;
+    const int epoll_fd;
+
+    // Frames from pending[offset] on are unsent
+    std::vector<std::uint8_t> pending;
+    std::size_t offset { 0 };
+    bool want_write { false };
+
+    std::atomic<std::uint64_t> drop_count { 0 };
+
+    // Only used by the bridge thread
+    FrameDecoder decoder;
+};
+
+namespace {
+
+// Never blocks, a full kBlock handler would otherwise stall every connection of the bridge
+struct RouterSink {
+    void Post(Message&& message)
+    {
+        if (!MessageRouter::GetInstance().TryPost(std::move(message)))
+            drop_count->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void PostBatch(Message* first, Message* last)
+    {
+        const auto accepted = MessageRouter::GetInstance().TryPostBatch(first, last);
+        const auto count = static_cast<std::size_t>(last - first);
+
+        if (accepted != count)
+            drop_count->fetch_add(count - accepted, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t>* drop_count;
+};
+
+constexpr int kMaxEvents { 64 };
+
+// Bounds how long one busy connection keeps the others waiting
+constexpr int kMaxReadCount { 16 };
+
+bool SetNonBlocking(int fd)
+{
+    const auto flags = ::fcntl(fd, F_GETFL);
+
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Frames are small and latency sensitive, fails harmlessly on Unix domain sockets
+void SetNoDelay(int fd)
+{
+    const int value = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+}
+
+// Returns a bound and listening socket, or a connected one, -1 on failure
+int OpenTcp(const std::string& host, std::uint16_t port, bool listen)
+{
+    addrinfo hints { };
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listen ? AI_PASSIVE : 0;
+
+    addrinfo* result = nullptr;
+    const auto service = std::to_string(port);
+
+    if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &result) != 0)
+        return -1;
+
+    int fd = -1;
+
+    for (auto* info = result; info && fd < 0; info = info->ai_next) {
+        fd = ::socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        bool ok = false;
+
+        if (listen) {
+            const int value = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value));
+
+            ok = ::bind(fd, info->ai_addr, info->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0;
+        } else {
+            ok = ::connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+        }
+
+        if (!ok) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    ::freeaddrinfo(result);
+
+    return fd;
+}
+
+int OpenUnix(const std::string& path, bool listen)
+{
+    sockaddr_un address { };
+    address.sun_family = AF_UNIX;
+
+    if (std::size(path) >= sizeof(address.sun_path))
+        return -1;
+
+    std::memcpy(address.sun_path, path.c_str(), std::size(path) + 1);
+
+    const auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    const auto* addr = reinterpret_cast<const sockaddr*>(&address);
+    const auto ok = listen ? ::bind(fd, addr, sizeof(address)) == 0 && ::listen(fd, SOMAXCONN) == 0 : ::connect(fd, addr, sizeof(address)) == 0;
+
+    if (!ok) {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+} // namespace
+
+void SocketSender::Post(Message&& message)
+{
+    {
+        std::lock_guard lock { connection_->mutex };
+
+        if (connection_->Enqueue(message))
+            connection_->Flush();
+        else
+            connection_->drop_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MessagePool::Release(std::move(message));
+}
+
+void SocketSender::PostBatch(Message* first, Message* last)
+{
+    std::uint64_t drop_count = 0;
+
+    {
+        std::lock_guard lock { connection_->mutex };
+
+        for (auto* it = first; it != last; ++it) {
+            if (!connection_->Enqueue(*it))
+                ++drop_count;
+        }
+
+        connection_->Flush();
+    }
+
+    if (drop_count != 0)
+        connection_->drop_count.fetch_add(drop_count, std::memory_order_relaxed);
+
+    for (; first != last; ++first)
+        MessagePool::Release(std::move(*first));
+}
+
+bool SocketSender::IsConnected() const
+{
+    std::lock_guard lock { connection_->mutex };
+
+    return connection_->fd >= 0;
+}
+
+std::uint64_t SocketSender::GetDropCount() const noexcept
+{
+    return connection_->drop_count.load(std::memory_order_relaxed);
+}
+
+SocketBridge::SocketBridge()
+    : SocketBridge { MessageHandler { RouterSink { &drop_count_ } } }
+{
+}
+
+SocketBridge::SocketBridge(MessageHandler sink)
+    : sink_ { std::move(sink) }
+    , epoll_fd_ { ::epoll_create1(EPOLL_CLOEXEC) }
+    , wake_fd_ { ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+{
+    if (!IsValid())
+        return;
+
+    epoll_event event { };
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    thread_ = std::thread { &SocketBridge::Run, this };
+}
+
+SocketBridge::~SocketBridge()
+{
+    done_.store(true, std::memory_order_relaxed);
+
+    if (thread_.joinable()) {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] const auto written = ::write(wake_fd_, &value, sizeof(value));
+
+        thread_.join();
+    }
+
+    for (const auto& [fd, connection] : connections_) {
+        std::lock_guard lock { connection->mutex };
+
+        ::close(fd);
+        connection->fd = -1;
+    }
+
+    for (const auto& [fd, on_accept] : listeners_)
+        ::close(fd);
+
+    if (wake_fd_ >= 0)
+        ::close(wake_fd_);
+
+    if (epoll_fd_ >= 0)
+        ::close(epoll_fd_);
+}
+
+std::optional<std::uint16_t> SocketBridge::ListenTcp(const std::string& host, std::uint16_t port, AcceptHandler on_accept)
+{
+    const auto fd = OpenTcp(host, port, true);
+    if (fd < 0)
+        return std::nullopt;
+
+    sockaddr_storage address { };
+    socklen_t size = sizeof(address);
+
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    const auto bound_port = address.ss_family == AF_INET6
+        ? reinterpret_cast<const sockaddr_in6&>(address).sin6_port
+        : reinterpret_cast<const sockaddr_in&>(address).sin_port;
+
+    if (!AddListener(fd, std::move(on_accept)))
+        return std::nullopt;
+
+    return ntohs(bound_port);
+}
+
+bool SocketBridge::ListenUnix(const std::string& path, AcceptHandler on_accept)
+{
+    const auto fd = OpenUnix(path, true);
+
+    return fd >= 0 && AddListener(fd, std::move(on_accept));
+}
+
+std::optional<SocketSender> SocketBridge::ConnectTcp(const std::string& host, std::uint16_t port)
+{
+    const auto fd = OpenTcp(host, port, false);
+    if (fd < 0)
+        return std::nullopt;
+
+    SetNoDelay(fd);
+
+    return AddConnection(fd);
+}
+
+std::optional<SocketSender> SocketBridge::ConnectUnix(const std::string& path)
+{
+    const auto fd = OpenUnix(path, false);
+    if (fd < 0)
+        return std::nullopt;
+
+    return AddConnection(fd);
+}
+
+// Takes ownership of fd
+bool SocketBridge::AddListener(int fd, AcceptHandler on_accept)
+{
+    if (!IsValid() || !SetNonBlocking(fd)) {
+        ::close(fd);
+        return false;
+    }
+
+    std::lock_guard lock { mutex_ };
+
+    epoll_event event { };
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    listeners_.emplace(fd, std::move(on_accept));
+
+    return true;
+}
+
+// Takes ownership of fd
+std::optional<SocketSender> SocketBridge::AddConnection(int fd)
+{
+    if (!IsValid() || !SetNonBlocking(fd)) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    auto connection = std::make_shared<Connection>(fd, epoll_fd_);
+
+    std::lock_guard lock { mutex_ };
+
+    // Registered under mutex_, so the bridge thread finds it on the first event
+    epoll_event event { };
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    connections_.emplace(fd, connection);
+
+    return SocketSender { std::move(connection) };
+}
+
+void SocketBridge::Run()
+{
+    std::array<epoll_event, kMaxEvents> events;
+
+    while (!done_.load(std::memory_order_relaxed)) {
+        const auto count = ::epoll_wait(epoll_fd_, std::data(events), kMaxEvents, -1);
+
+        for (int i = 0; i < count; ++i) {
+            const auto fd = events[i].data.fd;
+            const auto flags = events[i].events;
+
+            if (fd == wake_fd_)
+                continue;
+
+            std::shared_ptr<Connection> connection;
+            bool is_listener = false;
+
+            {
+                std::lock_guard lock { mutex_ };
+
+                if (auto it = connections_.find(fd); it != std::end(connections_))
+                    connection = it->second;
+                else
+                    is_listener = listeners_.count(fd) != 0;
+            }
+
+            if (is_listener) {
+                Accept(fd);
+                continue;
+            }
+
+            if (!connection)
+                continue;
+
+            if ((flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !Receive(*connection)) {
+                Close(fd);
+                continue;
+            }
+
+            if (flags & EPOLLOUT) {
+                std::lock_guard lock { connection->mutex };
+
+                connection->SetWantWrite(false);
+                connection->Flush();
+            }
+        }
+    }
+}
+
+void SocketBridge::Accept(int listen_fd)
+{
+    for (;;) {
+        const auto fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        SetNoDelay(fd);
+
+        auto sender = AddConnection(fd);
+        if (!sender)
+            continue;
+
+        AcceptHandler on_accept;
+
+        {
+            std::lock_guard lock { mutex_ };
+
+            if (auto it = listeners_.find(listen_fd); it != std::end(listeners_))
+                on_accept = it->second;
+        }
+
+        if (on_accept)
+            on_accept(std::move(*sender));
+    }
+}
+
+// Returns false once the connection should be closed
+bool SocketBridge::Receive(Connection& connection)
+{
+    thread_local std::vector<std::uint8_t> buffer(kReadBufferSize);
+    thread_local std::vector<Message> batch;
+
+    bool ok = true;
+
+    for (int i = 0; i < kMaxReadCount; ++i) {
+        const auto size = ::read(connection.fd, std::data(buffer), std::size(buffer));
+
+        if (size < 0 && errno == EINTR)
+            continue;
+
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        if (size <= 0) {
+            ok = false;
+            break;
+        }
+
+        ok = connection.decoder.Feed(std::data(buffer), static_cast<std::size_t>(size), [](Message&& message) {
+            batch.push_back(std::move(message));
+        });
+
+        // Short read, the socket is drained
+        if (!ok || static_cast<std::size_t>(size) < std::size(buffer))
+            break;
+    }
+
+    // Frames decoded before an error are still delivered
+    if (!batch.empty()) {
+        sink_.PostBatch(std::data(batch), std::data(batch) + std::size(batch));
+        batch.clear();
+    }
+
+    return ok;
+}
+
+void SocketBridge::Close(int fd)
+{
+    std::shared_ptr<Connection> connection;
+
+    {
+        std::lock_guard lock { mutex_ };
+
+        if (auto it = connections_.find(fd); it != std::end(connections_)) {
+            connection = std::move(it->second);
+            connections_.erase(it);
+        }
+    }
+
+    if (!connection)
+        return;
+
+    std::lock_guard lock { connection->mutex };
+
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+
+    connection->fd = -1;
+    connection->pending.clear();
+    connection->offset = 0;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef SOCKET_BRIDGE_H_
+#define SOCKET_BRIDGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "message.h"
+#include "message_handler.h"
+
+class SocketBridge;
+
+// MessageHandler writing frames to one connection of a SocketBridge
+//  - Register it for remote endpoints, copies refer to the same connection
+//  - Frames are appended to the connection's send buffer, and the whole buffer goes out in one send()
+//  - PostBatch serializes every message before sending, so a batch costs one syscall
+//  - That send() runs on the calling thread, a router worker when registered, under the connection's mutex
+//    It never blocks, what the socket doesn't take is left for the bridge thread to flush on EPOLLOUT
+//  - Messages are dropped once the connection is closed or kMaxPendingSize bytes are unsent
+class SocketSender {
+public:
+    static constexpr std::size_t kMaxPendingSize { 64 << 20 };
+
+    void Post(Message&& message);
+
+    // Messages in [first, last) are moved from
+    void PostBatch(Message* first, Message* last);
+
+    bool IsConnected() const;
+
+    // Number of messages that were not sent
+    std::uint64_t GetDropCount() const noexcept;
+
+private:
+    friend class SocketBridge;
+
+    struct Connection;
+
+    explicit SocketSender(std::shared_ptr<Connection> connection)
+        : connection_ { std::move(connection) }
+    {
+    }
+
+    std::shared_ptr<Connection> connection_;
+};
+
+// TCP and Unix domain socket transport between MessageRouters of different processes
+//  - One thread waits on epoll for every listener and connection of the bridge
+//  - Frames read in one wakeup are decoded incrementally and handed to the sink with one PostBatch
+//  - Endpoints travel by name, since ids are only meaningful within one process
+//    A received frame sent to an endpoint this process has never seen is dropped, see FrameDecoder
+class SocketBridge {
+public:
+    // Called on the bridge thread for every accepted connection
+    using AcceptHandler = std::function<void(SocketSender)>;
+
+    static constexpr std::size_t kReadBufferSize { 64 << 10 };
+
+    // Received messages are posted to MessageRouter with TryPostBatch, those it rejects are counted
+    SocketBridge();
+
+    // Received messages are posted to sink instead, which runs on the bridge thread and must not block
+    explicit SocketBridge(MessageHandler sink);
+
+    // Connections are closed, existing SocketSenders drop further messages
+    ~SocketBridge();
+
+    SocketBridge(const SocketBridge&) = delete;
+    SocketBridge& operator=(const SocketBridge&) = delete;
+
+    // Returns the bound port, which is useful with port 0
+    std::optional<std::uint16_t> ListenTcp(const std::string& host, std::uint16_t port, AcceptHandler on_accept);
+
+    // Fails if path exists
+    bool ListenUnix(const std::string& path, AcceptHandler on_accept);
+
+    std::optional<SocketSender> ConnectTcp(const std::string& host, std::uint16_t port);
+    std::optional<SocketSender> ConnectUnix(const std::string& path);
+
+    // Number of received messages MessageRouter rejected, always 0 with a custom sink
+    std::uint64_t GetDropCount() const noexcept { return drop_count_.load(std::memory_order_relaxed); }
+
+private:
+    using Connection = SocketSender::Connection;
+
+    bool IsValid() const noexcept { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+
+    bool AddListener(int fd, AcceptHandler on_accept);
+    std::optional<SocketSender> AddConnection(int fd);
+
+    void Run();
+    void Accept(int fd);
+    bool Receive(Connection& connection);
+    void Close(int fd);
+
+    MessageHandler sink_;
+    std::atomic<std::uint64_t> drop_count_ { 0 };
+
+    int epoll_fd_ { -1 };
+    // eventfd, wakes the bridge thread for shutdown
+    int wake_fd_ { -1 };
+
+    // Both keyed by fd, guarded by mutex_
+    std::unordered_map<int, AcceptHandler> listeners_;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+    std::mutex mutex_;
+
+    std::atomic_bool done_ { false };
+    std::thread thread_;
+};
+
+#endif // SOCKET_BRIDGE_H_
\ No newline at end of file
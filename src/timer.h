@@ -1,26 +1,56 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
-#include <cassert>
+#include <cstdint>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <future>
-#include <shared_mutex>
-#include <string>
+#include <iterator>
+#include <mutex>
 #include <string_view>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "message_router.h"
 #include "singleton.h"
+#include "util/histogram.h"
+#include "util/timing_wheel.h"
 
 class Timer : public Singleton<Timer> {
+private:
+    struct Schedule {
+        Endpoint handler_id;
+        std::uint16_t message_id { 0 };
+
+        // In ticks, 0 for one-shot
+        std::uint64_t period { 0 };
+    };
+
 public:
+    using Handle = TimingWheel<Schedule>::Handle;
+
+    // Accuracy of ticks, measured as lateness of each wakeup from its deadline
+    struct Stats {
+        std::uint64_t ticks { 0 };
+
+        // Woke up more than one resolution late, expired schedules were delayed by a tick or more
+        std::uint64_t late_ticks { 0 };
+
+        std::chrono::nanoseconds mean { 0 };
+        std::chrono::nanoseconds p50 { 0 };
+        std::chrono::nanoseconds p99 { 0 };
+        std::chrono::nanoseconds p999 { 0 };
+        std::chrono::nanoseconds max { 0 };
+    };
+
+    static constexpr std::chrono::nanoseconds kDefaultResolution { std::chrono::milliseconds { 100 } };
+
     Timer()
-        : tick_ { 0 }
+        : resolution_ { resolution_config_.load(std::memory_order_relaxed) }
         , done_ { false }
         , task_ { std::async(std::launch::async, &Timer::Run, this) }
     {
@@ -34,100 +64,262 @@ public:
             task_.get();
     }
 
-    template <typename... Args>
-    void Register(Args&&... args)
+    // Must be called before the first GetInstance(), practical lower bound is about 100us
+    static void SetResolution(std::chrono::nanoseconds resolution)
+    {
+        resolution_config_.store(std::max(resolution, std::chrono::nanoseconds { 1 }), std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds GetResolution() const noexcept { return resolution_; }
+
+    Stats GetStats() const
+    {
+        std::lock_guard lock { stats_mutex_ };
+
+        Stats stats;
+        stats.ticks = jitter_.GetCount();
+        stats.late_ticks = late_ticks_;
+        stats.mean = std::chrono::nanoseconds { jitter_.GetMean() };
+        stats.p50 = std::chrono::nanoseconds { jitter_.GetPercentile(50.0) };
+        stats.p99 = std::chrono::nanoseconds { jitter_.GetPercentile(99.0) };
+        stats.p999 = std::chrono::nanoseconds { jitter_.GetPercentile(99.9) };
+        stats.max = std::chrono::nanoseconds { jitter_.GetMax() };
+
+        return stats;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard lock { stats_mutex_ };
+
+        jitter_.Reset();
+        late_ticks_ = 0;
+    }
+
+    // Post Message { message_id } to handler_id every period, starting one period from now
+    //  - Rounded up to a multiple of resolution
+    //  - Register the handler with QueueOptions::coalesce to keep at most one tick pending
+    Handle Register(Endpoint handler_id, std::uint16_t message_id, std::chrono::nanoseconds period)
+    {
+        const auto ticks = ToTicks(period);
+
+        return Add({ handler_id, message_id, ticks }, ticks);
+    }
+
+    // Post Message { message_id } to handler_id once after delay
+    Handle RegisterOnce(Endpoint handler_id, std::uint16_t message_id, std::chrono::nanoseconds delay)
+    {
+        return Add({ handler_id, message_id, 0 }, ToTicks(delay));
+    }
+
+    // O(1), returns false if already expired or cancelled
+    bool Unregister(Handle handle)
     {
-        const auto tick = tick_.load(std::memory_order_relaxed);
         std::lock_guard lock { mutex_ };
 
-        schedule_.emplace_back(std::forward<Args>(args)..., tick);
+        const auto* schedule = wheel_.Find(handle);
+        if (!schedule)
+            return false;
+
+        RemoveIndex(schedule->handler_id, handle);
+        wheel_.Cancel(handle);
+
+        return true;
     }
 
-    void Unregister(std::string_view handler_id)
+    // O(1), false once expired or cancelled
+    bool IsActive(Handle handle)
     {
         std::lock_guard lock { mutex_ };
 
-        schedule_.erase(
-            std::remove_if(
-                std::begin(schedule_),
-                std::end(schedule_),
-                [handler_id](const auto& item) { return item.handler_id == handler_id; }),
-            std::end(schedule_));
+        return wheel_.IsActive(handle);
     }
 
-    void Unregister(std::string_view handler_id, std::uint16_t message_id)
+    // O(number of schedules for handler_id)
+    void Unregister(Endpoint handler_id)
     {
         std::lock_guard lock { mutex_ };
 
-        schedule_.erase(
-            std::remove_if(
-                std::begin(schedule_),
-                std::end(schedule_),
-                [handler_id, message_id](const auto& item) { return item.handler_id == handler_id && item.message_id == message_id; }),
-            std::end(schedule_));
+        const auto it = handlers_.find(handler_id);
+        if (it == std::end(handlers_))
+            return;
+
+        for (const auto& [index, handle] : it->second)
+            wheel_.Cancel(handle);
+
+        handlers_.erase(it);
     }
 
-private:
-    struct Schedule {
-        Schedule(std::string_view handler_id, std::uint16_t message_id, std::chrono::milliseconds period, std::uint64_t tick)
-            : handler_id { handler_id }
-            , message_id { message_id }
-            , period { static_cast<std::uint32_t>(period.count() / kInterval.count()) }
-            , offset { static_cast<std::uint32_t>(tick % this->period) }
-        {
-            assert(this->period != 0);
+    void Unregister(Endpoint handler_id, std::uint16_t message_id)
+    {
+        std::lock_guard lock { mutex_ };
+
+        const auto handles = handlers_.find(handler_id);
+        if (handles == std::end(handlers_))
+            return;
+
+        auto it = std::begin(handles->second);
+
+        while (it != std::end(handles->second)) {
+            const auto* schedule = wheel_.Find(it->second);
+
+            if (schedule && schedule->message_id == message_id) {
+                wheel_.Cancel(it->second);
+                it = handles->second.erase(it);
+            } else {
+                ++it;
+            }
         }
 
-        std::string handler_id;
-        std::uint16_t message_id;
-        std::uint32_t period;
-        std::uint32_t offset;
-    };
+        if (handles->second.empty())
+            handlers_.erase(handles);
+    }
+
+    // By name, looked up with Endpoint::Find so a name that was never registered isn't interned
+    void Unregister(std::string_view handler_name)
+    {
+        if (const auto handler_id = Endpoint::Find(handler_name))
+            Unregister(*handler_id);
+    }
+
+    void Unregister(std::string_view handler_name, std::uint16_t message_id)
+    {
+        if (const auto handler_id = Endpoint::Find(handler_name))
+            Unregister(*handler_id, message_id);
+    }
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    // sleep_for() overshoots by the scheduler latency, so the last stretch is spent spinning
+    static constexpr std::chrono::nanoseconds kSpinThreshold { std::chrono::microseconds { 100 } };
+
+    std::uint64_t ToTicks(std::chrono::nanoseconds duration) const
+    {
+        // Round up, so it never fires earlier than requested
+        const auto ticks = (duration + resolution_ - std::chrono::nanoseconds { 1 }) / resolution_;
+
+        return std::max<std::uint64_t>(1, static_cast<std::uint64_t>(ticks));
+    }
+
+    Handle Add(Schedule schedule, std::uint64_t delay)
+    {
+        std::lock_guard lock { mutex_ };
+
+        const auto handler_id = schedule.handler_id;
+        const auto handle = wheel_.Schedule(std::move(schedule), delay);
+
+        handlers_[handler_id].emplace(handle.index, handle);
+
+        return handle;
+    }
+
+    void RemoveIndex(Endpoint handler_id, Handle handle)
+    {
+        const auto it = handlers_.find(handler_id);
+        if (it == std::end(handlers_))
+            return;
+
+        it->second.erase(handle.index);
+
+        if (it->second.empty())
+            handlers_.erase(it);
+    }
+
+    static void WaitUntil(Clock::time_point deadline)
+    {
+        if (const auto remain = deadline - Clock::now(); remain > kSpinThreshold)
+            std::this_thread::sleep_for(remain - kSpinThreshold);
+
+        while (Clock::now() < deadline)
+            std::this_thread::yield();
+    }
+
+    void RecordJitter(std::chrono::nanoseconds lateness)
+    {
+        std::lock_guard lock { stats_mutex_ };
+
+        jitter_.Record(static_cast<std::uint64_t>(std::max(lateness.count(), std::chrono::nanoseconds::rep { 0 })));
+
+        if (lateness > resolution_)
+            ++late_ticks_;
+    }
 
     void Run()
     {
         static constexpr auto kTimeDiff = std::chrono::seconds { 10 };
-        // static constexpr auto kProcessingDelay = std::chrono::nanoseconds { 100 };
-        // auto error = std::chrono::nanoseconds { 0 };
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = Clock::now();
+
+        // Ticks since start, only used for drift compensation
+        std::uint64_t tick = 0;
+
+        // Reused across ticks
+        std::vector<Message> expired;
+        std::vector<std::pair<Endpoint, Handle>> finished;
 
         while (!done_.load(std::memory_order_relaxed)) {
-            const auto tick = tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+            ++tick;
 
             {
-                std::shared_lock lock { mutex_ };
+                std::lock_guard lock { mutex_ };
 
-                for (const auto& schedule : schedule_) {
-                    if (tick % schedule.period == schedule.offset) {
-                        Message msg { schedule.message_id };
-                        msg.to = schedule.handler_id;
+                wheel_.Tick([&expired, &finished](Handle handle, const Schedule& schedule) {
+                    auto& msg = expired.emplace_back(schedule.message_id);
+                    msg.to = schedule.handler_id;
 
-                        MessageRouter::GetInstance().Post(std::move(msg));
-                    }
-                }
+                    if (schedule.period == 0)
+                        finished.emplace_back(schedule.handler_id, handle);
+
+                    return schedule.period;
+                });
+
+                for (const auto& [handler_id, handle] : finished)
+                    RemoveIndex(handler_id, handle);
+
+                finished.clear();
             }
 
-            const auto end = std::chrono::high_resolution_clock::now();
+            // A full handler drops the tick rather than stalling every schedule
+            if (!expired.empty()) {
+                MessageRouter::GetInstance().TryPostBatch(std::data(expired), std::data(expired) + std::size(expired));
+                expired.clear();
+            }
+
+            const auto end = Clock::now();
             const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
-            auto error = elapsed - std::chrono::duration_cast<std::chrono::nanoseconds>(tick * kInterval);
+            auto error = elapsed - static_cast<std::chrono::nanoseconds::rep>(tick) * resolution_;
 
             // Detect sleep mode, timezone change
             if (std::chrono::abs(error) > kTimeDiff) {
-                tick_.store(0, std::memory_order_release);
+                tick = 0;
                 error = std::chrono::nanoseconds { 0 };
                 start = end;
             }
 
-            if (kInterval > error)
-                std::this_thread::sleep_for(kInterval - error);
+            // Behind schedule when error exceeds resolution, catch up without waiting
+            const auto deadline = end + (resolution_ - error);
+
+            if (resolution_ > error)
+                WaitUntil(deadline);
+
+            RecordJitter(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline));
         }
     }
 
-    static constexpr std::chrono::milliseconds kInterval { 100 };
+    static inline std::atomic<std::chrono::nanoseconds> resolution_config_ { kDefaultResolution };
+
+    const std::chrono::nanoseconds resolution_;
+
+    TimingWheel<Schedule> wheel_;
+
+    // Handles by handler for bulk Unregister, keyed by Handle::index which is unique while active
+    std::unordered_map<Endpoint, std::unordered_map<std::uint32_t, Handle>> handlers_;
+    std::mutex mutex_;
+
+    Histogram jitter_;
+    std::uint64_t late_ticks_ { 0 };
+    mutable std::mutex stats_mutex_;
 
-    std::vector<Schedule> schedule_;
-    std::shared_mutex mutex_;
-    std::atomic_uint64_t tick_;
     std::atomic_bool done_;
     std::future<void> task_;
 };
@@ -1,10 +1,26 @@
 #ifndef BIT_H_
 #define BIT_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BIT_X86
+#include <immintrin.h>
+#endif
 
 #ifdef _MSC_VER
 #include <cstdlib>
+#ifdef BIT_X86
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(BIT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BIT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BIT_TARGET(isa)
 #endif
 
 #include "type_traits.h"
@@ -67,6 +83,141 @@ namespace detail {
         }
     }
 
+    // Reverse byte order of count elements of size N from src into dst
+    //  - src and dst may be unaligned, and may be equal for in-place conversion, but must not otherwise overlap
+    using byteswap_n_t = void (*)(const std::uint8_t* src, std::size_t count, std::uint8_t* dst);
+
+    template <std::size_t N>
+    void byteswap_n_scalar(const std::uint8_t* src, std::size_t count, std::uint8_t* dst) noexcept
+    {
+        using U = std::conditional_t<N == 2, std::uint16_t, std::conditional_t<N == 4, std::uint32_t, std::uint64_t>>;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            U value;
+            std::memcpy(&value, src + i * N, N);
+            value = byteswap(value);
+            std::memcpy(dst + i * N, &value, N);
+        }
+    }
+
+#ifdef BIT_X86
+    // Shuffle mask reversing each N-byte element within a 16-byte lane
+    template <std::size_t N>
+    constexpr char shuffle_mask(int i) noexcept
+    {
+        return static_cast<char>((i / N) * N + (N - 1 - i % N));
+    }
+
+    template <std::size_t N>
+    BIT_TARGET("ssse3")
+    void byteswap_n_ssse3(const std::uint8_t* src, std::size_t count, std::uint8_t* dst) noexcept
+    {
+        const auto mask = _mm_setr_epi8(
+            shuffle_mask<N>(0), shuffle_mask<N>(1), shuffle_mask<N>(2), shuffle_mask<N>(3),
+            shuffle_mask<N>(4), shuffle_mask<N>(5), shuffle_mask<N>(6), shuffle_mask<N>(7),
+            shuffle_mask<N>(8), shuffle_mask<N>(9), shuffle_mask<N>(10), shuffle_mask<N>(11),
+            shuffle_mask<N>(12), shuffle_mask<N>(13), shuffle_mask<N>(14), shuffle_mask<N>(15));
+
+        const auto bytes = count * N;
+        std::size_t i = 0;
+
+        for (; i + 16 <= bytes; i += 16) {
+            const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(value, mask));
+        }
+
+        byteswap_n_scalar<N>(src + i, (bytes - i) / N, dst + i);
+    }
+
+    template <std::size_t N>
+    BIT_TARGET("avx2")
+    void byteswap_n_avx2(const std::uint8_t* src, std::size_t count, std::uint8_t* dst) noexcept
+    {
+        // vpshufb shuffles within each 128-bit lane, so the mask is repeated
+        const auto mask = _mm256_setr_epi8(
+            shuffle_mask<N>(0), shuffle_mask<N>(1), shuffle_mask<N>(2), shuffle_mask<N>(3),
+            shuffle_mask<N>(4), shuffle_mask<N>(5), shuffle_mask<N>(6), shuffle_mask<N>(7),
+            shuffle_mask<N>(8), shuffle_mask<N>(9), shuffle_mask<N>(10), shuffle_mask<N>(11),
+            shuffle_mask<N>(12), shuffle_mask<N>(13), shuffle_mask<N>(14), shuffle_mask<N>(15),
+            shuffle_mask<N>(0), shuffle_mask<N>(1), shuffle_mask<N>(2), shuffle_mask<N>(3),
+            shuffle_mask<N>(4), shuffle_mask<N>(5), shuffle_mask<N>(6), shuffle_mask<N>(7),
+            shuffle_mask<N>(8), shuffle_mask<N>(9), shuffle_mask<N>(10), shuffle_mask<N>(11),
+            shuffle_mask<N>(12), shuffle_mask<N>(13), shuffle_mask<N>(14), shuffle_mask<N>(15));
+
+        const auto bytes = count * N;
+        std::size_t i = 0;
+
+        for (; i + 64 <= bytes; i += 64) {
+            const auto value0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            const auto value1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(value0, mask));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 32), _mm256_shuffle_epi8(value1, mask));
+        }
+
+        for (; i + 32 <= bytes; i += 32) {
+            const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(value, mask));
+        }
+
+        byteswap_n_scalar<N>(src + i, (bytes - i) / N, dst + i);
+    }
+
+    inline bool cpu_supports_avx2() noexcept
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    inline bool cpu_supports_ssse3() noexcept
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+#endif
+
+    template <std::size_t N>
+    byteswap_n_t select_byteswap_n() noexcept
+    {
+#ifdef BIT_X86
+        if (cpu_supports_avx2())
+            return byteswap_n_avx2<N>;
+        if (cpu_supports_ssse3())
+            return byteswap_n_ssse3<N>;
+#endif
+        return byteswap_n_scalar<N>;
+    }
+
+    // Runtime dispatch, resolved once per element size
+    template <std::size_t N>
+    void byteswap_n(const std::uint8_t* src, std::size_t count, std::uint8_t* dst) noexcept
+    {
+        static_assert(N == 2 || N == 4 || N == 8);
+
+        static const auto kernel = select_byteswap_n<N>();
+
+        kernel(src, count, dst);
+    }
+
 } // namespace detail
 
 enum class endian {
@@ -97,6 +248,36 @@ constexpr T ntoh(T value) noexcept
     return hton(value);
 }
 
+// Copy count integers from first into d_first in network byte order
+//  - d_first needs no alignment
+//  - first and d_first may be equal for in-place conversion, but must not otherwise overlap
+template <typename T>
+void hton_n(const T* first, std::size_t count, std::uint8_t* d_first) noexcept
+{
+    static_assert(std::is_integral_v<T>);
+
+    if constexpr (endian::native == endian::little && sizeof(T) != 1) {
+        detail::byteswap_n<sizeof(T)>(reinterpret_cast<const std::uint8_t*>(first), count, d_first);
+    } else if (static_cast<const void*>(first) != d_first) {
+        std::memcpy(d_first, first, count * sizeof(T));
+    }
+}
+
+// Copy count integers in network byte order from first into d_first
+//  - first needs no alignment
+//  - first and d_first may be equal for in-place conversion, but must not otherwise overlap
+template <typename T>
+void ntoh_n(const std::uint8_t* first, std::size_t count, T* d_first) noexcept
+{
+    static_assert(std::is_integral_v<T>);
+
+    if constexpr (endian::native == endian::little && sizeof(T) != 1) {
+        detail::byteswap_n<sizeof(T)>(first, count, reinterpret_cast<std::uint8_t*>(d_first));
+    } else if (static_cast<const void*>(first) != d_first) {
+        std::memcpy(d_first, first, count * sizeof(T));
+    }
+}
+
 } // namespace bit
 
 #endif // BIT_H_
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef CRC32C_H_
+#define CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+
+#include "bit.h"
+
+// CRC-32C (Castagnoli), as used by iSCSI and ext4
+//  - SSE4.2 has an instruction for it, selected at runtime like bit::hton_n
+namespace crc32c {
+
+namespace detail {
+
+    // Reflected polynomial
+    inline constexpr std::uint32_t kPolynomial { 0x82F6'3B78 };
+
+    constexpr std::array<std::uint32_t, 256> MakeTable()
+    {
+        std::array<std::uint32_t, 256> table {};
+
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ ((crc & 1) != 0 ? kPolynomial : 0);
+
+            table[i] = crc;
+        }
+
+        return table;
+    }
+
+    inline constexpr auto kTable = MakeTable();
+
+    // Take and return the internal, non-inverted state
+    using extend_t = std::uint32_t (*)(std::uint32_t crc, const std::uint8_t* data, std::size_t size);
+
+    inline std::uint32_t ExtendScalar(std::uint32_t crc, const std::uint8_t* data, std::size_t size) noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i)
+            crc = kTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+        return crc;
+    }
+
+#ifdef BIT_X86
+    BIT_TARGET("sse4.2")
+    inline std::uint32_t ExtendSse42(std::uint32_t crc, const std::uint8_t* data, std::size_t size) noexcept
+    {
+        std::size_t i = 0;
+
+#if defined(__x86_64__) || defined(_M_X64)
+        std::uint64_t crc64 = crc;
+
+        for (; i + 8 <= size; i += 8) {
+            std::uint64_t value;
+            std::memcpy(&value, data + i, 8);
+            crc64 = _mm_crc32_u64(crc64, value);
+        }
+
+        crc = static_cast<std::uint32_t>(crc64);
+#endif
+
+        for (; i < size; ++i)
+            crc = _mm_crc32_u8(crc, data[i]);
+
+        return crc;
+    }
+
+    inline bool CpuSupportsSse42() noexcept
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+#endif
+
+    inline extend_t SelectExtend() noexcept
+    {
+#ifdef BIT_X86
+        if (CpuSupportsSse42())
+            return ExtendSse42;
+#endif
+        return ExtendScalar;
+    }
+
+} // namespace detail
+
+// crc is the result for the preceding data, 0 at the start
+inline std::uint32_t Extend(std::uint32_t crc, const std::uint8_t* data, std::size_t size) noexcept
+{
+    static const auto kernel = detail::SelectExtend();
+
+    return ~kernel(~crc, data, size);
+}
+
+inline std::uint32_t Compute(const std::uint8_t* data, std::size_t size) noexcept
+{
+    return Extend(0, data, size);
+}
+
+} // namespace crc32c
+
+#endif // CRC32C_H_
\ No newline at end of file
@@ -0,0 +1,156 @@
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+
+// Log-linear histogram of non-negative integers
+//  - Each power of two is split into kSubBuckets, so relative error is below 1 / kSubBuckets
+//  - Fixed size, no allocation, not thread-safe
+class Histogram {
+public:
+    static constexpr std::size_t kSubBucketBits { 3 };
+    static constexpr std::size_t kSubBuckets { 1 << kSubBucketBits };
+    static constexpr std::size_t kBuckets { (64 - kSubBucketBits + 1) * kSubBuckets };
+
+    void Record(std::uint64_t value) noexcept
+    {
+        ++counts_[IndexOf(value)];
+        ++count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(const Histogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < kBuckets; ++i)
+            counts_[i] += other.counts_[i];
+
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void Reset() noexcept
+    {
+        *this = Histogram {};
+    }
+
+    // Upper bound of the bucket holding the p-th percentile, p in [0, 100]
+    std::uint64_t GetPercentile(double p) const noexcept
+    {
+        if (count_ == 0)
+            return 0;
+
+        const auto rank = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(count_ - 1)) + 1;
+        std::uint64_t seen = 0;
+
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+
+            if (seen >= rank)
+                return std::min(max_, UpperBoundOf(i));
+        }
+
+        return max_;
+    }
+
+    std::uint64_t GetCount() const noexcept { return count_; }
+    std::uint64_t GetSum() const noexcept { return sum_; }
+    std::uint64_t GetMin() const noexcept { return count_ != 0 ? min_ : 0; }
+    std::uint64_t GetMax() const noexcept { return max_; }
+    std::uint64_t GetMean() const noexcept { return count_ != 0 ? sum_ / count_ : 0; }
+
+private:
+    friend class AtomicHistogram;
+
+    static std::size_t IndexOf(std::uint64_t value) noexcept
+    {
+        if (value < kSubBuckets)
+            return static_cast<std::size_t>(value);
+
+        // Position of the highest set bit, at least kSubBucketBits
+        std::size_t msb = 0;
+        for (auto v = value; v >>= 1;)
+            ++msb;
+
+        const auto shift = msb - kSubBucketBits;
+        const auto sub = static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+
+        return (shift + 1) * kSubBuckets + sub;
+    }
+
+    static std::uint64_t UpperBoundOf(std::size_t index) noexcept
+    {
+        if (index < kSubBuckets)
+            return index;
+
+        const auto shift = index / kSubBuckets - 1;
+        const auto sub = index % kSubBuckets;
+        const auto lower = (std::uint64_t { kSubBuckets + sub }) << shift;
+
+        return lower + ((std::uint64_t { 1 } << shift) - 1);
+    }
+
+    std::array<std::uint64_t, kBuckets> counts_ {};
+    std::uint64_t count_ { 0 };
+    std::uint64_t sum_ { 0 };
+    std::uint64_t min_ { std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t max_ { 0 };
+};
+
+// Histogram any number of threads record into at once, with relaxed atomics
+//  - Read by merging into a Histogram, values recorded meanwhile may be partly counted
+class AtomicHistogram {
+public:
+    void Record(std::uint64_t value) noexcept
+    {
+        counts_[Histogram::IndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        auto min = min_.load(std::memory_order_relaxed);
+        while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) { }
+
+        auto max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+    }
+
+    void MergeInto(Histogram& histogram) const noexcept
+    {
+        for (std::size_t i = 0; i < Histogram::kBuckets; ++i)
+            histogram.counts_[i] += counts_[i].load(std::memory_order_relaxed);
+
+        histogram.count_ += count_.load(std::memory_order_relaxed);
+        histogram.sum_ += sum_.load(std::memory_order_relaxed);
+        histogram.min_ = std::min(histogram.min_, min_.load(std::memory_order_relaxed));
+        histogram.max_ = std::max(histogram.max_, max_.load(std::memory_order_relaxed));
+    }
+
+    void Reset() noexcept
+    {
+        for (auto& count : counts_)
+            count.store(0, std::memory_order_relaxed);
+
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, Histogram::kBuckets> counts_ {};
+    std::atomic<std::uint64_t> count_ { 0 };
+    std::atomic<std::uint64_t> sum_ { 0 };
+    std::atomic<std::uint64_t> min_ { std::numeric_limits<std::uint64_t>::max() };
+    std::atomic<std::uint64_t> max_ { 0 };
+};
+
+#endif // HISTOGRAM_H_
\ No newline at end of file
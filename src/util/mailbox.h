@@ -0,0 +1,137 @@
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include <cstddef>
+
+#include <atomic>
+#include <thread>
+
+#include "spin.h"
+
+// Intrusive multi-producer single-consumer mailbox, after Dmitry Vyukov's queue
+//  - T has a std::atomic<T*> next member and is default constructible, the mailbox never allocates
+//  - Push is wait-free, producers never wait for one another or for the consumer
+//  - The consumer role is handed around: the Push that finds the mailbox idle schedules a consumer,
+//    which pops until Release succeeds, so at most one thread consumes at a time
+//  - A push that has swapped head_ but not linked yet is waited out by spinning, then yielding
+template <typename T>
+class Mailbox {
+public:
+    Mailbox() = default;
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    // Returns true if the mailbox was idle, the caller must then schedule a consumer
+    bool Push(T* node) noexcept
+    {
+        Enqueue(node);
+
+        return !scheduled_.exchange(true, std::memory_order_seq_cst);
+    }
+
+    // Consumer side, oldest node or nullptr if nothing is queued
+    T* Pop() noexcept
+    {
+        auto* tail = tail_;
+        auto* next = Next(tail);
+
+        if (tail == &stub_) {
+            if (!next)
+                return nullptr;
+
+            tail_ = tail = next;
+            next = Next(tail);
+        }
+
+        if (!next) {
+            // tail is the last node, the stub takes its place so it can be handed out
+            Enqueue(&stub_);
+            next = Next(tail);
+        }
+
+        tail_ = next;
+
+        return tail;
+    }
+
+    // Consumer side, exact since only the consumer moves tail_
+    bool IsEmpty() const noexcept
+    {
+        return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;
+    }
+
+    // Consumer side, give up the role once empty
+    //  - Returns false if nodes are left or pushed meanwhile, the caller stays the consumer
+    bool Release() noexcept
+    {
+        if (!IsEmpty())
+            return false;
+
+        scheduled_.store(false, std::memory_order_seq_cst);
+
+        // Pairs with Push, either it sees the flag cleared or this sees its node
+        //  - tail_ can't be read anymore, another consumer may be scheduled already
+        if (head_.load(std::memory_order_seq_cst) == &stub_)
+            return true;
+
+        // Taken back unless the producer scheduled another consumer
+        return scheduled_.exchange(true, std::memory_order_seq_cst);
+    }
+
+    // Call f(T&) for every node from the oldest, nodes pushed meanwhile may be missed
+    //  - Any thread, as long as no Pop runs concurrently, e.g. both hold the same mutex
+    template <typename F>
+    void ForEach(F&& f)
+    {
+        const auto* head = head_.load(std::memory_order_acquire);
+
+        for (auto* node = tail_; node;) {
+            if (node != &stub_)
+                f(*node);
+
+            if (node == head)
+                break;
+
+            node = Next(node);
+        }
+    }
+
+private:
+    static constexpr std::size_t kSpinCount { 64 };
+
+    void Enqueue(T* node) noexcept
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+
+        auto* prev = head_.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Link after node, waiting if a later push has swapped head_ but not linked it yet
+    T* Next(T* node) const noexcept
+    {
+        for (std::size_t attempt = 0;; ++attempt) {
+            auto* next = node->next.load(std::memory_order_acquire);
+
+            if (next || head_.load(std::memory_order_acquire) == node)
+                return next;
+
+            if (attempt < kSpinCount)
+                SpinPause();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    T stub_;
+
+    // Written by producers
+    alignas(64) std::atomic<T*> head_ { &stub_ };
+    std::atomic_bool scheduled_ { false };
+
+    // Only the consumer touches tail_
+    alignas(64) T* tail_ { &stub_ };
+};
+
+#endif // MAILBOX_H_
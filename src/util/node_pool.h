@@ -0,0 +1,124 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+#include <cstddef>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Recycles intrusive nodes between threads, so steady traffic doesn't allocate
+//  - T has a std::atomic<T*> next member and is default constructible, free nodes are chained through next
+//  - Each thread keeps up to 2 * kBatch free nodes, beyond that a chain of kBatch goes to a shared stack
+//  - A thread out of nodes takes a whole chain back, so the shared mutex is taken once per kBatch nodes
+//  - Nodes are never freed, the pool holds as many as were ever in flight at once
+//
+// Nodes typically flow from producers, which Acquire, to consumers, which Release, and back in chains
+template <typename T>
+class NodePool {
+public:
+    static constexpr std::size_t kBatch { 64 };
+
+    // Default constructed node, or one in the state it was released in
+    static T* Acquire()
+    {
+        auto& cache = LocalCache();
+
+        if (!cache.head && !TakeChain(cache))
+            return new T;
+
+        auto* node = cache.head;
+        cache.head = node->next.load(std::memory_order_relaxed);
+        --cache.size;
+
+        node->next.store(nullptr, std::memory_order_relaxed);
+
+        return node;
+    }
+
+    // Node must not be referred to by anything else, e.g. popped from its Mailbox
+    static void Release(T* node)
+    {
+        auto& cache = LocalCache();
+
+        node->next.store(cache.head, std::memory_order_relaxed);
+        cache.head = node;
+
+        if (++cache.size == 2 * kBatch)
+            GiveChain(cache, kBatch);
+    }
+
+private:
+    struct Chain {
+        T* head;
+        std::size_t size;
+    };
+
+    struct Shared {
+        std::vector<Chain> chains;
+        std::mutex mutex;
+    };
+
+    // Nodes are handed to other threads when it exits
+    struct Cache {
+        ~Cache()
+        {
+            if (head)
+                GiveChain(*this, size);
+        }
+
+        T* head { nullptr };
+        std::size_t size { 0 };
+    };
+
+    static Cache& LocalCache()
+    {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    // Never destroyed, caches of other threads may be destroyed after static destruction
+    static Shared& GetShared()
+    {
+        static auto* shared = new Shared;
+        return *shared;
+    }
+
+    static bool TakeChain(Cache& cache)
+    {
+        auto& shared = GetShared();
+        std::lock_guard lock { shared.mutex };
+
+        if (shared.chains.empty())
+            return false;
+
+        const auto chain = shared.chains.back();
+        shared.chains.pop_back();
+
+        cache.head = chain.head;
+        cache.size = chain.size;
+
+        return true;
+    }
+
+    // Split the first size nodes off cache
+    static void GiveChain(Cache& cache, std::size_t size)
+    {
+        const Chain chain { cache.head, size };
+        auto* last = cache.head;
+
+        for (std::size_t i = 1; i < size; ++i)
+            last = last->next.load(std::memory_order_relaxed);
+
+        cache.head = last->next.load(std::memory_order_relaxed);
+        cache.size -= size;
+        last->next.store(nullptr, std::memory_order_relaxed);
+
+        auto& shared = GetShared();
+        std::lock_guard lock { shared.mutex };
+
+        shared.chains.push_back(chain);
+    }
+};
+
+#endif // NODE_POOL_H_
@@ -0,0 +1,207 @@
+#ifndef RCU_H_
+#define RCU_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Grace period domain shared by every Rcu<T>
+//  - Each reader thread owns one slot, written only by itself
+//  - Slot holds the epoch observed when the outermost read-side section started, 0 if quiescent
+class RcuDomain {
+public:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch { 0 };
+        std::uint32_t depth { 0 };
+        bool in_use { true };
+    };
+
+    static RcuDomain& GetInstance()
+    {
+        // Never destroyed, reader threads may exit after static destruction
+        static auto* domain = new RcuDomain;
+        return *domain;
+    }
+
+    void Lock()
+    {
+        auto& slot = LocalSlot();
+
+        if (slot.depth++ == 0)
+            slot.epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+
+    void Unlock()
+    {
+        auto& slot = LocalSlot();
+
+        if (--slot.depth == 0)
+            slot.epoch.store(0, std::memory_order_release);
+    }
+
+    // Wait until every read-side section started before the call has finished
+    //  - Must not be called within a read-side section
+    void Synchronize()
+    {
+        const auto target = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+        // Spin outside the lock, so threads acquiring a slot don't wait for readers
+        //  - Slots are never freed, and one acquired after the snapshot starts at target or later
+        std::vector<const Slot*> slots;
+
+        {
+            std::lock_guard lock { mutex_ };
+
+            slots.reserve(std::size(slots_));
+
+            for (const auto& slot : slots_)
+                slots.push_back(slot.get());
+        }
+
+        for (const auto* slot : slots) {
+            for (;;) {
+                const auto epoch = slot->epoch.load(std::memory_order_seq_cst);
+                if (epoch == 0 || epoch >= target)
+                    break;
+
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    // Slots are recycled on thread exit and never freed while the domain lives
+    class SlotHandle {
+    public:
+        explicit SlotHandle(RcuDomain& domain)
+            : domain_ { domain }
+            , slot_ { domain.Acquire() }
+        {
+        }
+
+        ~SlotHandle()
+        {
+            domain_.Release(slot_);
+        }
+
+        Slot& Get() const noexcept { return *slot_; }
+
+    private:
+        RcuDomain& domain_;
+        Slot* slot_;
+    };
+
+    Slot& LocalSlot()
+    {
+        thread_local SlotHandle handle { *this };
+
+        return handle.Get();
+    }
+
+    Slot* Acquire()
+    {
+        std::lock_guard lock { mutex_ };
+
+        for (auto& slot : slots_) {
+            if (!slot->in_use) {
+                slot->in_use = true;
+                return slot.get();
+            }
+        }
+
+        return slots_.emplace_back(std::make_unique<Slot>()).get();
+    }
+
+    void Release(Slot* slot)
+    {
+        std::lock_guard lock { mutex_ };
+
+        slot->in_use = false;
+    }
+
+    std::atomic<std::uint64_t> epoch_ { 1 };
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+};
+
+// Read-mostly value with copy-on-write updates
+//  - Read() never blocks and doesn't write to any shared cache line
+//  - Update() copies the value, publishes the copy and waits for readers of the old one
+template <typename T>
+class Rcu {
+public:
+    Rcu()
+        : current_ { new T {} }
+    {
+    }
+
+    explicit Rcu(T value)
+        : current_ { new T { std::move(value) } }
+    {
+    }
+
+    Rcu(const Rcu&) = delete;
+    Rcu& operator=(const Rcu&) = delete;
+
+    ~Rcu()
+    {
+        delete current_.load(std::memory_order_relaxed);
+    }
+
+    // Reference passed to f must not escape
+    template <typename F>
+    decltype(auto) Read(F&& f) const
+    {
+        auto& domain = RcuDomain::GetInstance();
+
+        struct Guard {
+            explicit Guard(RcuDomain& domain)
+                : domain { domain }
+            {
+                domain.Lock();
+            }
+
+            ~Guard()
+            {
+                domain.Unlock();
+            }
+
+            RcuDomain& domain;
+        } guard { domain };
+
+        return std::forward<F>(f)(*current_.load(std::memory_order_seq_cst));
+    }
+
+    // f(T&) returns false to discard the modification
+    //  - Must not be called within Read()
+    template <typename F>
+    void Update(F&& f)
+    {
+        std::lock_guard lock { mutex_ };
+
+        auto next = std::make_unique<T>(*current_.load(std::memory_order_relaxed));
+
+        if constexpr (std::is_same_v<std::invoke_result_t<F, T&>, bool>) {
+            if (!std::forward<F>(f)(*next))
+                return;
+        } else {
+            std::forward<F>(f)(*next);
+        }
+
+        std::unique_ptr<const T> prev { current_.exchange(next.release(), std::memory_order_seq_cst) };
+
+        RcuDomain::GetInstance().Synchronize();
+    }
+
+private:
+    std::atomic<const T*> current_;
+    std::mutex mutex_;
+};
+
+#endif // RCU_H_
\ No newline at end of file
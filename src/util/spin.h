@@ -0,0 +1,18 @@
+#ifndef SPIN_H_
+#define SPIN_H_
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Hint for the body of a spin-wait loop, lets the sibling hyperthread run and saves power
+inline void SpinPause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // SPIN_H_
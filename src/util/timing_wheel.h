@@ -0,0 +1,224 @@
+#ifndef TIMING_WHEEL_H_
+#define TIMING_WHEEL_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel counted in ticks
+//  - 4 levels of 256 slots cover 2^32 ticks, longer delays are cascaded again
+//  - Schedule() and Cancel() are O(1), Tick() is O(expired + cascaded)
+//  - Not thread-safe
+template <typename T>
+class TimingWheel {
+public:
+    // Stays valid for periodic entries until cancelled
+    struct Handle {
+        std::uint32_t index { kNil };
+        std::uint32_t generation { 0 };
+
+        friend bool operator==(Handle lhs, Handle rhs) { return lhs.index == rhs.index && lhs.generation == rhs.generation; }
+        friend bool operator!=(Handle lhs, Handle rhs) { return !(lhs == rhs); }
+    };
+
+    std::uint64_t GetTick() const noexcept { return now_; }
+    std::size_t GetSize() const noexcept { return size_; }
+
+    // Expire after delay ticks, at least 1
+    Handle Schedule(T value, std::uint64_t delay)
+    {
+        std::uint32_t index;
+
+        if (free_ != kNil) {
+            index = free_;
+            free_ = nodes_[index].next;
+        } else {
+            index = static_cast<std::uint32_t>(std::size(nodes_));
+            nodes_.emplace_back();
+        }
+
+        auto& node = nodes_[index];
+        node.value = std::move(value);
+        node.expiry = now_ + std::max<std::uint64_t>(delay, 1);
+
+        Link(index);
+        ++size_;
+
+        return { index, node.generation };
+    }
+
+    // Returns false if already expired or cancelled
+    bool Cancel(Handle handle)
+    {
+        if (!IsActive(handle))
+            return false;
+
+        Unlink(handle.index);
+        Free(handle.index);
+
+        return true;
+    }
+
+    bool IsActive(Handle handle) const
+    {
+        return handle.index < std::size(nodes_)
+            && nodes_[handle.index].generation == handle.generation
+            && nodes_[handle.index].slot != kNil;
+    }
+
+    T* Find(Handle handle)
+    {
+        return IsActive(handle) ? &nodes_[handle.index].value : nullptr;
+    }
+
+    // Advance one tick and call f(handle, value) for each expired entry
+    //  - f returns the delay to reschedule the same handle after, 0 to remove it
+    //  - f must not call Schedule() or Cancel()
+    template <typename F>
+    void Tick(F&& f)
+    {
+        ++now_;
+
+        // Cascade from the highest level whose slot starts at this tick
+        std::size_t level = 0;
+        while (level + 1 < kLevels && ((now_ >> (kSlotBits * (level + 1))) << (kSlotBits * (level + 1))) == now_)
+            ++level;
+
+        for (; level > 0; --level)
+            Cascade(level);
+
+        auto index = heads_[SlotOf(0, now_)];
+
+        while (index != kNil) {
+            const auto next = nodes_[index].next;
+
+            Unlink(index);
+
+            auto& node = nodes_[index];
+
+            if (node.expiry > now_) {
+                // Delay was longer than the wheel
+                Link(index);
+            } else if (const auto delay = f(Handle { index, node.generation }, node.value); delay != 0) {
+                node.expiry = now_ + delay;
+                Link(index);
+            } else {
+                Free(index);
+            }
+
+            index = next;
+        }
+    }
+
+private:
+    static constexpr std::size_t kLevels { 4 };
+    static constexpr std::size_t kSlotBits { 8 };
+    static constexpr std::size_t kSlots { 1 << kSlotBits };
+    static constexpr std::uint32_t kNil { std::numeric_limits<std::uint32_t>::max() };
+
+    struct Node {
+        T value {};
+        std::uint64_t expiry { 0 };
+        std::uint32_t prev { kNil };
+        std::uint32_t next { kNil };
+        std::uint32_t slot { kNil };
+        std::uint32_t generation { 0 };
+    };
+
+    static std::uint32_t SlotOf(std::size_t level, std::uint64_t expiry)
+    {
+        return static_cast<std::uint32_t>(level * kSlots + ((expiry >> (kSlotBits * level)) & (kSlots - 1)));
+    }
+
+    void Link(std::uint32_t index)
+    {
+        auto& node = nodes_[index];
+
+        static constexpr auto kRange = std::uint64_t { 1 } << (kSlotBits * kLevels);
+
+        const auto delta = node.expiry - now_;
+        const auto expiry = delta < kRange ? node.expiry : now_ + kRange - 1;
+
+        std::size_t level = 0;
+        while ((expiry - now_) >> (kSlotBits * (level + 1)) != 0)
+            ++level;
+
+        const auto slot = SlotOf(level, expiry);
+
+        node.slot = slot;
+        node.prev = kNil;
+        node.next = heads_[slot];
+
+        if (node.next != kNil)
+            nodes_[node.next].prev = index;
+
+        heads_[slot] = index;
+    }
+
+    void Unlink(std::uint32_t index)
+    {
+        auto& node = nodes_[index];
+        assert(node.slot != kNil);
+
+        if (node.prev != kNil)
+            nodes_[node.prev].next = node.next;
+        else
+            heads_[node.slot] = node.next;
+
+        if (node.next != kNil)
+            nodes_[node.next].prev = node.prev;
+
+        node.slot = kNil;
+    }
+
+    void Free(std::uint32_t index)
+    {
+        auto& node = nodes_[index];
+
+        node.value = T {};
+        node.next = free_;
+        ++node.generation;
+
+        free_ = index;
+        --size_;
+    }
+
+    void Cascade(std::size_t level)
+    {
+        const auto slot = SlotOf(level, now_);
+        auto index = heads_[slot];
+
+        heads_[slot] = kNil;
+
+        while (index != kNil) {
+            const auto next = nodes_[index].next;
+
+            Link(index);
+            index = next;
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::array<std::uint32_t, kLevels * kSlots> heads_ { MakeHeads() };
+    std::uint32_t free_ { kNil };
+    std::size_t size_ { 0 };
+    std::uint64_t now_ { 0 };
+
+    static constexpr std::array<std::uint32_t, kLevels * kSlots> MakeHeads()
+    {
+        std::array<std::uint32_t, kLevels * kSlots> heads {};
+
+        for (auto& head : heads)
+            head = kNil;
+
+        return heads;
+    }
+};
+
+#endif // TIMING_WHEEL_H_
\ No newline at end of file
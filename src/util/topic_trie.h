@@ -0,0 +1,173 @@
+#ifndef TOPIC_TRIE_H_
+#define TOPIC_TRIE_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Values subscribed by topic pattern, levels are separated by '/'
+//  - '+' matches exactly one level, e.g. "a/+/c" matches "a/b/c"
+//  - '#' as the last level matches the remaining levels, none included, e.g. "a/#" matches "a" and "a/b/c"
+//  - Children are kept sorted, so each level is a binary search
+//  - Copyable and not thread-safe, meant to be updated through Rcu
+template <typename T>
+class TopicTrie {
+public:
+    static constexpr char kSeparator { '/' };
+    static constexpr std::string_view kSingleLevel { "+" };
+    static constexpr std::string_view kMultiLevel { "#" };
+
+    // Returns false if value is already subscribed to pattern
+    bool Insert(std::string_view pattern, const T& value)
+    {
+        auto* node = &root_;
+
+        ForEachLevel(pattern, [&node](std::string_view level) {
+            auto it = LowerBound(*node, level);
+
+            if (it == std::end(node->children) || it->level != level)
+                it = node->children.insert(it, Child { std::string { level }, {} });
+
+            node = &it->node;
+        });
+
+        if (std::find(std::begin(node->values), std::end(node->values), value) != std::end(node->values))
+            return false;
+
+        node->values.push_back(value);
+        ++size_;
+
+        return true;
+    }
+
+    // Returns false if value isn't subscribed to pattern
+    bool Erase(std::string_view pattern, const T& value)
+    {
+        if (!Erase(root_, pattern, value))
+            return false;
+
+        --size_;
+
+        return true;
+    }
+
+    // Calls f(const T&) for every pattern matching topic
+    //  - A value subscribed with several matching patterns is passed once for each
+    template <typename F>
+    void Match(std::string_view topic, F&& f) const
+    {
+        Match(root_, topic, false, f);
+    }
+
+    // Number of subscriptions
+    std::size_t GetSize() const noexcept { return size_; }
+
+private:
+    struct Child;
+
+    struct Node {
+        std::vector<Child> children;
+        std::vector<T> values;
+    };
+
+    struct Child {
+        std::string level;
+        Node node;
+    };
+
+    template <typename F>
+    static void ForEachLevel(std::string_view topic, F&& f)
+    {
+        for (;;) {
+            const auto pos = topic.find(kSeparator);
+            f(topic.substr(0, pos));
+
+            if (pos == std::string_view::npos)
+                break;
+
+            topic.remove_prefix(pos + 1);
+        }
+    }
+
+    static auto LowerBound(Node& node, std::string_view level)
+    {
+        return std::lower_bound(std::begin(node.children), std::end(node.children), level, [](const Child& child, std::string_view key) { return child.level < key; });
+    }
+
+    static const Node* Find(const Node& node, std::string_view level)
+    {
+        const auto it = std::lower_bound(std::cbegin(node.children), std::cend(node.children), level, [](const Child& child, std::string_view key) { return child.level < key; });
+
+        return it != std::cend(node.children) && it->level == level ? &it->node : nullptr;
+    }
+
+    // Empty nodes are pruned on the way back
+    static bool Erase(Node& node, std::string_view pattern, const T& value)
+    {
+        const auto pos = pattern.find(kSeparator);
+        const auto level = pattern.substr(0, pos);
+
+        const auto it = LowerBound(node, level);
+        if (it == std::end(node.children) || it->level != level)
+            return false;
+
+        auto& child = it->node;
+        bool erased = false;
+
+        if (pos == std::string_view::npos) {
+            const auto value_it = std::find(std::begin(child.values), std::end(child.values), value);
+
+            if (value_it != std::end(child.values)) {
+                child.values.erase(value_it);
+                erased = true;
+            }
+        } else {
+            erased = Erase(child, pattern.substr(pos + 1), value);
+        }
+
+        if (child.children.empty() && child.values.empty())
+            node.children.erase(it);
+
+        return erased;
+    }
+
+    // done is set once every level of the topic is consumed
+    template <typename F>
+    static void Match(const Node& node, std::string_view topic, bool done, F& f)
+    {
+        if (const auto* multi = Find(node, kMultiLevel)) {
+            for (const auto& value : multi->values)
+                f(value);
+        }
+
+        if (done) {
+            for (const auto& value : node.values)
+                f(value);
+
+            return;
+        }
+
+        const auto pos = topic.find(kSeparator);
+        const auto level = topic.substr(0, pos);
+        const auto rest = pos == std::string_view::npos ? std::string_view {} : topic.substr(pos + 1);
+        const auto last = pos == std::string_view::npos;
+
+        if (const auto* child = Find(node, level))
+            Match(*child, rest, last, f);
+
+        if (level != kSingleLevel && level != kMultiLevel) {
+            if (const auto* child = Find(node, kSingleLevel))
+                Match(*child, rest, last, f);
+        }
+    }
+
+    Node root_;
+    std::size_t size_ { 0 };
+};
+
+#endif // TOPIC_TRIE_H_
\ No newline at end of file
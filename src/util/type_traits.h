@@ -1,7 +1,12 @@
 #ifndef TYPE_TRAITS_H_
 #define TYPE_TRAITS_H_
 
+#include <cstddef>
+
 #include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace type_traits {
 
@@ -11,11 +16,65 @@ using remove_cvref_t = std::remove_cv_t<std::remove_reference_t<T>>;
 template <typename T>
 inline constexpr bool always_false_v = false;
 
+// Passes a type as a value, e.g. to a generic lambda
 template <typename T>
-inline constexpr bool is_vector_v = false;
+struct type_identity {
+    using type = T;
+};
 
 template <typename T>
-inline constexpr bool is_vector_v<std::vector<T>> = true;
+inline constexpr bool is_vector_v = false;
+
+template <typename T, typename Allocator>
+inline constexpr bool is_vector_v<std::vector<T, Allocator>> = true;
+
+namespace detail {
+
+    template <typename Void, template <typename...> typename Op, typename... Args>
+    inline constexpr bool is_detected_v = false;
+
+    template <template <typename...> typename Op, typename... Args>
+    inline constexpr bool is_detected_v<std::void_t<Op<Args...>>, Op, Args...> = true;
+
+    template <typename T, typename Variant>
+    inline constexpr std::size_t variant_index_v = 0;
+
+    template <typename T, typename... Ts>
+    inline constexpr std::size_t variant_index_v<T, std::variant<Ts...>> = [] {
+        constexpr bool matches[] = { std::is_same_v<T, Ts>... };
+
+        std::size_t index = 0;
+        while (index < sizeof...(Ts) && !matches[index])
+            ++index;
+
+        return index;
+    }();
+
+} // namespace detail
+
+// True if Op<Args...> is well-formed
+template <template <typename...> typename Op, typename... Args>
+inline constexpr bool is_detected_v = detail::is_detected_v<void, Op, Args...>;
+
+// Index of T within std::variant<Ts...>, std::variant_npos if not an alternative
+template <typename T, typename Variant>
+inline constexpr std::size_t variant_index_v = detail::variant_index_v<T, Variant> < std::variant_size_v<Variant>
+    ? detail::variant_index_v<T, Variant>
+    : std::variant_npos;
+
+// Call f(type_identity<T>) with the alternative of Variant at index, R {} if there's none
+template <typename Variant, typename R, std::size_t I = 0, typename F>
+R visit_alternative(std::size_t index, F&& f)
+{
+    if constexpr (I < std::variant_size_v<Variant>) {
+        if (index == I)
+            return std::forward<F>(f)(type_identity<std::variant_alternative_t<I, Variant>> {});
+
+        return visit_alternative<Variant, R, I + 1>(index, std::forward<F>(f));
+    } else {
+        return R {};
+    }
+}
 
 } // namespace type_traits
 
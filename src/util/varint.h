@@ -0,0 +1,67 @@
+#ifndef VARINT_H_
+#define VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Unsigned LEB128, 7 bits per byte with the high bit set on all but the last byte
+//  - Signed values are zigzag mapped first, so small negative values stay short
+namespace varint {
+
+inline constexpr std::size_t kMaxSize { 10 };
+
+constexpr std::uint64_t ZigZagEncode(std::int64_t value) noexcept
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr std::int64_t ZigZagDecode(std::uint64_t value) noexcept
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+constexpr std::size_t EncodedSize(std::uint64_t value) noexcept
+{
+    std::size_t size = 1;
+
+    for (; value >= 0x80; value >>= 7)
+        ++size;
+
+    return size;
+}
+
+// Returns the end of written data, first must hold EncodedSize(value) bytes
+inline std::uint8_t* Encode(std::uint64_t value, std::uint8_t* first) noexcept
+{
+    for (; value >= 0x80; value >>= 7)
+        *first++ = static_cast<std::uint8_t>(value | 0x80);
+
+    *first++ = static_cast<std::uint8_t>(value);
+
+    return first;
+}
+
+// Returns the end of read data, or nullptr if truncated or overflowing 64-bit
+inline const std::uint8_t* Decode(const std::uint8_t* first, const std::uint8_t* last, std::uint64_t& value) noexcept
+{
+    value = 0;
+
+    for (std::size_t shift = 0; first != last && shift < 64; shift += 7) {
+        const auto byte = *first++;
+
+        // 10th byte may only carry the highest bit
+        if (shift == 63 && byte > 1)
+            return nullptr;
+
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return first;
+    }
+
+    return nullptr;
+}
+
+} // namespace varint
+
+#endif // VARINT_H_
\ No newline at end of file
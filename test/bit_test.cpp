@@ -0,0 +1,142 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/bit.h"
+
+namespace {
+
+// Every kernel the CPU can run for element size N, scalar first
+template <std::size_t N>
+std::vector<bit::detail::byteswap_n_t> GetKernels()
+{
+    std::vector<bit::detail::byteswap_n_t> kernels { bit::detail::byteswap_n_scalar<N> };
+
+#ifdef BIT_X86
+    if (bit::detail::cpu_supports_ssse3())
+        kernels.push_back(bit::detail::byteswap_n_ssse3<N>);
+
+    if (bit::detail::cpu_supports_avx2())
+        kernels.push_back(bit::detail::byteswap_n_avx2<N>);
+#endif
+
+    return kernels;
+}
+
+// Element i holds bytes i * N + 1 ... (i + 1) * N, so any misplaced byte shows
+std::vector<std::uint8_t> MakeBytes(std::size_t size)
+{
+    std::vector<std::uint8_t> bytes(size);
+    std::iota(std::begin(bytes), std::end(bytes), std::uint8_t { 1 });
+
+    return bytes;
+}
+
+template <std::size_t N>
+std::vector<std::uint8_t> Reversed(const std::uint8_t* src, std::size_t count)
+{
+    std::vector<std::uint8_t> result(count * N);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t j = 0; j < N; ++j)
+            result[i * N + j] = src[i * N + N - 1 - j];
+    }
+
+    return result;
+}
+
+// Counts up to 65 cover every tail after the 16, 32 and 64-byte loops, at misaligned offsets too
+template <std::size_t N>
+void ExpectKernelsAgree()
+{
+    constexpr std::size_t kMaxCount { 65 };
+
+    const auto kernels = GetKernels<N>();
+
+    for (std::size_t k = 0; k < std::size(kernels); ++k) {
+        for (std::size_t count = 0; count <= kMaxCount; ++count) {
+            for (const std::size_t offset : { 0, 1, 3 }) {
+                const auto src = MakeBytes(offset + count * N);
+                const auto expected = Reversed<N>(std::data(src) + offset, count);
+
+                // Guard bytes past the end must survive
+                std::vector<std::uint8_t> dst(offset + count * N + 16, 0xEE);
+                kernels[k](std::data(src) + offset, count, std::data(dst) + offset);
+
+                EXPECT_TRUE(std::equal(std::begin(expected), std::end(expected), std::begin(dst) + static_cast<std::ptrdiff_t>(offset))) << N << " " << k << " " << count << " " << offset;
+                EXPECT_TRUE(std::all_of(std::end(dst) - 16, std::end(dst), [](std::uint8_t byte) { return byte == 0xEE; })) << N << " " << k << " " << count;
+
+                // In place
+                auto in_place = src;
+                kernels[k](std::data(in_place) + offset, count, std::data(in_place) + offset);
+
+                EXPECT_TRUE(std::equal(std::begin(expected), std::end(expected), std::begin(in_place) + static_cast<std::ptrdiff_t>(offset))) << N << " " << k << " " << count << " " << offset;
+            }
+        }
+    }
+}
+
+TEST(BitTest, ByteswapKernelsAgree)
+{
+    ExpectKernelsAgree<2>();
+    ExpectKernelsAgree<4>();
+    ExpectKernelsAgree<8>();
+}
+
+template <typename T>
+void ExpectRoundTrip()
+{
+    for (std::size_t count = 0; count <= 65; ++count) {
+        std::vector<T> values(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+            values[i] = static_cast<T>(std::numeric_limits<T>::max() - static_cast<T>(i * 37));
+
+        std::vector<std::uint8_t> bytes(count * sizeof(T));
+        bit::hton_n(std::data(values), count, std::data(bytes));
+
+        // Big-endian, most significant byte first
+        for (std::size_t i = 0; i < count; ++i) {
+            auto value = static_cast<std::make_unsigned_t<T>>(values[i]);
+
+            for (std::size_t j = sizeof(T); j-- > 0; value = static_cast<std::make_unsigned_t<T>>(value >> 8))
+                EXPECT_EQ(bytes[i * sizeof(T) + j], static_cast<std::uint8_t>(value)) << sizeof(T) << " " << count;
+        }
+
+        std::vector<T> result(count);
+        bit::ntoh_n(std::data(bytes), count, std::data(result));
+
+        EXPECT_EQ(result, values) << sizeof(T) << " " << count;
+
+        // In place, both directions
+        auto in_place = values;
+        auto* data = reinterpret_cast<std::uint8_t*>(std::data(in_place));
+
+        bit::hton_n(std::data(in_place), count, data);
+        EXPECT_TRUE(std::equal(std::begin(bytes), std::end(bytes), data)) << sizeof(T) << " " << count;
+
+        bit::ntoh_n(data, count, std::data(in_place));
+        EXPECT_EQ(in_place, values) << sizeof(T) << " " << count;
+    }
+}
+
+TEST(BitTest, HtonNtohEveryElementSize)
+{
+    ExpectRoundTrip<std::int8_t>();
+    ExpectRoundTrip<std::uint8_t>();
+    ExpectRoundTrip<std::int16_t>();
+    ExpectRoundTrip<std::uint16_t>();
+    ExpectRoundTrip<std::int32_t>();
+    ExpectRoundTrip<std::uint32_t>();
+    ExpectRoundTrip<std::int64_t>();
+    ExpectRoundTrip<std::uint64_t>();
+}
+
+} // namespace
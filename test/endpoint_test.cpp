@@ -0,0 +1,85 @@
+#include <cstddef>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "endpoint.h"
+
+namespace {
+
+// Names only intern where it's spelled out
+static_assert(!std::is_convertible_v<const char*, Endpoint>);
+static_assert(!std::is_convertible_v<std::string_view, Endpoint>);
+static_assert(!std::is_convertible_v<std::string, Endpoint>);
+
+TEST(EndpointTest, InterningIsStable)
+{
+    const Endpoint first { "endpoint_test/stable" };
+    const Endpoint again { std::string { "endpoint_test/stable" } };
+    const Endpoint other { "endpoint_test/other" };
+
+    EXPECT_EQ(first, again);
+    EXPECT_EQ(first.GetId(), again.GetId());
+    EXPECT_NE(first, other);
+    EXPECT_FALSE(first.IsEmpty());
+
+    // Same id from every thread, whichever interned it first
+    constexpr std::size_t kThreads { 8 };
+
+    std::vector<Endpoint> endpoints(kThreads);
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < kThreads; ++i)
+        threads.emplace_back([&endpoints, i] { endpoints[i] = Endpoint { "endpoint_test/threads" }; });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto endpoint : endpoints)
+        EXPECT_EQ(endpoint, endpoints.front());
+}
+
+TEST(EndpointTest, NameRoundTrip)
+{
+    const Endpoint endpoint { "endpoint_test/round_trip" };
+
+    EXPECT_EQ(endpoint.GetName(), "endpoint_test/round_trip");
+    EXPECT_EQ(Endpoint::FromId(endpoint.GetId()), endpoint);
+    EXPECT_EQ(Endpoint::Find(endpoint.GetId()), endpoint);
+    EXPECT_EQ(Endpoint::Find(endpoint.GetName()), endpoint);
+
+    std::ostringstream os;
+    os << endpoint;
+
+    EXPECT_EQ(os.str(), "endpoint_test/round_trip");
+
+    // The empty name is id 0, the default
+    EXPECT_TRUE(Endpoint {}.IsEmpty());
+    EXPECT_EQ(Endpoint { "" }, Endpoint {});
+    EXPECT_EQ(Endpoint {}.GetName(), "");
+}
+
+// Find neither interns nor invents ids
+TEST(EndpointTest, FindUnknown)
+{
+    const std::string name { "endpoint_test/unknown" };
+
+    EXPECT_FALSE(Endpoint::Find(name));
+    EXPECT_FALSE(Endpoint::Find(name));
+
+    const Endpoint newest { "endpoint_test/newest" };
+
+    EXPECT_FALSE(Endpoint::Find(newest.GetId() + 1000000));
+    EXPECT_FALSE(Endpoint::Find(name));
+
+    const Endpoint interned { name };
+
+    EXPECT_EQ(Endpoint::Find(name), interned);
+}
+
+} // namespace
@@ -0,0 +1,181 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "frame.h"
+
+namespace {
+
+Message MakeMessage()
+{
+    Message message { 42, std::uint8_t { 1 }, std::int32_t { -70000 }, 2.5, std::string { "abc" }, std::vector<int> { 1, 2, 3 } };
+    message.from = Endpoint { "frame_test/from" };
+    message.to = Endpoint { "frame_test/to" };
+
+    return message;
+}
+
+void ExpectSameMessage(const Message& lhs, const Message& rhs)
+{
+    EXPECT_EQ(lhs.id, rhs.id);
+    EXPECT_EQ(lhs.from, rhs.from);
+    EXPECT_EQ(lhs.to, rhs.to);
+    EXPECT_EQ(lhs.body, rhs.body);
+}
+
+// Accepts every flag, as for frames from this process
+FrameDecoder MakeDecoder()
+{
+    return FrameDecoder { Frame::kDefaultMaxSize, std::pmr::get_default_resource(), Frame::kAllFlags };
+}
+
+class FrameTest : public testing::TestWithParam<std::uint8_t> { };
+
+TEST_P(FrameTest, RoundTrip)
+{
+    const auto message = MakeMessage();
+    const auto buffer = Frame::Serialize(message, GetParam());
+
+    EXPECT_EQ(std::size(buffer), Frame::SerializedSize(message, GetParam()));
+
+    const auto result = Frame::Deserialize(buffer, std::pmr::get_default_resource(), Frame::kAllFlags);
+
+    ASSERT_TRUE(result);
+    ExpectSameMessage(*result, message);
+}
+
+// Two frames back to back, fed in two reads split at every offset
+TEST_P(FrameTest, DecodeSplitAtEveryOffset)
+{
+    const auto message = MakeMessage();
+    auto buffer = Frame::Serialize(message, GetParam());
+    const auto frame_size = std::size(buffer);
+
+    buffer.insert(std::end(buffer), std::begin(buffer), std::end(buffer));
+
+    for (std::size_t split = 0; split <= std::size(buffer); ++split) {
+        auto decoder = MakeDecoder();
+        std::vector<Message> messages;
+        const auto push = [&messages](Message&& decoded) { messages.push_back(std::move(decoded)); };
+
+        ASSERT_TRUE(decoder.Feed(std::data(buffer), split, push)) << split;
+        EXPECT_EQ(std::size(messages), split / frame_size) << split;
+        ASSERT_TRUE(decoder.Feed(std::data(buffer) + split, std::size(buffer) - split, push)) << split;
+
+        ASSERT_EQ(std::size(messages), 2u) << split;
+        EXPECT_TRUE(decoder.IsIdle());
+
+        for (const auto& decoded : messages)
+            ExpectSameMessage(decoded, message);
+    }
+}
+
+TEST_P(FrameTest, DecodeByteByByte)
+{
+    const auto message = MakeMessage();
+    const auto buffer = Frame::Serialize(message, GetParam());
+
+    auto decoder = MakeDecoder();
+    std::vector<Message> messages;
+
+    for (const auto byte : buffer)
+        ASSERT_TRUE(decoder.Feed(&byte, 1, [&messages](Message&& decoded) { messages.push_back(std::move(decoded)); }));
+
+    ASSERT_EQ(std::size(messages), 1u);
+    ExpectSameMessage(messages.front(), message);
+}
+
+INSTANTIATE_TEST_SUITE_P(Flags, FrameTest, testing::Values(0, Frame::kChecksum, Frame::kInternedEndpoints, Frame::kAllFlags),
+    [](const testing::TestParamInfo<std::uint8_t>& info) { return std::to_string(info.param); });
+
+// Rejected before any space is reserved for it
+TEST(FrameSizeTest, MonostateCantBeFramed)
+{
+    auto message = MakeMessage();
+    message.body.emplace_back(Message::Item {});
+
+    std::vector<std::uint8_t> buffer(1024);
+
+    EXPECT_EQ(Frame::SerializedSize(message), 0u);
+    EXPECT_TRUE(Frame::Serialize(message).empty());
+    EXPECT_FALSE(Frame::SerializeTo(message, std::data(buffer), std::size(buffer)));
+}
+
+TEST(FrameDecoderTest, CorruptChecksumFails)
+{
+    auto buffer = Frame::Serialize(MakeMessage(), Frame::kChecksum);
+    buffer[Frame::kLengthSize + 1] ^= 1;
+
+    FrameDecoder decoder;
+
+    EXPECT_FALSE(decoder.Feed(std::data(buffer), std::size(buffer), [](Message&&) { }));
+    EXPECT_TRUE(decoder.HasError());
+}
+
+// Names are never interned from the wire, the frame after it still decodes
+TEST(FrameDecoderTest, UnknownEndpointIsDropped)
+{
+    const auto message = MakeMessage();
+    auto buffer = Frame::Serialize(message);
+
+    // Same length as "frame_test/to", but never interned
+    auto unknown = buffer;
+    const std::string to { "frame_test/to" };
+    const auto it = std::search(std::begin(unknown), std::end(unknown), std::begin(to), std::end(to));
+    ASSERT_NE(it, std::end(unknown));
+    *(it + 11) = '?';
+
+    EXPECT_FALSE(Endpoint::Find("frame_test/?o"));
+    EXPECT_FALSE(Frame::Deserialize(unknown));
+
+    unknown.insert(std::end(unknown), std::begin(buffer), std::end(buffer));
+
+    FrameDecoder decoder;
+    std::vector<Message> messages;
+
+    EXPECT_TRUE(decoder.Feed(std::data(unknown), std::size(unknown), [&messages](Message&& decoded) { messages.push_back(std::move(decoded)); }));
+    EXPECT_EQ(decoder.GetDropCount(), 1u);
+    ASSERT_EQ(std::size(messages), 1u);
+    ExpectSameMessage(messages.front(), message);
+    EXPECT_FALSE(Endpoint::Find("frame_test/?o"));
+}
+
+// A peer's own endpoint is rarely known here, the frame is still delivered
+TEST(FrameDecoderTest, UnknownFromIsEmpty)
+{
+    auto buffer = Frame::Serialize(MakeMessage());
+
+    const std::string from { "frame_test/from" };
+    const auto it = std::search(std::begin(buffer), std::end(buffer), std::begin(from), std::end(from));
+    ASSERT_NE(it, std::end(buffer));
+    *(it + 11) = '?';
+
+    const auto result = Frame::Deserialize(buffer);
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->from, Endpoint {});
+    EXPECT_EQ(result->to, MakeMessage().to);
+    EXPECT_EQ(result->body, MakeMessage().body);
+    EXPECT_FALSE(Endpoint::Find("frame_test/?rom"));
+}
+
+// Ids from another process would resolve to unrelated endpoints
+TEST(FrameDecoderTest, InternedEndpointsAreOptIn)
+{
+    const auto buffer = Frame::Serialize(MakeMessage(), Frame::kInternedEndpoints);
+
+    FrameDecoder decoder;
+
+    EXPECT_FALSE(decoder.Feed(std::data(buffer), std::size(buffer), [](Message&&) { }));
+    EXPECT_TRUE(decoder.HasError());
+    EXPECT_FALSE(Frame::Deserialize(buffer));
+    EXPECT_TRUE(Frame::Deserialize(buffer, std::pmr::get_default_resource(), Frame::kInternedEndpoints));
+}
+
+} // namespace
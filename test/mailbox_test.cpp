@@ -0,0 +1,119 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/mailbox.h"
+
+namespace {
+
+struct Node {
+    std::atomic<Node*> next { nullptr };
+    std::size_t producer { 0 };
+    std::size_t seq { 0 };
+};
+
+TEST(MailboxTest, PushSchedulesOnlyWhenIdle)
+{
+    Mailbox<Node> mailbox;
+    Node a, b;
+
+    EXPECT_TRUE(mailbox.IsEmpty());
+    EXPECT_TRUE(mailbox.Push(&a));
+    EXPECT_FALSE(mailbox.Push(&b));
+
+    EXPECT_EQ(mailbox.Pop(), &a);
+    EXPECT_FALSE(mailbox.Release());
+    EXPECT_EQ(mailbox.Pop(), &b);
+    EXPECT_EQ(mailbox.Pop(), nullptr);
+    EXPECT_TRUE(mailbox.Release());
+
+    // Released, the next push schedules again
+    EXPECT_TRUE(mailbox.Push(&a));
+    EXPECT_EQ(mailbox.Pop(), &a);
+    EXPECT_TRUE(mailbox.Release());
+}
+
+TEST(MailboxTest, ForEachVisitsOldestFirst)
+{
+    Mailbox<Node> mailbox;
+    std::vector<Node> nodes(4);
+
+    for (std::size_t i = 0; i < std::size(nodes); ++i) {
+        nodes[i].seq = i;
+        mailbox.Push(&nodes[i]);
+    }
+
+    // Pop through the stub once, so ForEach starts past it
+    EXPECT_EQ(mailbox.Pop(), &nodes[0]);
+
+    std::vector<std::size_t> seqs;
+    mailbox.ForEach([&seqs](Node& node) { seqs.push_back(node.seq); });
+
+    EXPECT_EQ(seqs, (std::vector<std::size_t> { 1, 2, 3 }));
+}
+
+// Consumer role is handed between threads like a router strand, each producer's order must hold
+TEST(MailboxTest, ConcurrentProducersKeepTheirOrder)
+{
+    constexpr std::size_t kProducers { 8 };
+    constexpr std::size_t kPerProducer { 20000 };
+
+    Mailbox<Node> mailbox;
+    std::vector<Node> nodes(kProducers * kPerProducer);
+    std::vector<std::size_t> last(kProducers, 0);
+    std::atomic<std::size_t> popped { 0 };
+    std::atomic<std::size_t> consumers { 0 };
+    std::atomic_bool ordered { true };
+
+    const auto consume = [&] {
+        if (consumers.fetch_add(1) != 0)
+            ordered = false;
+
+        do {
+            while (auto* node = mailbox.Pop()) {
+                if (node->seq != last[node->producer] + 1)
+                    ordered = false;
+
+                last[node->producer] = node->seq;
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            consumers.fetch_sub(1);
+
+            if (mailbox.Release())
+                return;
+
+            consumers.fetch_add(1);
+        } while (true);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p] {
+            for (std::size_t i = 0; i < kPerProducer; ++i) {
+                auto& node = nodes[p * kPerProducer + i];
+                node.producer = p;
+                node.seq = i + 1;
+
+                // This push found it idle, so this thread takes the consumer role
+                if (mailbox.Push(&node))
+                    consume();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(popped.load(), kProducers * kPerProducer);
+    EXPECT_TRUE(ordered.load());
+    EXPECT_TRUE(mailbox.IsEmpty());
+}
+
+} // namespace
@@ -0,0 +1,283 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <memory_resource>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message.h"
+#include "util/type_traits.h"
+
+namespace {
+
+// Counts allocations made through it, backed by the default resource
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t GetCount() const noexcept { return count_; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++count_;
+        return std::pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::size_t count_ { 0 };
+};
+
+// Data of the array item at index
+const void* GetArrayData(const MessageBody& body, std::size_t index)
+{
+    return body.Visit(index, [](const auto& value) -> const void* {
+        if constexpr (MessageBody::IsArray(type_traits::variant_index_v<type_traits::remove_cvref_t<decltype(value)>, MessageBody::Item>))
+            return std::data(value);
+        else
+            return nullptr;
+    });
+}
+
+// Six items, more than fit inline, with a byte array large enough to be gathered without copying
+Message MakeMessage()
+{
+    return Message { 3, std::int32_t { -5 }, std::string { "shared" }, std::vector<std::uint8_t>(4 * Message::kGatherThreshold, 0x5A),
+        std::vector<int> { 1, 2, 3 }, std::uint64_t { 1ULL << 40 }, true };
+}
+
+// Segments concatenated
+std::vector<std::uint8_t> Gather(const Message& message, Message::Encoding encoding)
+{
+    std::vector<std::uint8_t> scratch;
+    std::vector<Message::Segment> segments;
+    std::vector<std::uint8_t> bytes;
+
+    const auto size = Message::SerializeGather(message, scratch, segments, Message::kGatherThreshold, encoding);
+
+    for (const auto& segment : segments)
+        bytes.insert(std::end(bytes), segment.data, segment.data + segment.size);
+
+    EXPECT_EQ(std::size(bytes), size);
+
+    return bytes;
+}
+
+TEST(MessageBodyTest, CopyOfSharedBodyDoesNotDeepCopy)
+{
+    auto message = MakeMessage();
+    message.body.Share();
+
+    CountingResource resource;
+    const MessageBody copy { message.body, &resource };
+
+    EXPECT_TRUE(copy.IsShared());
+    EXPECT_EQ(resource.GetCount(), 0u);
+    EXPECT_EQ(copy, message.body);
+    EXPECT_EQ(GetArrayData(copy, 2), GetArrayData(message.body, 2));
+
+    // Assignment and Message copies share too
+    MessageBody assigned { &resource };
+    assigned = message.body;
+
+    const Message message_copy = message;
+
+    EXPECT_EQ(resource.GetCount(), 0u);
+    EXPECT_EQ(GetArrayData(assigned, 2), GetArrayData(message.body, 2));
+    EXPECT_EQ(GetArrayData(message_copy.body, 2), GetArrayData(message.body, 2));
+}
+
+// Changing a copy moves its items into its own resource, the shared block and other copies are untouched
+TEST(MessageBodyTest, MutationDetaches)
+{
+    auto message = MakeMessage();
+    const auto original = message.body;
+    message.body.Share();
+
+    CountingResource resource;
+    Message copy { &resource };
+    copy.body = message.body;
+
+    copy << std::int16_t { 9 };
+
+    EXPECT_FALSE(copy.body.IsShared());
+    EXPECT_GT(resource.GetCount(), 0u);
+    EXPECT_EQ(copy.body.get_allocator().resource(), &resource);
+    EXPECT_NE(GetArrayData(copy.body, 2), GetArrayData(message.body, 2));
+
+    EXPECT_TRUE(message.body.IsShared());
+    EXPECT_EQ(message.body, original);
+
+    std::int16_t value = 0;
+    copy >> value;
+
+    EXPECT_EQ(value, 9);
+    EXPECT_EQ(copy.body, original);
+
+    // Extract detaches as well
+    Message extracted = message;
+    bool flag = false;
+    extracted >> flag;
+
+    EXPECT_TRUE(flag);
+    EXPECT_FALSE(extracted.body.IsShared());
+    EXPECT_EQ(std::size(extracted.body), std::size(original) - 1);
+    EXPECT_EQ(message.body, original);
+}
+
+// Cached bytes of a shared body equal a fresh serialization of the same items, for every entry point
+TEST(MessageBodyTest, CachedSerializationMatchesFresh)
+{
+    for (const auto encoding : { Message::Encoding::kV1, Message::Encoding::kV2 }) {
+        const auto fresh_message = MakeMessage();
+        const auto fresh = Message::Serialize(fresh_message, encoding);
+
+        ASSERT_FALSE(fresh.empty());
+        EXPECT_EQ(Gather(fresh_message, encoding), fresh);
+
+        auto message = MakeMessage();
+        message.body.Share();
+
+        // Twice, the first call fills the cache and the second reads it
+        for (int i = 0; i < 2; ++i) {
+            EXPECT_EQ(Message::SerializedSize(message, encoding), std::size(fresh));
+            EXPECT_EQ(Message::Serialize(message, encoding), fresh);
+
+            std::pmr::monotonic_buffer_resource resource;
+            const auto pmr_bytes = Message::Serialize(message, &resource, encoding);
+            EXPECT_EQ(std::vector<std::uint8_t>(std::begin(pmr_bytes), std::end(pmr_bytes)), fresh);
+
+            std::vector<std::uint8_t> buffer(std::size(fresh));
+            EXPECT_EQ(Message::SerializeTo(message, std::data(buffer), std::size(buffer), encoding), std::size(fresh));
+            EXPECT_EQ(buffer, fresh);
+            EXPECT_FALSE(Message::SerializeTo(message, std::data(buffer), std::size(buffer) - 1, encoding));
+
+            EXPECT_EQ(Gather(message, encoding), fresh);
+        }
+
+        // Copies read the same cache
+        const Message copy = message;
+        EXPECT_EQ(Message::Serialize(copy, encoding), fresh);
+    }
+}
+
+// A body the encoding can't carry isn't cached, every entry point still fails
+TEST(MessageBodyTest, UnserializableSharedBodyFails)
+{
+    Message message { 1, std::int32_t { 1 }, 0.5 };
+    message.body.Share();
+
+    std::vector<std::uint8_t> buffer(64);
+    std::vector<std::uint8_t> scratch;
+    std::vector<Message::Segment> segments;
+
+    EXPECT_TRUE(Message::Serialize(message).empty());
+    EXPECT_FALSE(Message::SerializeTo(message, std::data(buffer), std::size(buffer)));
+    EXPECT_EQ(Message::SerializeGather(message, scratch, segments), 0u);
+
+    EXPECT_EQ(Message::Serialize(message, Message::Encoding::kV2), Message::Serialize(Message { 1, std::int32_t { 1 }, 0.5 }, Message::Encoding::kV2));
+}
+
+// Past kInlineCapacity items move to a block from the body's resource, values and order are kept
+TEST(MessageBodyTest, GrowsPastInlineSlots)
+{
+    constexpr std::uint32_t kCount { 100 };
+
+    CountingResource resource;
+    Message message { &resource };
+
+    for (std::uint32_t i = 0; i < MessageBody::kInlineCapacity; ++i)
+        message << i;
+
+    EXPECT_EQ(message.body.capacity(), MessageBody::kInlineCapacity);
+    EXPECT_EQ(resource.GetCount(), 0u);
+
+    for (std::uint32_t i = MessageBody::kInlineCapacity; i < kCount; ++i) {
+        if (i % 3 == 0)
+            message << std::to_string(i);
+        else if (i % 3 == 1)
+            message << static_cast<double>(i);
+        else
+            message << i;
+    }
+
+    ASSERT_EQ(std::size(message.body), kCount);
+    EXPECT_GE(message.body.capacity(), kCount);
+    EXPECT_GT(resource.GetCount(), 0u);
+
+    const MessageBody copy { message.body, &resource };
+    EXPECT_EQ(copy, message.body);
+
+    // Extracted in reverse, the inline slots last
+    for (auto i = kCount; i-- > MessageBody::kInlineCapacity;) {
+        if (i % 3 == 0) {
+            std::string value;
+            message >> value;
+            EXPECT_EQ(value, std::to_string(i));
+        } else if (i % 3 == 1) {
+            double value = 0;
+            message >> value;
+            EXPECT_EQ(value, static_cast<double>(i));
+        } else {
+            std::uint32_t value = 0;
+            message >> value;
+            EXPECT_EQ(value, i);
+        }
+    }
+
+    for (auto i = static_cast<std::uint32_t>(MessageBody::kInlineCapacity); i-- > 0;) {
+        std::uint32_t value = 0;
+        message >> value;
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_TRUE(message.body.empty());
+
+    // Capacity is kept for reuse
+    EXPECT_GE(message.body.capacity(), kCount);
+}
+
+// Extracting the wrong type throws and leaves the item in place
+TEST(MessageBodyTest, ExtractWrongTypeThrows)
+{
+    Message message { 1, std::int32_t { -3 }, std::string { "text" } };
+
+    std::int32_t number = 0;
+    std::vector<std::uint8_t> bytes;
+
+    EXPECT_THROW(message >> number, std::bad_variant_access);
+    EXPECT_THROW(message >> bytes, std::bad_variant_access);
+    EXPECT_THROW(message.body.Extract<std::pmr::vector<int>>(), std::bad_variant_access);
+    ASSERT_EQ(std::size(message.body), 2u);
+
+    std::string text;
+    message >> text;
+    EXPECT_EQ(text, "text");
+
+    // Same width, other signedness is another type
+    std::uint32_t unsigned_number = 0;
+
+    EXPECT_THROW(message >> unsigned_number, std::bad_variant_access);
+    EXPECT_THROW(message.body.Extract<std::int64_t>(), std::bad_variant_access);
+
+    message >> number;
+    EXPECT_EQ(number, -3);
+    EXPECT_TRUE(message.body.empty());
+
+    // A shared body isn't detached by a failed Extract
+    Message shared { 1, std::string { "shared" } };
+    shared.body.Share();
+
+    EXPECT_THROW(shared >> number, std::bad_variant_access);
+    EXPECT_TRUE(shared.body.IsShared());
+    EXPECT_EQ(std::size(shared.body), 1u);
+}
+
+} // namespace
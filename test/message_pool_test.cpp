@@ -0,0 +1,178 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "util/type_traits.h"
+
+namespace {
+
+// Free lists are per thread, so each test runs on a fresh one
+template <typename F>
+void RunOnNewThread(F&& f)
+{
+    std::thread { std::forward<F>(f) }.join();
+}
+
+// Resource of every array item, so a copy or move into another resource can't keep a foreign one
+bool ArraysUse(const Message& message, std::pmr::memory_resource* resource)
+{
+    bool result = true;
+
+    for (std::size_t i = 0; i < std::size(message.body); ++i) {
+        message.body.Visit(i, [&result, resource](const auto& value) {
+            if constexpr (MessageBody::IsArray(type_traits::variant_index_v<type_traits::remove_cvref_t<decltype(value)>, MessageBody::Item>))
+                result &= value.get_allocator().resource() == resource;
+        });
+    }
+
+    return result;
+}
+
+Message MakeMessage(std::pmr::memory_resource* resource)
+{
+    Message message { Message::allocator_type { resource } };
+    message.id = 5;
+    message << std::int32_t { 1 } << std::string { "two" } << std::vector<std::uint8_t> { 3, 3, 3 } << std::vector<int> { 4, 4 } << std::uint64_t { 5 };
+
+    return message;
+}
+
+TEST(MessagePoolTest, ReleasedMessageIsClearedAndKeepsCapacity)
+{
+    RunOnNewThread([] {
+        auto message = MessagePool::Acquire();
+
+        EXPECT_EQ(message.get_allocator().resource(), MessagePool::GetResource());
+
+        message = MakeMessage(MessagePool::GetResource());
+        message.from = Endpoint { "message_pool_test/from" };
+        message.to = Endpoint { "message_pool_test/to" };
+
+        const auto capacity = message.body.capacity();
+        ASSERT_GT(capacity, MessageBody::kInlineCapacity);
+
+        MessagePool::Release(std::move(message));
+
+        const auto reused = MessagePool::Acquire();
+
+        EXPECT_TRUE(reused.body.empty());
+        EXPECT_EQ(reused.body.capacity(), capacity);
+        EXPECT_EQ(reused.id, 0);
+        EXPECT_TRUE(reused.from.IsEmpty());
+        EXPECT_TRUE(reused.to.IsEmpty());
+        EXPECT_EQ(reused.get_allocator().resource(), MessagePool::GetResource());
+    });
+}
+
+// Beyond kCapacity released messages are destroyed, recycled ones are told apart by their grown capacity
+TEST(MessagePoolTest, FreeListIsCapped)
+{
+    RunOnNewThread([] {
+        constexpr std::size_t kCount { MessagePool::kCapacity + 16 };
+
+        std::vector<Message> messages;
+
+        for (std::size_t i = 0; i < kCount; ++i) {
+            messages.push_back(MessagePool::Acquire());
+            messages.back().body.reserve(2 * MessageBody::kInlineCapacity);
+        }
+
+        for (auto& message : messages)
+            MessagePool::Release(std::move(message));
+
+        messages.clear();
+
+        std::size_t recycled = 0;
+
+        for (std::size_t i = 0; i < kCount; ++i) {
+            messages.push_back(MessagePool::Acquire());
+
+            if (messages.back().body.capacity() > MessageBody::kInlineCapacity)
+                ++recycled;
+        }
+
+        EXPECT_EQ(recycled, MessagePool::kCapacity);
+    });
+}
+
+TEST(MessagePoolTest, ForeignResourceIsNotKept)
+{
+    RunOnNewThread([] {
+        std::pmr::unsynchronized_pool_resource resource;
+
+        auto message = MakeMessage(&resource);
+        message.body.reserve(2 * MessageBody::kInlineCapacity);
+
+        MessagePool::Release(std::move(message));
+
+        const auto acquired = MessagePool::Acquire();
+
+        EXPECT_EQ(acquired.get_allocator().resource(), MessagePool::GetResource());
+        EXPECT_EQ(acquired.body.capacity(), MessageBody::kInlineCapacity);
+    });
+}
+
+// Copies and moves into a message of another resource copy the items into that resource
+TEST(MessagePoolTest, CopyAndMoveAcrossResources)
+{
+    std::pmr::unsynchronized_pool_resource first;
+    std::pmr::unsynchronized_pool_resource second;
+
+    const auto original = MakeMessage(&first);
+
+    ASSERT_TRUE(ArraysUse(original, &first));
+
+    // Copy construction uses the default resource, as std::pmr containers do
+    const Message copy = original;
+
+    EXPECT_EQ(copy.body, original.body);
+    EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_TRUE(ArraysUse(copy, std::pmr::get_default_resource()));
+
+    // Assignment keeps the target's resource
+    Message assigned { Message::allocator_type { &second } };
+    assigned = original;
+
+    EXPECT_EQ(assigned.body, original.body);
+    EXPECT_EQ(assigned.id, original.id);
+    EXPECT_EQ(assigned.get_allocator().resource(), &second);
+    EXPECT_TRUE(ArraysUse(assigned, &second));
+
+    // Move assignment across resources copies and leaves the source empty
+    auto moved_from = MakeMessage(&first);
+    Message moved { Message::allocator_type { &second } };
+    moved = std::move(moved_from);
+
+    EXPECT_EQ(moved.body, original.body);
+    EXPECT_EQ(moved.get_allocator().resource(), &second);
+    EXPECT_TRUE(ArraysUse(moved, &second));
+    EXPECT_TRUE(moved_from.body.empty());
+
+    // Move construction takes the source's resource with its items
+    auto source = MakeMessage(&first);
+    const Message constructed = std::move(source);
+
+    EXPECT_EQ(constructed.body, original.body);
+    EXPECT_EQ(constructed.get_allocator().resource(), &first);
+    EXPECT_TRUE(ArraysUse(constructed, &first));
+    EXPECT_TRUE(source.body.empty());
+
+    // Same resource, move assignment takes the items over
+    auto same_source = MakeMessage(&first);
+    Message same { Message::allocator_type { &first } };
+    same = std::move(same_source);
+
+    EXPECT_EQ(same.body, original.body);
+    EXPECT_TRUE(ArraysUse(same, &first));
+    EXPECT_TRUE(same_source.body.empty());
+}
+
+} // namespace
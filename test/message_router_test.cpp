@@ -0,0 +1,699 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class MessageRouterTest : public testing::Test {
+protected:
+    static void SetUpTestSuite() { MessageRouter::SetWorkerCount(4); }
+};
+
+// Per-producer sequence numbers seen by one ordered handler
+struct Sequence {
+    std::vector<std::uint32_t> last;
+    std::atomic<std::size_t> received { 0 };
+    std::atomic<int> running { 0 };
+    std::atomic_bool ordered { true };
+    std::atomic_bool serial { true };
+};
+
+struct Ordered {
+    void Post(Message&& message)
+    {
+        if (sequence->running.fetch_add(1) != 0)
+            sequence->serial = false;
+
+        std::uint32_t seq = 0;
+        message >> seq;
+
+        if (seq != sequence->last[message.id] + 1)
+            sequence->ordered = false;
+
+        sequence->last[message.id] = seq;
+
+        sequence->running.fetch_sub(1);
+        sequence->received.fetch_add(1, std::memory_order_release);
+
+        MessagePool::Release(std::move(message));
+    }
+
+    std::shared_ptr<Sequence> sequence;
+};
+
+TEST_F(MessageRouterTest, OrderedIsSerialAndFifoPerProducer)
+{
+    constexpr std::size_t kProducers { 4 };
+    constexpr std::size_t kEndpoints { 16 };
+    constexpr std::uint32_t kPerProducer { 5000 };
+
+    auto& router = MessageRouter::GetInstance();
+    std::vector<Endpoint> endpoints;
+    std::vector<std::shared_ptr<Sequence>> sequences;
+
+    for (std::size_t i = 0; i < kEndpoints; ++i) {
+        endpoints.emplace_back("message_router_test/ordered/" + std::to_string(i));
+        sequences.push_back(std::make_shared<Sequence>());
+        sequences.back()->last.resize(kProducers);
+
+        router.Register(endpoints.back(), Ordered { sequences.back() });
+    }
+
+    std::vector<std::thread> producers;
+
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (std::uint32_t seq = 1; seq <= kPerProducer; ++seq) {
+                for (const auto& endpoint : endpoints) {
+                    auto message = MessagePool::Acquire();
+                    message.id = static_cast<std::uint16_t>(p);
+                    message.to = endpoint;
+                    message << seq;
+
+                    ASSERT_TRUE(router.Post(std::move(message)));
+                }
+            }
+        });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    for (std::size_t i = 0; i < kEndpoints; ++i) {
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+        while (sequences[i]->received.load(std::memory_order_acquire) < kProducers * kPerProducer && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+
+        router.Unregister(endpoints[i]);
+
+        EXPECT_EQ(sequences[i]->received.load(), kProducers * kPerProducer) << i;
+        EXPECT_TRUE(sequences[i]->ordered.load()) << i;
+        EXPECT_TRUE(sequences[i]->serial.load()) << i;
+    }
+}
+
+// (id, seq) of each handled message
+using Received = std::vector<std::pair<std::uint16_t, std::uint32_t>>;
+
+// Records (id, seq) of every message, the first one blocks until gate opens
+//  - Messages posted after entered is ready stay queued, the ordered strand is held by the blocked worker
+struct Gated {
+    struct State {
+        std::promise<void> entered;
+        std::atomic_bool has_entered { false };
+        std::promise<void> open;
+        std::shared_future<void> gate { open.get_future().share() };
+
+        Received received;
+        std::mutex mutex;
+    };
+
+    void Post(Message&& message)
+    {
+        if (!state->has_entered.exchange(true))
+            state->entered.set_value();
+
+        state->gate.wait();
+
+        std::uint32_t seq = 0;
+        message >> seq;
+
+        std::lock_guard lock { state->mutex };
+        state->received.emplace_back(message.id, seq);
+    }
+
+    std::shared_ptr<State> state;
+};
+
+Message MakeMessage(Endpoint to, std::uint16_t id, std::uint32_t seq)
+{
+    Message message { id, seq };
+    message.to = to;
+
+    return message;
+}
+
+// Register a Gated handler and post a message it blocks on
+std::shared_ptr<Gated::State> RegisterBlocked(Endpoint endpoint, MessageRouter::QueueOptions options)
+{
+    auto& router = MessageRouter::GetInstance();
+    auto state = std::make_shared<Gated::State>();
+
+    router.Register(endpoint, Gated { state }, MessageRouter::Delivery::kOrdered, options);
+    router.Post(MakeMessage(endpoint, 0, 0));
+    state->entered.get_future().wait();
+
+    return state;
+}
+
+// Wait until count messages are recorded under mutex
+Received WaitFor(std::mutex& mutex, const Received& received, std::size_t count)
+{
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        {
+            std::lock_guard lock { mutex };
+
+            if (std::size(received) >= count)
+                break;
+        }
+
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // Anything beyond count would show up by now
+    std::this_thread::sleep_for(10ms);
+
+    std::lock_guard lock { mutex };
+
+    return received;
+}
+
+// Open the gate and wait until count messages are handled
+Received Drain(Gated::State& state, std::size_t count)
+{
+    state.open.set_value();
+
+    return WaitFor(state.mutex, state.received, count);
+}
+
+TEST_F(MessageRouterTest, BlockWaitsForRoomAndTryPostFails)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/block" };
+    auto state = RegisterBlocked(endpoint, { 2, MessageRouter::Overflow::kBlock });
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 0, 1)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 0, 2)));
+    EXPECT_FALSE(router.TryPost(MakeMessage(endpoint, 0, 3)));
+
+    auto blocked = std::async(std::launch::async, [&router, endpoint] { return router.Post(MakeMessage(endpoint, 0, 4)); });
+
+    EXPECT_EQ(blocked.wait_for(50ms), std::future_status::timeout);
+
+    const auto received = Drain(*state, 4);
+
+    EXPECT_TRUE(blocked.get());
+    EXPECT_EQ(received, (Received { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 4 } }));
+
+    router.Unregister(endpoint);
+}
+
+TEST_F(MessageRouterTest, DropNewestRejects)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/drop_newest" };
+    auto state = RegisterBlocked(endpoint, { 2, MessageRouter::Overflow::kDropNewest });
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 0, 1)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 0, 2)));
+    EXPECT_FALSE(router.Post(MakeMessage(endpoint, 0, 3)));
+    EXPECT_FALSE(router.TryPost(MakeMessage(endpoint, 0, 4)));
+
+    EXPECT_EQ(Drain(*state, 3), (Received { { 0, 0 }, { 0, 1 }, { 0, 2 } }));
+
+    router.Unregister(endpoint);
+}
+
+// A full queue takes the newer content into the slot of the queued message with the same id
+TEST_F(MessageRouterTest, CoalesceOverflowReplacesById)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/coalesce_overflow" };
+    auto state = RegisterBlocked(endpoint, { 2, MessageRouter::Overflow::kCoalesce });
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 1)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 2, 2)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 3)));
+    EXPECT_FALSE(router.Post(MakeMessage(endpoint, 3, 4)));
+
+    EXPECT_EQ(Drain(*state, 3), (Received { { 0, 0 }, { 1, 3 }, { 2, 2 } }));
+
+    router.Unregister(endpoint);
+}
+
+TEST_F(MessageRouterTest, BatchReturnsAcceptedCount)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint drop_newest { "message_router_test/batch_drop_newest" };
+    const Endpoint block { "message_router_test/batch_block" };
+    auto drop_newest_state = RegisterBlocked(drop_newest, { 3, MessageRouter::Overflow::kDropNewest });
+    auto block_state = RegisterBlocked(block, { 2, MessageRouter::Overflow::kBlock });
+
+    // Unknown destinations count as rejected
+    std::vector<Message> batch;
+
+    for (std::uint32_t seq = 1; seq <= 5; ++seq)
+        batch.push_back(MakeMessage(drop_newest, 0, seq));
+
+    batch.push_back(MakeMessage(Endpoint { "message_router_test/batch_nobody" }, 0, 6));
+
+    EXPECT_EQ(router.PostBatch(std::data(batch), std::data(batch) + std::size(batch)), 3u);
+
+    batch.clear();
+
+    for (std::uint32_t seq = 1; seq <= 4; ++seq)
+        batch.push_back(MakeMessage(block, 0, seq));
+
+    EXPECT_EQ(router.TryPostBatch(std::data(batch), std::data(batch) + std::size(batch)), 2u);
+
+    EXPECT_EQ(Drain(*drop_newest_state, 4), (Received { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 } }));
+    EXPECT_EQ(Drain(*block_state, 3), (Received { { 0, 0 }, { 0, 1 }, { 0, 2 } }));
+
+    router.Unregister(drop_newest);
+    router.Unregister(block);
+}
+
+// A later message with a queued id takes over the earlier one's place, newest content first in line
+TEST_F(MessageRouterTest, CoalesceReplacesInPlace)
+{
+    MessageRouter::QueueOptions options;
+    options.coalesce = true;
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/coalesce" };
+    auto state = RegisterBlocked(endpoint, options);
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 1)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 2, 2)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 3)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 3, 4)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 5)));
+
+    EXPECT_EQ(Drain(*state, 4), (Received { { 0, 0 }, { 1, 5 }, { 2, 2 }, { 3, 4 } }));
+
+    router.Unregister(endpoint);
+}
+
+// Replacing doesn't take room, only distinct ids count against capacity
+TEST_F(MessageRouterTest, CoalesceCapacityCountsDistinctIds)
+{
+    MessageRouter::QueueOptions options { 2, MessageRouter::Overflow::kDropNewest };
+    options.coalesce = true;
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/coalesce_capacity" };
+    auto state = RegisterBlocked(endpoint, options);
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 1, 1)));
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 2, 2)));
+
+    for (std::uint32_t seq = 3; seq < 10; ++seq)
+        EXPECT_TRUE(router.Post(MakeMessage(endpoint, static_cast<std::uint16_t>(1 + seq % 2), seq)));
+
+    EXPECT_FALSE(router.Post(MakeMessage(endpoint, 3, 10)));
+
+    EXPECT_EQ(Drain(*state, 3), (Received { { 0, 0 }, { 1, 8 }, { 2, 9 } }));
+
+#if MESSAGE_ROUTER_METRICS
+    // Each replaced message counts as posted and dropped, the rejected one as dropped
+    const auto stats = router.GetStats();
+    const auto it = std::find_if(std::begin(stats), std::end(stats), [endpoint](const auto& stats) { return stats.endpoint == endpoint; });
+
+    ASSERT_NE(it, std::end(stats));
+    EXPECT_EQ(it->posted, 10u);
+    EXPECT_EQ(it->dropped, 8u);
+    EXPECT_EQ(it->delivered, 3u);
+#endif
+
+    router.Unregister(endpoint);
+}
+
+// Records (id, seq) of every message, Post only, so published messages arrive as copies
+struct Recorder {
+    struct State {
+        Received received;
+        std::vector<std::shared_ptr<const Message>> shared;
+        std::mutex mutex;
+    };
+
+    void Post(Message&& message)
+    {
+        std::uint32_t seq = 0;
+        message >> seq;
+
+        std::lock_guard lock { state->mutex };
+        state->received.emplace_back(message.id, seq);
+    }
+
+    std::shared_ptr<State> state;
+};
+
+// Same, also keeps the shared message it was handed
+struct SharedRecorder : Recorder {
+    void PostShared(const std::shared_ptr<const Message>& message)
+    {
+        {
+            std::lock_guard lock { state->mutex };
+            state->shared.push_back(message);
+        }
+
+        Message copy = *message;
+        Post(std::move(copy));
+    }
+};
+
+// Patterns overlapping on one subscriber deliver once, non-matching ones not at all
+TEST_F(MessageRouterTest, PublishDeliversOncePerSubscriber)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/publish_once" };
+    const Endpoint other { "message_router_test/publish_once_other" };
+    auto state = std::make_shared<Recorder::State>();
+    auto other_state = std::make_shared<Recorder::State>();
+
+    router.Register(endpoint, Recorder { state });
+    router.Register(other, Recorder { other_state });
+
+    for (const auto* pattern : { "publish_once/a/b", "publish_once/+/b", "publish_once/#", "+/a/#" })
+        router.Subscribe(pattern, endpoint);
+
+    router.Subscribe("publish_once/a/c", other);
+
+    EXPECT_EQ(router.Publish("publish_once/a/b", Message { 1, std::uint32_t { 7 } }), 1u);
+    EXPECT_EQ(router.Publish("publish_once/x", Message { 1, std::uint32_t { 8 } }), 1u);
+    EXPECT_EQ(router.Publish("nobody", Message { 1, std::uint32_t { 9 } }), 0u);
+
+    EXPECT_EQ(WaitFor(state->mutex, state->received, 2), (Received { { 1, 7 }, { 1, 8 } }));
+    EXPECT_EQ(WaitFor(other_state->mutex, other_state->received, 0), Received {});
+
+    for (const auto* pattern : { "publish_once/a/b", "publish_once/+/b", "publish_once/#", "+/a/#" })
+        router.Unsubscribe(pattern, endpoint);
+
+    router.Unsubscribe("publish_once/a/c", other);
+    router.Unregister(endpoint);
+    router.Unregister(other);
+}
+
+// A full kBlock subscriber misses the message, Publish returns without waiting for room
+TEST_F(MessageRouterTest, PublishSkipsFullSubscriber)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/publish_full" };
+    auto state = RegisterBlocked(endpoint, { 1, MessageRouter::Overflow::kBlock });
+
+    router.Subscribe("publish_full", endpoint);
+
+    EXPECT_TRUE(router.Post(MakeMessage(endpoint, 0, 1)));
+
+    auto published = std::async(std::launch::async, [&router] { return router.Publish("publish_full", Message { 1, std::uint32_t { 2 } }); });
+
+    ASSERT_EQ(published.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(published.get(), 0u);
+
+    EXPECT_EQ(Drain(*state, 2), (Received { { 0, 0 }, { 0, 1 } }));
+
+    // With room again it is delivered
+    EXPECT_EQ(router.Publish("publish_full", Message { 1, std::uint32_t { 3 } }), 1u);
+    EXPECT_EQ(WaitFor(state->mutex, state->received, 3), (Received { { 0, 0 }, { 0, 1 }, { 1, 3 } }));
+
+    router.Unsubscribe("publish_full", endpoint);
+    router.Unregister(endpoint);
+}
+
+// Published and posted messages keep their order on a strand, for handlers with and without PostShared
+TEST_F(MessageRouterTest, PublishAndPostKeepOrder)
+{
+    constexpr std::uint32_t kCount { 1000 };
+
+    auto& router = MessageRouter::GetInstance();
+    const std::vector<Endpoint> endpoints {
+        Endpoint { "message_router_test/publish_order/post" },
+        Endpoint { "message_router_test/publish_order/shared_0" },
+        Endpoint { "message_router_test/publish_order/shared_1" },
+    };
+    std::vector<std::shared_ptr<Recorder::State>> states;
+
+    for (const auto& endpoint : endpoints) {
+        states.push_back(std::make_shared<Recorder::State>());
+
+        if (std::size(states) == 1)
+            router.Register(endpoint, Recorder { states.back() });
+        else
+            router.Register(endpoint, SharedRecorder { { states.back() } });
+
+        router.Subscribe("publish_order", endpoint);
+    }
+
+    // Even sequence numbers are posted to each endpoint, odd ones published to all of them
+    Received expected;
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq) {
+        if (seq % 2 == 0) {
+            for (const auto& endpoint : endpoints)
+                ASSERT_TRUE(router.Post(MakeMessage(endpoint, 0, seq)));
+
+            expected.emplace_back(0, seq);
+        } else {
+            ASSERT_EQ(router.Publish("publish_order", Message { 1, seq }), std::size(endpoints));
+
+            expected.emplace_back(1, seq);
+        }
+    }
+
+    for (std::size_t i = 0; i < std::size(endpoints); ++i)
+        EXPECT_EQ(WaitFor(states[i]->mutex, states[i]->received, kCount), expected) << i;
+
+    // Handlers with PostShared get the one copy every subscriber shares
+    EXPECT_TRUE(states[0]->shared.empty());
+    ASSERT_EQ(std::size(states[1]->shared), kCount / 2);
+    EXPECT_EQ(states[1]->shared, states[2]->shared);
+
+    for (const auto& endpoint : endpoints) {
+        router.Unsubscribe("publish_order", endpoint);
+        router.Unregister(endpoint);
+    }
+}
+
+// A blocked handler keeps its strand, the oldest queued messages make room for newer ones
+TEST_F(MessageRouterTest, DropOldestKeepsNewest)
+{
+    struct Blocked {
+        void Post(Message&& message)
+        {
+            gate.wait();
+
+            std::uint32_t seq = 0;
+            message >> seq;
+
+            std::lock_guard lock { *mutex };
+            seqs->push_back(seq);
+        }
+
+        std::shared_future<void> gate;
+        std::shared_ptr<std::mutex> mutex;
+        std::shared_ptr<std::vector<std::uint32_t>> seqs;
+    };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/drop_oldest" };
+    std::promise<void> gate;
+    auto mutex = std::make_shared<std::mutex>();
+    auto seqs = std::make_shared<std::vector<std::uint32_t>>();
+
+    router.Register(endpoint, Blocked { gate.get_future().share(), mutex, seqs }, MessageRouter::Delivery::kOrdered, { 4, MessageRouter::Overflow::kDropOldest });
+
+    for (std::uint32_t seq = 1; seq <= 100; ++seq) {
+        Message message { 0, seq };
+        message.to = endpoint;
+
+        router.Post(std::move(message));
+    }
+
+    gate.set_value();
+
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        {
+            std::lock_guard lock { *mutex };
+
+            if (!seqs->empty() && seqs->back() == 100)
+                break;
+        }
+
+        std::this_thread::sleep_for(1ms);
+    }
+
+    router.Unregister(endpoint);
+
+    std::lock_guard lock { *mutex };
+
+    // The batch taken before the handler blocked, at most capacity, then the newest in order
+    ASSERT_FALSE(seqs->empty());
+    EXPECT_GE(seqs->back(), 97u);
+    EXPECT_LE(std::size(*seqs), 8u);
+
+    for (std::size_t i = 1; i < std::size(*seqs); ++i)
+        EXPECT_LT((*seqs)[i - 1], (*seqs)[i]);
+}
+
+// Handlers run outside read-side sections, a blocked one doesn't hold up registration of other endpoints
+TEST_F(MessageRouterTest, BlockedHandlerDoesNotStallRegister)
+{
+    struct Blocked {
+        void Post(Message&& message)
+        {
+            entered->set_value();
+            gate.wait();
+
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<std::promise<void>> entered;
+        std::shared_future<void> gate;
+    };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint blocked { "message_router_test/blocked" };
+    const Endpoint other { "message_router_test/other" };
+    auto entered = std::make_shared<std::promise<void>>();
+    std::promise<void> gate;
+
+    router.Register(blocked, Blocked { entered, gate.get_future().share() });
+
+    Message message { 0 };
+    message.to = blocked;
+
+    ASSERT_TRUE(router.Post(std::move(message)));
+    entered->get_future().wait();
+
+    struct Sink {
+        void Post(Message&& message) { MessagePool::Release(std::move(message)); }
+    };
+
+    auto registration = std::async(std::launch::async, [&router, other] {
+        router.Register(other, Sink {});
+        router.Unregister(other);
+    });
+
+    EXPECT_EQ(registration.wait_for(10s), std::future_status::ready);
+
+    gate.set_value();
+    registration.wait();
+
+    router.Unregister(blocked);
+}
+
+// Unregister returns after the handler is done, or right away when the handler unregisters its own endpoint
+TEST_F(MessageRouterTest, UnregisterWaitsForDelivery)
+{
+    struct Slow {
+        void Post(Message&& message)
+        {
+            entered->set_value();
+            std::this_thread::sleep_for(50ms);
+
+            if (self)
+                MessageRouter::GetInstance().Unregister(message.to);
+
+            done->store(true, std::memory_order_release);
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<std::promise<void>> entered;
+        std::shared_ptr<std::atomic_bool> done;
+        bool self;
+    };
+
+    auto& router = MessageRouter::GetInstance();
+
+    for (const auto self : { false, true }) {
+        const Endpoint endpoint { "message_router_test/unregister/" + std::to_string(self) };
+        auto entered = std::make_shared<std::promise<void>>();
+        auto done = std::make_shared<std::atomic_bool>(false);
+
+        router.Register(endpoint, Slow { entered, done, self });
+
+        Message message { 0 };
+        message.to = endpoint;
+
+        ASSERT_TRUE(router.Post(std::move(message)));
+        entered->get_future().wait();
+
+        if (!self) {
+            router.Unregister(endpoint);
+            EXPECT_TRUE(done->load(std::memory_order_acquire));
+            continue;
+        }
+
+        // The handler's own Unregister must not wait for itself
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+        while (!done->load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+
+        EXPECT_TRUE(done->load(std::memory_order_acquire));
+    }
+}
+
+#if MESSAGE_ROUTER_METRICS
+
+// Unordered deliveries of one endpoint spread over workers, latency is still one histogram
+TEST_F(MessageRouterTest, StatsMergeDeliveriesOfEveryWorker)
+{
+    struct Counter {
+        void Post(Message&& message)
+        {
+            delivered->fetch_add(1, std::memory_order_release);
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<std::atomic<std::size_t>> delivered;
+    };
+
+    constexpr std::size_t kCount { 10000 };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint endpoint { "message_router_test/stats" };
+    auto delivered = std::make_shared<std::atomic<std::size_t>>(0);
+
+    router.Register(endpoint, Counter { delivered }, MessageRouter::Delivery::kUnordered);
+
+    for (std::size_t i = 0; i < kCount; ++i) {
+        Message message { 0 };
+        message.to = endpoint;
+
+        ASSERT_TRUE(router.Post(std::move(message)));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (delivered->load(std::memory_order_acquire) < kCount && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+
+    router.Unregister(endpoint);
+
+    const auto stats = router.GetStats();
+    const auto it = std::find_if(std::begin(stats), std::end(stats), [endpoint](const auto& stats) { return stats.endpoint == endpoint; });
+
+    ASSERT_NE(it, std::end(stats));
+    EXPECT_EQ(it->posted, kCount);
+    EXPECT_EQ(it->delivered, kCount);
+    EXPECT_LE(it->p50, it->p99);
+    EXPECT_LE(it->p99, it->max);
+    EXPECT_GT(it->max.count(), 0);
+}
+
+#endif // MESSAGE_ROUTER_METRICS
+
+} // namespace
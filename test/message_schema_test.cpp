@@ -0,0 +1,37 @@
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message_schema.h"
+
+namespace {
+
+DEFINE_MESSAGE(Heartbeat, std::uint16_t, std::string, std::vector<int>);
+
+TEST(MessageSchemaTest, SameBytesAsMessage)
+{
+    const Heartbeat heartbeat { 1, "alive", { 1, 2, 3 } };
+    const auto buffer = heartbeat.Serialize();
+
+    EXPECT_EQ(buffer, Message::Serialize(heartbeat.ToMessage(0)));
+
+    const auto typed = Heartbeat::Deserialize(buffer);
+
+    ASSERT_TRUE(typed);
+    EXPECT_EQ(typed->Get<0>(), 1);
+    EXPECT_EQ(typed->Get<1>(), "alive");
+    EXPECT_EQ(typed->Get<2>(), (std::vector<int> { 1, 2, 3 }));
+}
+
+TEST(MessageSchemaTest, TypeMismatchIsNullopt)
+{
+    const auto buffer = Message::Serialize(Message { 0, std::uint32_t { 1 }, std::string { "alive" }, std::vector<int> {} });
+
+    EXPECT_FALSE(Heartbeat::Deserialize(buffer));
+    EXPECT_FALSE(Heartbeat::FromMessage(*Message::Deserialize(buffer)));
+}
+
+} // namespace
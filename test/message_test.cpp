@@ -0,0 +1,181 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message.h"
+#include "message_view.h"
+
+namespace {
+
+Message MakeMessage()
+{
+    return Message { 7, std::int8_t { -1 }, std::uint16_t { 300 }, std::int64_t { std::numeric_limits<std::int64_t>::min() },
+        std::string { "abc" }, std::vector<int> { 1, -2, 3 }, std::vector<std::uint8_t> { 0, 255 } };
+}
+
+TEST(MessageTest, RoundTripV1)
+{
+    const auto message = MakeMessage();
+    const auto buffer = Message::Serialize(message);
+
+    EXPECT_EQ(std::size(buffer), Message::SerializedSize(message));
+
+    const auto result = Message::Deserialize(buffer);
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->body, message.body);
+}
+
+TEST(MessageTest, RoundTripV2)
+{
+    auto message = MakeMessage();
+    message << 3.5f << -0.25 << std::uint64_t { std::numeric_limits<std::uint64_t>::max() };
+
+    const auto buffer = Message::Serialize(message, Message::Encoding::kV2);
+
+    EXPECT_EQ(std::size(buffer), Message::SerializedSize(message, Message::Encoding::kV2));
+
+    const auto result = Message::Deserialize(buffer, Message::Encoding::kV2);
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->body, message.body);
+}
+
+TEST(MessageTest, SerializeToRejectsSmallBuffer)
+{
+    const auto message = MakeMessage();
+    std::vector<std::uint8_t> buffer(Message::SerializedSize(message) - 1);
+
+    EXPECT_FALSE(Message::SerializeTo(message, std::data(buffer), std::size(buffer)));
+}
+
+// Without a type code for float in kV1, serialization fails instead of truncating
+TEST(MessageTest, FloatFailsInV1)
+{
+    const Message message { 1, std::int32_t { 1 }, 0.5f };
+    std::vector<std::uint8_t> buffer(64);
+    std::vector<std::uint8_t> scratch;
+    std::vector<Message::Segment> segments;
+
+    EXPECT_TRUE(Message::Serialize(message).empty());
+    EXPECT_FALSE(Message::SerializeTo(message, std::data(buffer), std::size(buffer)));
+    EXPECT_EQ(Message::SerializeGather(message, scratch, segments), 0u);
+    EXPECT_TRUE(segments.empty());
+
+    EXPECT_FALSE(Message::Serialize(message, Message::Encoding::kV2).empty());
+}
+
+TEST(MessageTest, DeserializeRejectsTruncated)
+{
+    const auto message = MakeMessage();
+
+    // An empty buffer is an empty body
+    {
+        const auto buffer = Message::Serialize(message, Message::Encoding::kV2);
+
+        for (std::size_t size = 1; size < std::size(buffer); ++size)
+            EXPECT_FALSE(Message::Deserialize(std::data(buffer), size, Message::Encoding::kV2)) << size;
+    }
+
+    // kV1 item count is only a hint, a cut between items decodes the items before it
+    //  - The count alone is an empty body too
+    {
+        const auto buffer = Message::Serialize(message);
+
+        for (std::size_t size = 2; size < std::size(buffer); ++size) {
+            const std::vector<std::uint8_t> truncated(std::begin(buffer), std::begin(buffer) + static_cast<std::ptrdiff_t>(size));
+            const auto result = Message::Deserialize(truncated);
+
+            EXPECT_EQ(MessageView::Parse(truncated).has_value(), result.has_value()) << size;
+
+            if (!result)
+                continue;
+
+            // Same items up to the cut, only the count differs
+            const auto reserialized = Message::Serialize(*result);
+
+            ASSERT_EQ(std::size(reserialized), size) << size;
+            EXPECT_LT(std::size(result->body), std::size(message.body)) << size;
+            EXPECT_TRUE(std::equal(std::begin(reserialized) + 1, std::end(reserialized), std::begin(buffer) + 1)) << size;
+        }
+    }
+}
+
+// Concatenated segments are the serialized message, large byte arrays and strings are referenced in place
+TEST(MessageTest, SerializeGatherMatchesSerialize)
+{
+    const std::string large_string(3000, 'x');
+    const std::vector<std::uint8_t> large_bytes(5000, 0xA5);
+
+    auto message = MakeMessage();
+    message << large_string << std::uint32_t { 9 } << large_bytes << std::vector<int>(2000, -7) << std::string { "tail" };
+
+    for (const auto encoding : { Message::Encoding::kV1, Message::Encoding::kV2 }) {
+        const auto expected = Message::Serialize(message, encoding);
+
+        ASSERT_FALSE(expected.empty());
+
+        for (const std::size_t threshold : { std::size_t { 1 }, std::size_t { 64 }, Message::kGatherThreshold, std::size_t { 1 } << 20 }) {
+            std::vector<std::uint8_t> scratch;
+            std::vector<Message::Segment> segments;
+            std::vector<std::uint8_t> gathered;
+
+            EXPECT_EQ(Message::SerializeGather(message, scratch, segments, threshold, encoding), std::size(expected));
+
+            std::size_t referenced = 0;
+
+            for (const auto& segment : segments) {
+                gathered.insert(std::end(gathered), segment.data, segment.data + segment.size);
+
+                if (segment.data < std::data(scratch) || segment.data >= std::data(scratch) + std::size(scratch))
+                    referenced += segment.size;
+            }
+
+            EXPECT_EQ(gathered, expected) << threshold;
+
+            // Only byte arrays and strings at or above threshold skip scratch, integer arrays are byteswapped into it
+            if (threshold <= Message::kGatherThreshold) {
+                EXPECT_GE(referenced, std::size(large_string) + std::size(large_bytes)) << threshold;
+            } else {
+                EXPECT_EQ(referenced, 0u) << threshold;
+                EXPECT_EQ(std::size(segments), 1u) << threshold;
+            }
+        }
+    }
+}
+
+// Type codes 0, 14 and 15 have no item type in kV1
+TEST(MessageViewTest, RejectsUnknownTypeCode)
+{
+    for (const std::uint8_t code : { 0x00, 0x0E, 0x0F, 0x1E }) {
+        const std::vector<std::uint8_t> buffer { 2, 0x01, 0x00, code, 0x00 };
+
+        EXPECT_FALSE(MessageView::Parse(buffer)) << int { code };
+        EXPECT_FALSE(Message::Deserialize(buffer)) << int { code };
+    }
+}
+
+TEST(MessageViewTest, MatchesDeserialize)
+{
+    for (const auto encoding : { Message::Encoding::kV1, Message::Encoding::kV2 }) {
+        const auto buffer = Message::Serialize(MakeMessage(), encoding);
+        const auto view = MessageView::Parse(buffer, encoding);
+
+        ASSERT_TRUE(view);
+        ASSERT_EQ(view->size(), 6u);
+        EXPECT_EQ(view->Get<std::int8_t>(0), -1);
+        EXPECT_EQ(view->Get<std::uint16_t>(1), 300);
+        EXPECT_EQ(view->Get<std::string_view>(3), "abc");
+
+        const auto ints = view->Get<MessageView::ArrayView<int>>(4);
+        EXPECT_EQ(std::vector<int>(std::begin(ints), std::end(ints)), (std::vector<int> { 1, -2, 3 }));
+    }
+}
+
+} // namespace
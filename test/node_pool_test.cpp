@@ -0,0 +1,59 @@
+#include <cstddef>
+
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/node_pool.h"
+
+namespace {
+
+struct Node {
+    std::atomic<Node*> next { nullptr };
+};
+
+TEST(NodePoolTest, ReusesReleasedNode)
+{
+    auto* node = NodePool<Node>::Acquire();
+    NodePool<Node>::Release(node);
+
+    EXPECT_EQ(NodePool<Node>::Acquire(), node);
+
+    NodePool<Node>::Release(node);
+}
+
+// Nodes released on one thread come back to another in chains
+TEST(NodePoolTest, RecyclesAcrossThreads)
+{
+    constexpr std::size_t kCount { 4 * NodePool<Node>::kBatch };
+
+    std::vector<Node*> nodes;
+
+    for (std::size_t i = 0; i < kCount; ++i)
+        nodes.push_back(NodePool<Node>::Acquire());
+
+    const std::unordered_set<Node*> released { std::begin(nodes), std::end(nodes) };
+
+    std::thread { [&nodes] {
+        for (auto* node : nodes)
+            NodePool<Node>::Release(node);
+    } }.join();
+
+    std::size_t reused = 0;
+
+    for (auto& node : nodes) {
+        node = NodePool<Node>::Acquire();
+        reused += released.count(node);
+    }
+
+    // The exited thread handed back every node, chains taken by this thread come first
+    EXPECT_EQ(reused, kCount);
+
+    for (auto* node : nodes)
+        NodePool<Node>::Release(node);
+}
+
+} // namespace
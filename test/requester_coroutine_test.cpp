@@ -0,0 +1,165 @@
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+#include "requester.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+#ifdef REQUESTER_COROUTINE
+
+class RequesterCoroutineTest : public testing::Test {
+protected:
+    static void SetUpTestSuite() { MessageRouter::SetWorkerCount(4); }
+};
+
+struct Echo {
+    void Post(Message&& message)
+    {
+        Requester::Reply(message, Message { message.id, std::int32_t { 42 } });
+        MessagePool::Release(std::move(message));
+    }
+};
+
+struct Sink {
+    void Post(Message&& message) { MessagePool::Release(std::move(message)); }
+};
+
+AsyncTask Await(Requester& requester, Message request, std::chrono::nanoseconds timeout, std::promise<std::optional<Message>>& promise)
+{
+    promise.set_value(co_await requester.Request(std::move(request), timeout));
+}
+
+std::int32_t GetValue(Message& message)
+{
+    std::int32_t value = 0;
+    message >> value;
+
+    return value;
+}
+
+TEST_F(RequesterCoroutineTest, ReplyResumes)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint server { "requester_coroutine_test/echo" };
+    router.Register(server, Echo {});
+
+    Requester requester { Endpoint { "requester_coroutine_test/client" } };
+    std::promise<std::optional<Message>> promise;
+
+    Message request { 1, std::int32_t { 21 } };
+    request.to = server;
+
+    Await(requester, std::move(request), 10s, promise);
+
+    auto reply = promise.get_future().get();
+    ASSERT_TRUE(reply);
+    EXPECT_EQ(GetValue(*reply), 42);
+
+    router.Unregister(server);
+}
+
+TEST_F(RequesterCoroutineTest, TimeoutResumesWithNullopt)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint server { "requester_coroutine_test/sink" };
+    router.Register(server, Sink {});
+
+    Requester requester { Endpoint { "requester_coroutine_test/client" } };
+    std::promise<std::optional<Message>> promise;
+
+    Message request { 1 };
+    request.to = server;
+
+    Await(requester, std::move(request), 1ms, promise);
+
+    EXPECT_FALSE(promise.get_future().get());
+
+    router.Unregister(server);
+}
+
+// Not suspended at all, the caller resumes right away
+TEST_F(RequesterCoroutineTest, UnroutableResumesOnCaller)
+{
+    Requester requester { Endpoint { "requester_coroutine_test/client" } };
+    std::promise<std::optional<Message>> promise;
+    auto future = promise.get_future();
+
+    Message request { 1 };
+    request.to = Endpoint { "requester_coroutine_test/nobody" };
+
+    Await(requester, std::move(request), 10s, promise);
+
+    ASSERT_EQ(future.wait_for(0s), std::future_status::ready);
+    EXPECT_FALSE(future.get());
+}
+
+// A handler awaits a request of its own per message, many of them suspended at once
+TEST_F(RequesterCoroutineTest, HandlerCoroutinesInterleave)
+{
+    constexpr std::int32_t kCount { 100 };
+
+    struct Relay {
+        void Post(Message&& message) { Handle(std::move(message)); }
+
+        AsyncTask Handle(Message message)
+        {
+            Message request { 1, std::int32_t { 0 } };
+            request.to = Endpoint { "requester_coroutine_test/relay_echo" };
+
+            auto reply = co_await requester->Request(std::move(request), 10s);
+
+            if (reply && GetValue(*reply) == 42 && sum->fetch_add(1) + 1 == kCount)
+                done->set_value();
+
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<Requester> requester;
+        std::shared_ptr<std::atomic<std::int32_t>> sum;
+        std::shared_ptr<std::promise<void>> done;
+    };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint echo { "requester_coroutine_test/relay_echo" };
+    const Endpoint relay { "requester_coroutine_test/relay" };
+    auto requester = std::make_shared<Requester>(Endpoint { "requester_coroutine_test/relay_client" });
+    auto sum = std::make_shared<std::atomic<std::int32_t>>(0);
+    auto done = std::make_shared<std::promise<void>>();
+
+    router.Register(echo, Echo {});
+    router.Register(relay, Relay { requester, sum, done });
+
+    for (std::int32_t i = 0; i < kCount; ++i) {
+        Message message { 0 };
+        message.to = relay;
+
+        ASSERT_TRUE(router.Post(std::move(message)));
+    }
+
+    EXPECT_EQ(done->get_future().wait_for(10s), std::future_status::ready);
+
+    router.Unregister(relay);
+    router.Unregister(echo);
+}
+
+#else
+
+TEST(RequesterCoroutineTest, NeedsCxx20)
+{
+    GTEST_SKIP() << "Configure with -DMESSAGE_CXX_STANDARD=20 to build Requester's coroutine API";
+}
+
+#endif // REQUESTER_COROUTINE
+
+} // namespace
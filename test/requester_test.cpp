@@ -0,0 +1,150 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+#include "requester.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class RequesterTest : public testing::Test {
+protected:
+    // A handler blocked in a test must leave other workers to deliver timeouts
+    static void SetUpTestSuite() { MessageRouter::SetWorkerCount(4); }
+};
+
+struct Echo {
+    void Post(Message&& message)
+    {
+        Requester::Reply(message, Message { message.id, std::int32_t { 42 } });
+        MessagePool::Release(std::move(message));
+    }
+};
+
+struct Sink {
+    void Post(Message&& message) { MessagePool::Release(std::move(message)); }
+};
+
+TEST_F(RequesterTest, ReplyIsMatched)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint server { "requester_test/echo" };
+    router.Register(server, Echo {});
+
+    Requester requester { Endpoint { "requester_test/client" } };
+    std::promise<std::optional<Message>> promise;
+
+    Message request { 1, std::int32_t { 21 } };
+    request.to = server;
+
+    ASSERT_TRUE(requester.Request(std::move(request), 10s, [&promise](std::optional<Message> reply) { promise.set_value(std::move(reply)); }));
+
+    auto reply = promise.get_future().get();
+    ASSERT_TRUE(reply);
+
+    std::int32_t value = 0;
+    *reply >> value;
+    EXPECT_EQ(value, 42);
+
+    router.Unregister(server);
+}
+
+TEST_F(RequesterTest, TimeoutCallsBackWithNullopt)
+{
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint server { "requester_test/sink" };
+    router.Register(server, Sink {});
+
+    Requester requester { Endpoint { "requester_test/client" } };
+    std::promise<std::optional<Message>> promise;
+
+    Message request { 1 };
+    request.to = server;
+
+    ASSERT_TRUE(requester.Request(std::move(request), 1ms, [&promise](std::optional<Message> reply) { promise.set_value(std::move(reply)); }));
+    EXPECT_FALSE(promise.get_future().get());
+
+    router.Unregister(server);
+}
+
+TEST_F(RequesterTest, UnroutableFailsWithoutCallback)
+{
+    Requester requester { Endpoint { "requester_test/client" } };
+    bool called = false;
+
+    Message request { 1 };
+    request.to = Endpoint { "requester_test/nobody" };
+
+    EXPECT_FALSE(requester.Request(std::move(request), 10s, [&called](std::optional<Message>) { called = true; }));
+    EXPECT_FALSE(called);
+}
+
+// Post blocks on a full kBlock route past the timeout, then fails as the route is unregistered
+//  - Request must report the callback it already made, not a failure
+TEST_F(RequesterTest, BlockedPostOutlastingTimeout)
+{
+    struct Blocked {
+        void Post(Message&& message)
+        {
+            gate.wait();
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_future<void> gate;
+    };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint server { "requester_test/blocked" };
+    std::promise<void> gate;
+
+    Requester requester { Endpoint { "requester_test/client" } };
+    std::atomic<int> calls { 0 };
+    std::promise<void> timed_out;
+
+    router.Register(server, Blocked { gate.get_future().share() }, MessageRouter::Delivery::kOrdered, { 1, MessageRouter::Overflow::kBlock });
+
+    for (std::size_t i = 0; i < 16; ++i) {
+        Message filler { 0 };
+        filler.to = server;
+
+        if (!router.TryPost(std::move(filler)))
+            break;
+    }
+
+    auto request = std::async(std::launch::async, [&] {
+        Message message { 1 };
+        message.to = server;
+
+        return requester.Request(std::move(message), 1ms, [&](std::optional<Message> reply) {
+            EXPECT_FALSE(reply);
+
+            if (calls.fetch_add(1) == 0)
+                timed_out.set_value();
+        });
+    });
+
+    ASSERT_EQ(timed_out.get_future().wait_for(10s), std::future_status::ready);
+
+    auto unregister = std::async(std::launch::async, [&] { router.Unregister(server); });
+
+    // Let Unregister deactivate the route before the handler makes room
+    std::this_thread::sleep_for(100ms);
+    gate.set_value();
+
+    unregister.get();
+
+    EXPECT_TRUE(request.get());
+    EXPECT_EQ(calls.load(), 1);
+}
+
+} // namespace
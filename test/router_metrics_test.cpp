@@ -0,0 +1,152 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "router_metrics.h"
+
+#if MESSAGE_ROUTER_METRICS
+
+namespace {
+
+using namespace std::chrono_literals;
+
+const RouterMetrics::Stats* FindStats(const std::vector<RouterMetrics::Stats>& stats, Endpoint endpoint)
+{
+    const auto it = std::find_if(std::begin(stats), std::end(stats), [endpoint](const auto& stats) { return stats.endpoint == endpoint; });
+
+    return it != std::end(stats) ? &*it : nullptr;
+}
+
+// Short-lived producers leave their counts behind, not their shards
+TEST(RouterMetricsTest, ExitedThreadsAreRetired)
+{
+    constexpr std::size_t kThreads { 64 };
+
+    RouterMetrics metrics;
+    const Endpoint endpoint { "router_metrics_test/retired" };
+
+    for (std::size_t i = 0; i < kThreads; ++i) {
+        std::thread { [&metrics, endpoint, i] {
+            auto recorder = metrics.Record();
+            recorder.Posted(endpoint.GetId(), 2);
+            recorder.Dropped(endpoint.GetId());
+            recorder.Queued(endpoint.GetId(), i);
+            recorder.Delivered(endpoint.GetId(), 1us);
+        } }.join();
+    }
+
+    EXPECT_EQ(metrics.GetShardCount(), 0u);
+
+    const auto stats = metrics.GetStats();
+    const auto* result = FindStats(stats, endpoint);
+
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->posted, 2 * kThreads);
+    EXPECT_EQ(result->dropped, kThreads);
+    EXPECT_EQ(result->delivered, kThreads);
+    EXPECT_EQ(result->max_queue_depth, kThreads - 1);
+    EXPECT_EQ(result->max, std::chrono::nanoseconds { 1us });
+
+    metrics.ResetStats();
+
+    EXPECT_TRUE(metrics.GetStats().empty());
+}
+
+// Each thread keeps one shard per instance, however it alternates between them
+TEST(RouterMetricsTest, OneShardPerInstanceAndThread)
+{
+    RouterMetrics first;
+    RouterMetrics second;
+    const Endpoint endpoint { "router_metrics_test/instances" };
+
+    for (int i = 0; i < 1000; ++i) {
+        first.Record().Posted(endpoint.GetId());
+        second.Record().Posted(endpoint.GetId(), 2);
+    }
+
+    EXPECT_EQ(first.GetShardCount(), 1u);
+    EXPECT_EQ(second.GetShardCount(), 1u);
+
+    const auto first_stats = first.GetStats();
+    const auto second_stats = second.GetStats();
+
+    ASSERT_NE(FindStats(first_stats, endpoint), nullptr);
+    ASSERT_NE(FindStats(second_stats, endpoint), nullptr);
+    EXPECT_EQ(FindStats(first_stats, endpoint)->posted, 1000u);
+    EXPECT_EQ(FindStats(second_stats, endpoint)->posted, 2000u);
+
+    // A thread outliving an instance forgets it
+    {
+        RouterMetrics scoped;
+        scoped.Record().Posted(endpoint.GetId());
+    }
+
+    RouterMetrics later;
+    later.Record().Posted(endpoint.GetId());
+
+    const auto later_stats = later.GetStats();
+
+    EXPECT_EQ(later.GetShardCount(), 1u);
+    ASSERT_NE(FindStats(later_stats, endpoint), nullptr);
+    EXPECT_EQ(FindStats(later_stats, endpoint)->posted, 1u);
+}
+
+// Reads while threads record and exit, nothing is lost or counted twice
+TEST(RouterMetricsTest, ConcurrentRecordAndRead)
+{
+    constexpr std::size_t kThreads { 4 };
+    constexpr std::size_t kPerThread { 100000 };
+
+    RouterMetrics metrics;
+    const Endpoint low { "router_metrics_test/low" };
+
+    // Ids in another chunk than low's
+    Endpoint high;
+    for (int i = 0; high.GetId() < low.GetId() + 2 * 64; ++i)
+        high = Endpoint { "router_metrics_test/high_" + std::to_string(i) };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&metrics, low, high] {
+            for (std::size_t i = 0; i < kPerThread; ++i) {
+                auto recorder = metrics.Record();
+                recorder.Posted(low.GetId());
+                recorder.Posted(high.GetId());
+            }
+        });
+    }
+
+    std::uint64_t last = 0;
+
+    for (int i = 0; i < 100; ++i) {
+        const auto stats = metrics.GetStats();
+
+        if (const auto* result = FindStats(stats, low)) {
+            EXPECT_GE(result->posted, last);
+            last = result->posted;
+        }
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    const auto stats = metrics.GetStats();
+
+    ASSERT_NE(FindStats(stats, low), nullptr);
+    ASSERT_NE(FindStats(stats, high), nullptr);
+    EXPECT_EQ(FindStats(stats, low)->posted, kThreads * kPerThread);
+    EXPECT_EQ(FindStats(stats, high)->posted, kThreads * kPerThread);
+    EXPECT_EQ(metrics.GetShardCount(), 0u);
+}
+
+} // namespace
+
+#endif // MESSAGE_ROUTER_METRICS
@@ -0,0 +1,287 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+#include "shm_ring.h"
+#include "shm_transport.h"
+
+namespace {
+
+// Ring is unlinked after each test, its name carries the pid so parallel runs don't collide
+class ShmRingTest : public testing::Test {
+protected:
+    void TearDown() override { ShmRing::Unlink(name_); }
+
+    ShmRing Create(std::size_t capacity)
+    {
+        ShmRing::Unlink(name_);
+
+        auto ring = ShmRing::Create(name_, capacity);
+        EXPECT_TRUE(ring);
+
+        return std::move(*ring);
+    }
+
+    // Run f() in a child process, returns its pid
+    //  - The child only maps the ring by name, as an unrelated process would, and exits with f()'s result
+    template <typename F>
+    pid_t Fork(F&& f)
+    {
+        const auto pid = ::fork();
+
+        if (pid == 0) {
+            auto ring = ShmRing::Open(name_);
+            ::_exit(ring ? f(*ring) : 2);
+        }
+
+        EXPECT_GT(pid, 0);
+
+        return pid;
+    }
+
+    static void ExpectExitedCleanly(pid_t pid)
+    {
+        int status = 0;
+
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+
+    const std::string name_ { "/message_test_shm_ring_" + std::to_string(::getpid()) };
+};
+
+using namespace std::chrono_literals;
+
+// Record of producer p with sequence seq, 8 to 263 bytes so records wrap at many offsets
+std::size_t RecordSize(std::uint32_t producer, std::uint32_t seq)
+{
+    return 8 + (producer * 31 + seq * 97) % 256;
+}
+
+void FillRecord(std::uint8_t* data, std::size_t size, std::uint32_t producer, std::uint32_t seq)
+{
+    std::memcpy(data, &producer, sizeof(producer));
+    std::memcpy(data + 4, &seq, sizeof(seq));
+
+    for (std::size_t i = 8; i < size; ++i)
+        data[i] = static_cast<std::uint8_t>(seq + i);
+}
+
+std::size_t ReadAll(ShmRing& ring, std::vector<std::vector<std::uint8_t>>& records)
+{
+    return ring.Read([&records](const std::uint8_t* data, std::size_t size) { records.emplace_back(data, data + size); });
+}
+
+// A payload word equal to a future position + 1 must not pass for that record's header
+TEST_F(ShmRingTest, StalePayloadIsNotARecord)
+{
+    auto ring = Create(ShmRing::kMinCapacity);
+    const auto capacity = ring.GetCapacity();
+    std::vector<std::vector<std::uint8_t>> records;
+
+    // At ring offset 0, each 16-byte aligned payload word holds its position on the next lap + 1, then a zero size
+    ASSERT_TRUE(ring.TryWrite(1024, [capacity](std::uint8_t* data) {
+        for (std::size_t i = 0; i < 1024; i += 16) {
+            const std::uint64_t tag = 16 + i + capacity + 1;
+            const std::uint64_t zero = 0;
+
+            std::memcpy(data + i, &tag, sizeof(tag));
+            std::memcpy(data + i + 8, &zero, sizeof(zero));
+        }
+    }));
+
+    // Two more records leave less than the next one needs before the end, so it wraps behind a padding record
+    for (const std::size_t size : { 2000, 1000 }) {
+        ASSERT_TRUE(ring.TryWrite(size, [size](std::uint8_t* data) { std::memset(data, 0xAB, size); }));
+    }
+
+    EXPECT_EQ(ReadAll(ring, records), 3u);
+
+    ASSERT_TRUE(ring.TryWrite(8, [](std::uint8_t* data) { std::memset(data, 0xCD, 8); }));
+
+    // Tail now sits on what used to be the first record's payload
+    records.clear();
+
+    EXPECT_EQ(ReadAll(ring, records), 1u);
+    EXPECT_EQ(ReadAll(ring, records), 0u);
+    ASSERT_EQ(std::size(records), 1u);
+    EXPECT_EQ(records.front(), std::vector<std::uint8_t>(8, 0xCD));
+}
+
+// Producers in other processes, a ring much smaller than the traffic so records wrap behind padding many times
+TEST_F(ShmRingTest, ForkedProducersKeepTheirOrder)
+{
+    constexpr std::uint32_t kProducers { 3 };
+    constexpr std::uint32_t kPerProducer { 20000 };
+
+    auto ring = Create(ShmRing::kMinCapacity);
+    std::vector<pid_t> pids;
+
+    for (std::uint32_t p = 0; p < kProducers; ++p) {
+        pids.push_back(Fork([p](ShmRing& ring) {
+            for (std::uint32_t seq = 0; seq < kPerProducer; ++seq) {
+                const auto size = RecordSize(p, seq);
+
+                if (!ring.Write(size, [p, seq, size](std::uint8_t* data) { FillRecord(data, size, p, seq); }))
+                    return 1;
+            }
+
+            return 0;
+        }));
+    }
+
+    std::vector<std::uint32_t> next(kProducers, 0);
+    std::uint64_t received = 0;
+    bool valid = true;
+    const auto deadline = std::chrono::steady_clock::now() + 30s;
+
+    while (received < kProducers * kPerProducer && std::chrono::steady_clock::now() < deadline) {
+        const auto count = ring.Read([&next, &valid](const std::uint8_t* data, std::size_t size) {
+            std::uint32_t producer = 0;
+            std::uint32_t seq = 0;
+
+            if (size >= 8) {
+                std::memcpy(&producer, data, sizeof(producer));
+                std::memcpy(&seq, data + 4, sizeof(seq));
+            }
+
+            if (size < 8 || producer >= kProducers || seq != next[producer] || size != RecordSize(producer, seq)) {
+                valid = false;
+                return;
+            }
+
+            for (std::size_t i = 8; i < size; ++i)
+                valid &= data[i] == static_cast<std::uint8_t>(seq + i);
+
+            ++next[producer];
+        });
+
+        received += count;
+
+        if (count == 0)
+            ring.Wait(10ms);
+    }
+
+    for (const auto pid : pids)
+        ExpectExitedCleanly(pid);
+
+    EXPECT_TRUE(valid);
+    EXPECT_EQ(received, std::uint64_t { kProducers } * kPerProducer);
+    EXPECT_EQ(ring.Read([](const std::uint8_t*, std::size_t) { }), 0u);
+}
+
+// Consumer sleeps on an empty ring, a write from another process wakes it long before the timeout
+TEST_F(ShmRingTest, WriteWakesWaitingConsumer)
+{
+    auto ring = Create(ShmRing::kMinCapacity);
+
+    const auto pid = Fork([](ShmRing& ring) {
+        std::this_thread::sleep_for(100ms);
+
+        return ring.TryWrite(4, [](std::uint8_t* data) { std::memset(data, 7, 4); }) ? 0 : 1;
+    });
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::vector<std::uint8_t>> records;
+
+    while (ReadAll(ring, records) == 0 && std::chrono::steady_clock::now() - begin < 10s)
+        ring.Wait(10s);
+
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 5s);
+    ASSERT_EQ(std::size(records), 1u);
+    EXPECT_EQ(records.front(), std::vector<std::uint8_t>(4, 7));
+
+    ExpectExitedCleanly(pid);
+
+    // Wake() returns an idle Wait early too
+    std::thread waker { [&ring] {
+        std::this_thread::sleep_for(100ms);
+        ring.Wake();
+    } };
+
+    const auto wait_begin = std::chrono::steady_clock::now();
+    ring.Wait(10s);
+
+    EXPECT_LT(std::chrono::steady_clock::now() - wait_begin, 5s);
+    waker.join();
+}
+
+// ShmSender in another process, ShmReceiver posting to a handler here
+//  - The sender's own endpoint is never interned in this process, messages still arrive
+TEST_F(ShmRingTest, SenderToReceiver)
+{
+    constexpr std::uint32_t kCount { 5000 };
+
+    struct Sink {
+        void Post(Message&& message)
+        {
+            std::uint32_t seq = 0;
+            message >> seq;
+
+            if (seq != next->load(std::memory_order_relaxed) || !message.from.IsEmpty())
+                valid->store(false);
+
+            next->fetch_add(1, std::memory_order_release);
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<std::atomic<std::uint32_t>> next;
+        std::shared_ptr<std::atomic_bool> valid;
+    };
+
+    auto ring = std::make_shared<ShmRing>(Create(ShmRing::kMinCapacity));
+    const Endpoint sink { "shm_ring_test/sink" };
+    auto next = std::make_shared<std::atomic<std::uint32_t>>(0);
+    auto valid = std::make_shared<std::atomic_bool>(true);
+
+    auto& router = MessageRouter::GetInstance();
+    router.Register(sink, Sink { next, valid });
+
+    ShmReceiver receiver { ring };
+
+    const auto pid = Fork([](ShmRing& ring) {
+        ShmSender sender { std::make_shared<ShmRing>(std::move(ring)) };
+        const Endpoint from { "shm_ring_test/child_" + std::to_string(::getpid()) };
+
+        for (std::uint32_t seq = 0; seq < kCount; ++seq) {
+            Message message { 1, seq };
+            message.from = from;
+            message.to = Endpoint { "shm_ring_test/sink" };
+
+            sender.Post(std::move(message));
+        }
+
+        return sender.GetDropCount() == 0 ? 0 : 1;
+    });
+
+    ExpectExitedCleanly(pid);
+
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (next->load(std::memory_order_acquire) < kCount && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+
+    router.Unregister(sink);
+
+    EXPECT_EQ(next->load(), kCount);
+    EXPECT_TRUE(valid->load());
+    EXPECT_EQ(receiver.GetErrorCount(), 0u);
+}
+
+} // namespace
@@ -0,0 +1,428 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "frame.h"
+#include "message_pool.h"
+#include "message_router.h"
+#include "socket_bridge.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+enum class Transport {
+    kUnix,
+    kTcp,
+};
+
+// Received messages, optionally held back so the bridge thread stops reading
+struct Collector {
+    struct State {
+        std::vector<Message> messages;
+        std::mutex mutex;
+        std::shared_future<void> gate;
+    };
+
+    void Post(Message&& message) { PostBatch(&message, &message + 1); }
+
+    void PostBatch(Message* first, Message* last)
+    {
+        if (state->gate.valid())
+            state->gate.wait();
+
+        std::lock_guard lock { state->mutex };
+
+        for (; first != last; ++first)
+            state->messages.push_back(std::move(*first));
+    }
+
+    std::shared_ptr<State> state;
+};
+
+bool WaitFor(std::chrono::milliseconds timeout, const std::function<bool()>& done)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+
+        std::this_thread::sleep_for(1ms);
+    }
+
+    return true;
+}
+
+class SocketBridgeTest : public testing::TestWithParam<Transport> {
+protected:
+    // A handler blocked in a test must leave other workers to deliver
+    static void SetUpTestSuite() { MessageRouter::SetWorkerCount(4); }
+
+    void TearDown() override
+    {
+        if (!path_.empty())
+            ::unlink(path_.c_str());
+    }
+
+    // Server listens on a fresh address, on_accept keeps the last accepted sender
+    bool Listen(SocketBridge& server)
+    {
+        auto on_accept = [this](SocketSender sender) {
+            std::lock_guard lock { accepted_mutex_ };
+            accepted_.emplace(std::move(sender));
+        };
+
+        if (GetParam() == Transport::kTcp) {
+            port_ = server.ListenTcp("127.0.0.1", 0, on_accept);
+            return port_.has_value();
+        }
+
+        path_ = "/tmp/socket_bridge_test_" + std::to_string(::getpid());
+        ::unlink(path_.c_str());
+
+        return server.ListenUnix(path_, on_accept);
+    }
+
+    std::optional<SocketSender> Connect(SocketBridge& client)
+    {
+        return GetParam() == Transport::kTcp ? client.ConnectTcp("127.0.0.1", *port_) : client.ConnectUnix(path_);
+    }
+
+    // Blocking socket connected to the listener, bypassing SocketBridge on the client side
+    int ConnectRaw()
+    {
+        int fd = -1;
+
+        if (GetParam() == Transport::kTcp) {
+            sockaddr_in address { };
+            address.sin_family = AF_INET;
+            address.sin_port = htons(*port_);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        } else {
+            sockaddr_un address { };
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path_.c_str(), std::size(path_) + 1);
+
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+
+        return fd;
+    }
+
+    bool HasAccepted()
+    {
+        std::lock_guard lock { accepted_mutex_ };
+        return accepted_.has_value();
+    }
+
+    std::optional<SocketSender> accepted_;
+    std::mutex accepted_mutex_;
+
+private:
+    std::optional<std::uint16_t> port_;
+    std::string path_;
+};
+
+Message MakeMessage(std::uint32_t seq, std::size_t payload = 0)
+{
+    Message message { 1, seq, std::vector<std::uint8_t>(payload, static_cast<std::uint8_t>(seq)) };
+    message.to = Endpoint { "socket_bridge_test/sink" };
+
+    return message;
+}
+
+std::uint32_t GetSeq(const Message& message)
+{
+    auto copy = message;
+    copy.body.Extract<std::pmr::vector<std::uint8_t>>();
+
+    return copy.body.Extract<std::uint32_t>();
+}
+
+TEST_P(SocketBridgeTest, MessagesArriveInOrder)
+{
+    constexpr std::uint32_t kCount { 10000 };
+
+    auto state = std::make_shared<Collector::State>();
+    SocketBridge server { Collector { state } };
+    SocketBridge client { Collector { std::make_shared<Collector::State>() } };
+
+    ASSERT_TRUE(Listen(server));
+
+    auto sender = Connect(client);
+    ASSERT_TRUE(sender);
+
+    // Single posts and batches interleaved
+    for (std::uint32_t seq = 0; seq < kCount;) {
+        if (seq % 3 == 0) {
+            sender->Post(MakeMessage(seq++, 16));
+        } else {
+            std::vector<Message> batch;
+
+            for (std::size_t i = 0; i < 8 && seq < kCount; ++i)
+                batch.push_back(MakeMessage(seq++, 16));
+
+            sender->PostBatch(std::data(batch), std::data(batch) + std::size(batch));
+        }
+    }
+
+    ASSERT_TRUE(WaitFor(10s, [&state] {
+        std::lock_guard lock { state->mutex };
+        return std::size(state->messages) >= kCount;
+    }));
+
+    std::lock_guard lock { state->mutex };
+
+    ASSERT_EQ(std::size(state->messages), kCount);
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq) {
+        ASSERT_EQ(GetSeq(state->messages[seq]), seq);
+        EXPECT_EQ(state->messages[seq].to, Endpoint { "socket_bridge_test/sink" });
+    }
+
+    EXPECT_EQ(sender->GetDropCount(), 0u);
+}
+
+// The peer writes frames in pieces, every split point lands in a different read
+TEST_P(SocketBridgeTest, FrameSplitAcrossReads)
+{
+    auto state = std::make_shared<Collector::State>();
+    SocketBridge server { Collector { state } };
+
+    ASSERT_TRUE(Listen(server));
+
+    const auto fd = ConnectRaw();
+    ASSERT_GE(fd, 0);
+
+    auto buffer = Frame::Serialize(MakeMessage(7, 100), Frame::kChecksum);
+    const auto second = Frame::Serialize(MakeMessage(8, 3));
+    buffer.insert(std::end(buffer), std::begin(second), std::end(second));
+
+    for (const std::size_t step : { std::size_t { 1 }, std::size_t { 5 }, std::size_t { 64 } }) {
+        for (std::size_t offset = 0; offset < std::size(buffer); offset += step) {
+            const auto size = std::min(step, std::size(buffer) - offset);
+
+            ASSERT_EQ(::send(fd, std::data(buffer) + offset, size, MSG_NOSIGNAL), static_cast<ssize_t>(size));
+
+            // Let the bridge thread read what was sent so far
+            if (step != 1 || offset % 16 == 0)
+                std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ASSERT_TRUE(WaitFor(10s, [&state] {
+        std::lock_guard lock { state->mutex };
+        return std::size(state->messages) >= 6;
+    }));
+
+    ::close(fd);
+
+    std::lock_guard lock { state->mutex };
+
+    ASSERT_EQ(std::size(state->messages), 6u);
+
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(GetSeq(state->messages[i]), i % 2 == 0 ? 7u : 8u);
+}
+
+// The receiver stops reading, unsent frames wait for EPOLLOUT and all arrive once it resumes
+TEST_P(SocketBridgeTest, BackpressureFlushesOnWritable)
+{
+    constexpr std::uint32_t kCount { 256 };
+    constexpr std::size_t kPayload { 64 << 10 };
+
+    std::promise<void> gate;
+    auto state = std::make_shared<Collector::State>();
+    state->gate = gate.get_future().share();
+
+    SocketBridge server { Collector { state } };
+    SocketBridge client { Collector { std::make_shared<Collector::State>() } };
+
+    ASSERT_TRUE(Listen(server));
+
+    auto sender = Connect(client);
+    ASSERT_TRUE(sender);
+
+    // 16 MiB, far more than the socket buffers hold while the server is stuck in its sink
+    for (std::uint32_t seq = 0; seq < kCount; ++seq)
+        sender->Post(MakeMessage(seq, kPayload));
+
+    gate.set_value();
+
+    ASSERT_TRUE(WaitFor(30s, [&state] {
+        std::lock_guard lock { state->mutex };
+        return std::size(state->messages) >= kCount;
+    }));
+
+    std::lock_guard lock { state->mutex };
+
+    EXPECT_EQ(sender->GetDropCount(), 0u);
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq)
+        ASSERT_EQ(GetSeq(state->messages[seq]), seq);
+}
+
+// Past kMaxPendingSize unsent bytes, further messages are dropped instead of buffered
+TEST_P(SocketBridgeTest, DropsPastMaxPendingSize)
+{
+    constexpr std::size_t kPayload { 1 << 20 };
+    constexpr std::uint32_t kCount { SocketSender::kMaxPendingSize / kPayload + 32 };
+
+    std::promise<void> gate;
+    auto state = std::make_shared<Collector::State>();
+    state->gate = gate.get_future().share();
+
+    SocketBridge server { Collector { state } };
+    SocketBridge client { Collector { std::make_shared<Collector::State>() } };
+
+    ASSERT_TRUE(Listen(server));
+
+    auto sender = Connect(client);
+    ASSERT_TRUE(sender);
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq)
+        sender->Post(MakeMessage(seq, kPayload));
+
+    const auto dropped = sender->GetDropCount();
+
+    EXPECT_GT(dropped, 0u);
+    EXPECT_LT(dropped, kCount);
+
+    gate.set_value();
+
+    // What wasn't dropped arrives in order
+    ASSERT_TRUE(WaitFor(30s, [&state, &dropped] {
+        std::lock_guard lock { state->mutex };
+        return std::size(state->messages) >= kCount - dropped;
+    }));
+
+    std::lock_guard lock { state->mutex };
+
+    for (std::size_t i = 1; i < std::size(state->messages); ++i)
+        EXPECT_LT(GetSeq(state->messages[i - 1]), GetSeq(state->messages[i]));
+}
+
+// Closing one side disconnects the other, its sender then drops
+TEST_P(SocketBridgeTest, PeerCloseDisconnects)
+{
+    auto server = std::make_unique<SocketBridge>(Collector { std::make_shared<Collector::State>() });
+    SocketBridge client { Collector { std::make_shared<Collector::State>() } };
+
+    ASSERT_TRUE(Listen(*server));
+
+    auto sender = Connect(client);
+    ASSERT_TRUE(sender);
+    ASSERT_TRUE(WaitFor(10s, [this] { return HasAccepted(); }));
+
+    EXPECT_TRUE(sender->IsConnected());
+
+    server.reset();
+
+    ASSERT_TRUE(WaitFor(10s, [&sender] { return !sender->IsConnected(); }));
+
+    sender->Post(MakeMessage(1));
+
+    EXPECT_EQ(sender->GetDropCount(), 1u);
+
+    // The accepted sender outlives its bridge and drops too
+    std::lock_guard lock { accepted_mutex_ };
+
+    EXPECT_FALSE(accepted_->IsConnected());
+    accepted_->Post(MakeMessage(2));
+    EXPECT_EQ(accepted_->GetDropCount(), 1u);
+}
+
+// Posting to MessageRouter never blocks the bridge thread, a full kBlock handler only loses its own messages
+TEST_P(SocketBridgeTest, FullHandlerDoesNotStallBridge)
+{
+    struct Blocked {
+        void Post(Message&& message)
+        {
+            gate.wait();
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_future<void> gate;
+    };
+
+    struct Counter {
+        void Post(Message&& message)
+        {
+            count->fetch_add(1, std::memory_order_release);
+            MessagePool::Release(std::move(message));
+        }
+
+        std::shared_ptr<std::atomic<std::uint32_t>> count;
+    };
+
+    constexpr std::uint32_t kCount { 100 };
+
+    auto& router = MessageRouter::GetInstance();
+    const Endpoint blocked { "socket_bridge_test/blocked" };
+    const Endpoint counted { "socket_bridge_test/counted" };
+    std::promise<void> gate;
+    auto count = std::make_shared<std::atomic<std::uint32_t>>(0);
+
+    router.Register(blocked, Blocked { gate.get_future().share() }, MessageRouter::Delivery::kOrdered, { 1, MessageRouter::Overflow::kBlock });
+    router.Register(counted, Counter { count });
+
+    SocketBridge server;
+    SocketBridge client { Collector { std::make_shared<Collector::State>() } };
+
+    ASSERT_TRUE(Listen(server));
+
+    auto sender = Connect(client);
+    ASSERT_TRUE(sender);
+
+    for (std::uint32_t seq = 0; seq < kCount; ++seq) {
+        auto message = MakeMessage(seq);
+        message.to = blocked;
+        sender->Post(std::move(message));
+
+        message = MakeMessage(seq);
+        message.to = counted;
+        sender->Post(std::move(message));
+    }
+
+    EXPECT_TRUE(WaitFor(10s, [&count] { return count->load(std::memory_order_acquire) == kCount; }));
+    EXPECT_GT(server.GetDropCount(), 0u);
+
+    gate.set_value();
+
+    router.Unregister(blocked);
+    router.Unregister(counted);
+}
+
+INSTANTIATE_TEST_SUITE_P(Transports, SocketBridgeTest, testing::Values(Transport::kUnix, Transport::kTcp),
+    [](const testing::TestParamInfo<Transport>& info) { return info.param == Transport::kTcp ? "Tcp" : "Unix"; });
+
+} // namespace
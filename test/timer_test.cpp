@@ -0,0 +1,156 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "message_pool.h"
+#include "message_router.h"
+#include "timer.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Timers are created here instead of through GetInstance(), so each test picks its own resolution
+class TimerTest : public testing::Test {
+protected:
+    static void SetUpTestSuite() { MessageRouter::SetWorkerCount(4); }
+
+    // Resolution is read once by the constructor
+    static std::unique_ptr<Timer> MakeTimer(std::chrono::nanoseconds resolution)
+    {
+        Timer::SetResolution(resolution);
+        auto timer = std::make_unique<Timer>();
+        Timer::SetResolution(Timer::kDefaultResolution);
+
+        return timer;
+    }
+};
+
+// Counts messages and keeps the arrival time of the first one
+struct Counter {
+    struct State {
+        std::atomic<std::size_t> count { 0 };
+        std::atomic<std::chrono::steady_clock::rep> first { 0 };
+    };
+
+    void Post(Message&& message)
+    {
+        std::chrono::steady_clock::rep expected = 0;
+        state->first.compare_exchange_strong(expected, std::chrono::steady_clock::now().time_since_epoch().count());
+
+        state->count.fetch_add(1, std::memory_order_release);
+        MessagePool::Release(std::move(message));
+    }
+
+    std::shared_ptr<State> state;
+};
+
+std::shared_ptr<Counter::State> RegisterCounter(Endpoint endpoint)
+{
+    auto state = std::make_shared<Counter::State>();
+    MessageRouter::GetInstance().Register(endpoint, Counter { state });
+
+    return state;
+}
+
+// Ticks follow the configured resolution, periods are whole ticks and never fire early
+TEST_F(TimerTest, ResolutionIsConfigurable)
+{
+    auto timer = MakeTimer(1ms);
+
+    EXPECT_EQ(timer->GetResolution(), 1ms);
+
+    const Endpoint endpoint { "timer_test/resolution" };
+    auto state = RegisterCounter(endpoint);
+
+    const auto begin = std::chrono::steady_clock::now();
+    const auto once = timer->RegisterOnce(endpoint, 1, 2500us);
+
+    while (state->count.load(std::memory_order_acquire) == 0 && std::chrono::steady_clock::now() - begin < 5s)
+        std::this_thread::sleep_for(100us);
+
+    ASSERT_EQ(state->count.load(), 1u);
+    EXPECT_GE(std::chrono::steady_clock::time_point { std::chrono::steady_clock::duration { state->first.load() } } - begin, 2500us);
+    EXPECT_FALSE(timer->IsActive(once));
+    EXPECT_FALSE(timer->Unregister(once));
+
+    // A period of 5 ticks fires at most once per 5ms
+    state->count = 0;
+
+    const auto periodic_begin = std::chrono::steady_clock::now();
+    const auto periodic = timer->Register(endpoint, 2, 5ms);
+
+    std::this_thread::sleep_for(200ms);
+
+    EXPECT_TRUE(timer->Unregister(periodic));
+
+    const auto elapsed = std::chrono::steady_clock::now() - periodic_begin;
+    const auto count = state->count.load();
+
+    EXPECT_GE(count, 5u);
+    EXPECT_LE(count, static_cast<std::size_t>(elapsed / 5ms));
+
+    MessageRouter::GetInstance().Unregister(endpoint);
+}
+
+TEST_F(TimerTest, JitterStats)
+{
+    auto timer = MakeTimer(1ms);
+
+    std::this_thread::sleep_for(100ms);
+
+    const auto stats = timer->GetStats();
+
+    EXPECT_GE(stats.ticks, 10u);
+    EXPECT_LE(stats.late_ticks, stats.ticks);
+    EXPECT_LE(stats.p50, stats.p99);
+    EXPECT_LE(stats.p99, stats.p999);
+    EXPECT_LE(stats.p999, stats.max);
+    EXPECT_LE(stats.mean, stats.max);
+
+    timer->ResetStats();
+
+    const auto reset = timer->GetStats();
+
+    EXPECT_LT(reset.ticks, stats.ticks);
+    EXPECT_LE(reset.late_ticks, reset.ticks);
+}
+
+// Unregistering by name cancels every schedule of the endpoint, or those of one message id
+TEST_F(TimerTest, UnregisterByName)
+{
+    auto timer = MakeTimer(1ms);
+
+    const Endpoint endpoint { "timer_test/by_name" };
+    const auto first = timer->Register(endpoint, 1, 1s);
+    const auto second = timer->Register(endpoint, 2, 1s);
+    const auto third = timer->Register(endpoint, 2, 1s);
+
+    timer->Unregister("timer_test/by_name", 2);
+
+    EXPECT_TRUE(timer->IsActive(first));
+    EXPECT_FALSE(timer->IsActive(second));
+    EXPECT_FALSE(timer->IsActive(third));
+
+    timer->Unregister(std::string { "timer_test/by_name" });
+
+    EXPECT_FALSE(timer->IsActive(first));
+
+    // Names nobody registered stay unknown
+    const std::string unknown { "timer_test/never_registered" };
+
+    timer->Unregister(unknown);
+    timer->Unregister(std::string_view { unknown }, 1);
+
+    EXPECT_FALSE(Endpoint::Find(unknown));
+}
+
+} // namespace
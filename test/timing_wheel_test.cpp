@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/timing_wheel.h"
+
+namespace {
+
+using Wheel = TimingWheel<int>;
+
+// (value, tick) of every expiry until the wheel is empty or limit ticks have passed
+std::vector<std::pair<int, std::uint64_t>> RunUntilEmpty(Wheel& wheel, std::uint64_t limit)
+{
+    std::vector<std::pair<int, std::uint64_t>> fired;
+
+    for (std::uint64_t i = 0; i < limit && wheel.GetSize() != 0; ++i) {
+        wheel.Tick([&wheel, &fired](Wheel::Handle, int value) -> std::uint64_t {
+            fired.emplace_back(value, wheel.GetTick());
+            return 0;
+        });
+    }
+
+    return fired;
+}
+
+void Advance(Wheel& wheel, std::uint64_t ticks)
+{
+    for (std::uint64_t i = 0; i < ticks; ++i)
+        wheel.Tick([](Wheel::Handle, int) -> std::uint64_t { return 0; });
+}
+
+// Delays on either side of each level's span, scheduled from a tick where no slot boundary is near and from one right before it
+TEST(TimingWheelTest, ExpiresOnTimeAcrossLevels)
+{
+    const std::vector<std::uint64_t> delays { 1, 2, 255, 256, 257, 511, 512, 65535, 65536, 65537, (1 << 24) - 1, 1 << 24, (1 << 24) + 1 };
+
+    for (const std::uint64_t start : { 0, 100, 255, 65535 }) {
+        Wheel wheel;
+        Advance(wheel, start);
+
+        for (std::size_t i = 0; i < std::size(delays); ++i)
+            wheel.Schedule(static_cast<int>(i), delays[i]);
+
+        const auto fired = RunUntilEmpty(wheel, (1 << 24) + 2);
+
+        ASSERT_EQ(std::size(fired), std::size(delays)) << start;
+
+        for (std::size_t i = 0; i < std::size(delays); ++i) {
+            EXPECT_EQ(fired[i].first, static_cast<int>(i)) << start;
+            EXPECT_EQ(fired[i].second, start + delays[i]) << start << " " << delays[i];
+        }
+    }
+}
+
+TEST(TimingWheelTest, ZeroDelayExpiresOnNextTick)
+{
+    Wheel wheel;
+    wheel.Schedule(1, 0);
+
+    EXPECT_EQ(RunUntilEmpty(wheel, 10), (std::vector<std::pair<int, std::uint64_t>> { { 1, 1 } }));
+}
+
+// Entries cancelled while still in an upper level and after being cascaded into level 0 never fire
+TEST(TimingWheelTest, CancelBeforeAndAfterCascade)
+{
+    Wheel wheel;
+
+    const auto before = wheel.Schedule(1, 70000);
+    const auto after = wheel.Schedule(2, 300);
+    const auto kept = wheel.Schedule(3, 300);
+
+    Advance(wheel, 10);
+
+    EXPECT_TRUE(wheel.Cancel(before));
+    EXPECT_FALSE(wheel.Cancel(before));
+    EXPECT_FALSE(wheel.IsActive(before));
+    EXPECT_EQ(wheel.GetSize(), 2u);
+
+    // Tick 256 moved both into level 0
+    Advance(wheel, 260);
+
+    EXPECT_TRUE(wheel.Cancel(after));
+    EXPECT_EQ(wheel.GetSize(), 1u);
+
+    EXPECT_EQ(RunUntilEmpty(wheel, 100000), (std::vector<std::pair<int, std::uint64_t>> { { 3, 300 } }));
+    EXPECT_FALSE(wheel.Cancel(kept));
+
+    // Reused nodes don't answer to stale handles
+    const auto reused = wheel.Schedule(4, 5);
+
+    EXPECT_FALSE(wheel.IsActive(before));
+    EXPECT_FALSE(wheel.IsActive(after));
+    EXPECT_FALSE(wheel.IsActive(kept));
+    EXPECT_EQ(wheel.Find(after), nullptr);
+    ASSERT_NE(wheel.Find(reused), nullptr);
+    EXPECT_EQ(*wheel.Find(reused), 4);
+}
+
+// A periodic entry keeps its handle, across level boundaries too, until its callback returns 0
+TEST(TimingWheelTest, PeriodicReschedule)
+{
+    Wheel wheel;
+    const auto handle = wheel.Schedule(1, 200);
+    const auto other = wheel.Schedule(2, 5000);
+
+    std::vector<std::uint64_t> ticks;
+
+    for (int i = 0; i < 1000 && wheel.GetSize() != 0; ++i) {
+        wheel.Tick([&wheel, &ticks, handle](Wheel::Handle expired, int value) -> std::uint64_t {
+            if (value != 1)
+                return 0;
+
+            EXPECT_EQ(expired, handle);
+            ticks.push_back(wheel.GetTick());
+
+            return std::size(ticks) < 4 ? 100 : 0;
+        });
+
+        if (wheel.GetTick() == 350)
+            EXPECT_TRUE(wheel.IsActive(handle));
+    }
+
+    EXPECT_EQ(ticks, (std::vector<std::uint64_t> { 200, 300, 400, 500 }));
+    EXPECT_FALSE(wheel.IsActive(handle));
+    EXPECT_TRUE(wheel.IsActive(other));
+
+    // Rescheduled from level 0 into an upper level
+    Wheel longer;
+    const auto growing = longer.Schedule(1, 10);
+    std::vector<std::uint64_t> longer_ticks;
+
+    while (std::size(longer_ticks) < 3) {
+        longer.Tick([&longer, &longer_ticks](Wheel::Handle, int) -> std::uint64_t {
+            longer_ticks.push_back(longer.GetTick());
+            return 70000;
+        });
+    }
+
+    EXPECT_EQ(longer_ticks, (std::vector<std::uint64_t> { 10, 70010, 140010 }));
+    EXPECT_TRUE(longer.Cancel(growing));
+    EXPECT_EQ(longer.GetSize(), 0u);
+}
+
+} // namespace
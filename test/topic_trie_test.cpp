@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/topic_trie.h"
+
+namespace {
+
+// Values matched by topic, sorted so the order of patterns doesn't matter
+std::vector<int> Match(const TopicTrie<int>& trie, std::string_view topic)
+{
+    std::vector<int> values;
+    trie.Match(topic, [&values](int value) { values.push_back(value); });
+
+    std::sort(std::begin(values), std::end(values));
+
+    return values;
+}
+
+TEST(TopicTrieTest, ExactLevelsMatchOnlyThemselves)
+{
+    TopicTrie<int> trie;
+    trie.Insert("a/b", 1);
+    trie.Insert("a", 2);
+    trie.Insert("a/b/c", 3);
+
+    EXPECT_EQ(Match(trie, "a/b"), (std::vector<int> { 1 }));
+    EXPECT_EQ(Match(trie, "a"), (std::vector<int> { 2 }));
+    EXPECT_EQ(Match(trie, "a/b/c"), (std::vector<int> { 3 }));
+    EXPECT_TRUE(Match(trie, "a/c").empty());
+    EXPECT_TRUE(Match(trie, "b").empty());
+    EXPECT_TRUE(Match(trie, "a/b/c/d").empty());
+}
+
+TEST(TopicTrieTest, SingleLevelMatchesExactlyOneLevel)
+{
+    TopicTrie<int> trie;
+    trie.Insert("a/+/c", 1);
+    trie.Insert("+", 2);
+    trie.Insert("+/+", 3);
+
+    EXPECT_EQ(Match(trie, "a/b/c"), (std::vector<int> { 1 }));
+    EXPECT_EQ(Match(trie, "a/x/c"), (std::vector<int> { 1 }));
+    EXPECT_EQ(Match(trie, "a/c"), (std::vector<int> { 3 }));
+    EXPECT_TRUE(Match(trie, "a/b/x/c").empty());
+    EXPECT_EQ(Match(trie, "a"), (std::vector<int> { 2 }));
+
+    // Empty levels are levels too
+    EXPECT_EQ(Match(trie, "a//c"), (std::vector<int> { 1 }));
+}
+
+TEST(TopicTrieTest, MultiLevelMatchesTheRestNoneIncluded)
+{
+    TopicTrie<int> trie;
+    trie.Insert("a/#", 1);
+    trie.Insert("#", 2);
+    trie.Insert("a/+/#", 3);
+
+    EXPECT_EQ(Match(trie, "a"), (std::vector<int> { 1, 2 }));
+    EXPECT_EQ(Match(trie, "a/b"), (std::vector<int> { 1, 2, 3 }));
+    EXPECT_EQ(Match(trie, "a/b/c/d"), (std::vector<int> { 1, 2, 3 }));
+    EXPECT_EQ(Match(trie, "b/c"), (std::vector<int> { 2 }));
+}
+
+// A topic level of '+' or '#' is a plain level, only patterns use wildcards
+TEST(TopicTrieTest, WildcardsInTopicAreLiteral)
+{
+    TopicTrie<int> trie;
+    trie.Insert("a/b", 1);
+    trie.Insert("a/+", 2);
+
+    EXPECT_EQ(Match(trie, "a/+"), (std::vector<int> { 2 }));
+    EXPECT_TRUE(Match(trie, "a/#").empty());
+}
+
+// The trie reports each matching pattern, MessageRouter::Publish deduplicates
+TEST(TopicTrieTest, ValueIsMatchedOncePerPattern)
+{
+    TopicTrie<int> trie;
+
+    EXPECT_TRUE(trie.Insert("a/b", 1));
+    EXPECT_TRUE(trie.Insert("a/+", 1));
+    EXPECT_TRUE(trie.Insert("#", 1));
+    EXPECT_FALSE(trie.Insert("a/b", 1));
+    EXPECT_EQ(trie.GetSize(), 3u);
+
+    EXPECT_EQ(Match(trie, "a/b"), (std::vector<int> { 1, 1, 1 }));
+}
+
+TEST(TopicTrieTest, EraseRemovesOnlyThatSubscription)
+{
+    TopicTrie<int> trie;
+    trie.Insert("a/b/c", 1);
+    trie.Insert("a/b/c", 2);
+    trie.Insert("a/b", 3);
+
+    EXPECT_FALSE(trie.Erase("a/b/c", 3));
+    EXPECT_FALSE(trie.Erase("a/b/x", 1));
+    EXPECT_FALSE(trie.Erase("a", 3));
+
+    EXPECT_TRUE(trie.Erase("a/b/c", 1));
+    EXPECT_EQ(trie.GetSize(), 2u);
+    EXPECT_EQ(Match(trie, "a/b/c"), (std::vector<int> { 2 }));
+    EXPECT_EQ(Match(trie, "a/b"), (std::vector<int> { 3 }));
+
+    EXPECT_TRUE(trie.Erase("a/b/c", 2));
+    EXPECT_TRUE(trie.Erase("a/b", 3));
+    EXPECT_EQ(trie.GetSize(), 0u);
+    EXPECT_TRUE(Match(trie, "a/b/c").empty());
+
+    // Pruned nodes come back on insert
+    EXPECT_TRUE(trie.Insert("a/b/c", 1));
+    EXPECT_EQ(Match(trie, "a/b/c"), (std::vector<int> { 1 }));
+}
+
+} // namespace